@@ -0,0 +1,364 @@
+/**
+ * @file Benchmark.cpp
+ * @brief Microbenchmarks for the lexer, parser, evaluator and batch pipeline
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This file builds the calculator_bench executable. Each benchmark repeats one operation
+ * until it has run for a minimum amount of time and reports the average time per
+ * operation, so results are comparable across machines of similar speed and across
+ * commits on the same machine. Pass a substring to run only the matching benchmarks, or
+ * --accuracy to check the fast math kernels against the precise functions instead.
+ */
+
+#include "Batch.h"
+#include "Bytecode.h"
+#include "Calculator.h"
+#include "Expression.h"
+#include "FastMath.h"
+#include "FlatTree.h"
+#include "Formula.h"
+#include "Jit.h"
+#include "Lexicography.h"
+#include "Node.h"
+#include "NodeArena.h"
+#include "Optimizer.h"
+#include "Parser.h"
+#include "Session.h"
+#include "SymbolTable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Each benchmark runs for at least this long
+constexpr std::chrono::milliseconds MIN_DURATION(200);
+
+// Sink for benchmark results so the compiler cannot drop the work that produced them
+volatile long double sink;
+
+/**
+ * @struct Case
+ * @brief One microbenchmark
+ */
+struct Case {
+    std::string name;                                ///< Name printed in the report
+    std::function<void()> body;                      ///< Operation to time
+    std::size_t unitsPerOp = 1;                      ///< Items processed per call, for the throughput column
+    const char* unit = nullptr;                      ///< Name of the items, or nullptr for no throughput column
+};
+
+// Doubles the repetition count until one batch takes long enough, then reports the mean
+void run(const Case& bench) {
+    bench.body(); // warm caches and the allocator
+    std::size_t iterations = 1;
+    while (true) {
+        const Clock::time_point start = Clock::now();
+        for (std::size_t i = 0; i < iterations; ++i) { bench.body(); }
+        const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+        if (elapsed >= MIN_DURATION) {
+            const double perOp = elapsed.count() / static_cast<double>(iterations);
+            std::printf("%-36s %14.1f ns/op", bench.name.c_str(), perOp);
+            if (bench.unit) {
+                std::printf("  %12.0f %s/s", 1e9 * static_cast<double>(bench.unitsPerOp) / perOp, bench.unit);
+            }
+            std::printf("\n");
+            return;
+        }
+        iterations *= 2;
+    }
+}
+
+// ((x ^ 1.0001) ^ 1.0001) ... nested depth times
+std::string powerChain(const std::size_t depth) {
+    std::string text = "x";
+    for (std::size_t i = 0; i < depth; ++i) { text = "(" + text + " ^ 1.0001)"; }
+    return text;
+}
+
+// 1 + x + 2 + x + ... with the given number of terms
+std::string wideSum(const std::size_t terms) {
+    std::string text = "1";
+    for (std::size_t i = 1; i < terms; ++i) { text += i % 2 ? " + x" : " + " + std::to_string(i); }
+    return text;
+}
+
+// Representative expression shapes, evaluated with x = 0.5
+const std::vector<std::pair<std::string, std::string>>& expressions() {
+    static const std::vector<std::pair<std::string, std::string>> list = {
+        {"simple", "3 * x + 2"},
+        {"power chain 64", powerChain(64)},
+        {"wide sum 256", wideSum(256)},
+        {"trig/log", "sin(x) * cos(x) + tan(x / 2) + ln(x + 1) + sqrt(x + 2) + log(x + 3, 2) + atan(x) + exp(x)"},
+        {"factorial", "(x + 19.5)! + 10! / 5!"},
+        {"repeated subtrees", "sin(x * 3)^2 + cos(x * 3)^2 + sin(x * 3) * cos(x * 3) / sqrt(x * 3)"},
+        {"polynomial", "3 * x^4 + 2 * x^3 - x^2 + 7 * x + 1"},
+    };
+    return list;
+}
+
+// Parses text into a heap-allocated tree
+std::unique_ptr<Node> parseText(const std::string& text) {
+    Parser parser(tokenize(text));
+    return parser.parse();
+}
+
+// Lines mixing assignments, repeated and distinct expressions
+std::string corpus(const std::size_t lines) {
+    std::string text = "x = 0.5\n";
+    for (std::size_t i = 0; i < lines; ++i) {
+        switch (i % 4) {
+            case 0: text += "x = " + std::to_string(i % 100) + " / 7\n"; break;
+            case 1: text += "sin(x) * 2 + 3^2\n"; break;
+            case 2: text += "sqrt(x + " + std::to_string(i) + ") * ln(x + 2)\n"; break;
+            default: text += "|x - 4| * (x + 1)! / 3\n"; break;
+        }
+    }
+    return text;
+}
+
+// Times one engine over a column of rows
+template <typename Scalar>
+void addBatchCase(std::vector<Case>& list, const std::string& name, const std::shared_ptr<Program>& program) {
+    constexpr std::size_t rows = 4096;
+    auto xs = std::make_shared<std::vector<Scalar>>(rows);
+    for (std::size_t i = 0; i < rows; ++i) { (*xs)[i] = static_cast<Scalar>(i) / rows; }
+    auto output = std::make_shared<std::vector<Scalar>>(rows);
+    list.push_back({name, [program, xs, output] {
+        program->runBatch<Scalar>({{xs->data(), 1}}, rows, output->data());
+        sink = output->back();
+    }, rows, "rows"});
+}
+
+/**
+ * @struct AccuracyCase
+ * @brief A function whose fast kernel is checked, and where
+ */
+struct AccuracyCase {
+    std::string text;      ///< Expression of x
+    double bound;          ///< Largest relative error allowed
+    long double (*slope)(long double value); ///< |f'| in terms of f, which scales the argument's rounding, or none
+    long double from;      ///< Start of the range of x
+    long double to;        ///< End of the range of x
+    bool logarithmic;      ///< Whether the points are spaced evenly in log x instead of x
+};
+
+// Slopes of sin and cos are at most 1, and tan's is 1 + tan^2
+long double unitSlope(long double) { return 1; }
+long double tanSlope(const long double value) { return 1 + value * value; }
+
+// Runs each expression over its range through the precise and the fast batch evaluator and compares them
+bool checkAccuracy() {
+    constexpr std::size_t points = 1 << 20;
+    const std::vector<AccuracyCase> list = {
+        {"sin(x)", fastmath::TRIG_ERROR, unitSlope, -10, 10, false},
+        {"sin(x)", fastmath::TRIG_ERROR, unitSlope, -fastmath::TRIG_LIMIT, fastmath::TRIG_LIMIT, false},
+        {"cos(x)", fastmath::TRIG_ERROR, unitSlope, -10, 10, false},
+        {"cos(x)", fastmath::TRIG_ERROR, unitSlope, -fastmath::TRIG_LIMIT, fastmath::TRIG_LIMIT, false},
+        {"tan(x)", fastmath::TAN_ERROR, tanSlope, -10, 10, false},
+        {"tan(x)", fastmath::TAN_ERROR, tanSlope, -fastmath::TRIG_LIMIT, fastmath::TRIG_LIMIT, false},
+        {"exp(x)", fastmath::EXP_ERROR, nullptr, -1, 1, false},
+        {"exp(x)", fastmath::EXP_ERROR, nullptr, -fastmath::EXP_LIMIT, fastmath::EXP_LIMIT, false},
+        {"ln(x)", fastmath::LN_ERROR, nullptr, 0.5L, 2, false},
+        {"ln(x)", fastmath::LN_ERROR, nullptr, 1e-300L, 1e300L, true},
+        {"log10(x)", fastmath::LN_ERROR, nullptr, 1e-300L, 1e300L, true},
+        {"log(x, 3)", fastmath::LN_ERROR, nullptr, 1e-300L, 1e300L, true},
+    };
+
+    bool passed = true;
+    std::vector<long double> xs(points);
+    std::vector<long double> precise(points);
+    std::vector<long double> fast(points);
+    for (const AccuracyCase& test : list) {
+        for (std::size_t i = 0; i < points; ++i) {
+            const long double t = static_cast<long double>(i) / (points - 1);
+            xs[i] = test.logarithmic ? std::exp(std::log(test.from) + t * (std::log(test.to) - std::log(test.from)))
+                                     : test.from + t * (test.to - test.from);
+        }
+        const Program exact = Compiler::compile(*parseText(test.text));
+        Program approximate = exact;
+        approximate.useFastMath();
+        exact.runBatch<long double>({{xs.data(), 1}}, points, precise.data());
+        approximate.runBatch<long double>({{xs.data(), 1}}, points, fast.data());
+
+        double worst = 0;
+        for (std::size_t i = 0; i < points; ++i) {
+            // Rounding x to double moves the result by up to the slope times ARGUMENT_ROUNDING |x|, which is allowed on top
+            const long double slack = test.slope ? test.slope(precise[i]) * std::abs(xs[i]) * fastmath::ARGUMENT_ROUNDING / test.bound : 0;
+            worst = std::max(worst, static_cast<double>(std::abs(fast[i] - precise[i]) / (std::abs(precise[i]) + slack)));
+        }
+        const bool ok = worst <= test.bound;
+        passed = passed && ok;
+        std::printf("%-10s x in [%Lg, %Lg]  max error %9.3g  bound %7.1g  %s\n", test.text.c_str(), test.from, test.to, worst,
+                    test.bound, ok ? "ok" : "FAILED");
+    }
+    return passed;
+}
+
+// Builds every benchmark case
+std::vector<Case> cases() {
+    std::vector<Case> list;
+    SymbolTable variables;
+    variables.set(SymbolTable::intern("x"), 0.5L);
+
+    for (const auto& [label, text] : expressions()) {
+        list.push_back({"tokenize/" + label, [text = text] {
+            sink = static_cast<long double>(tokenize(text).size());
+        }});
+    }
+
+    for (const auto& [label, text] : expressions()) {
+        const std::vector<Token> tokens = tokenize(text);
+        list.push_back({"parse/" + label, [tokens] {
+            Parser parser(tokens);
+            sink = parser.parse() != nullptr;
+        }});
+        auto arena = std::make_shared<NodeArena>();
+        list.push_back({"parse arena/" + label, [tokens, arena] {
+            {
+                Parser parser(tokens, arena.get());
+                sink = parser.parse() != nullptr;
+            }
+            arena->reset();
+        }});
+        auto flat = std::make_shared<FlatTree>();
+        list.push_back({"parse flat/" + label, [tokens, flat] {
+            Parser parser(tokens);
+            parser.parse(*flat);
+            sink = static_cast<long double>(flat->size());
+        }});
+    }
+
+    for (const auto& [label, text] : expressions()) {
+        auto expression = std::make_shared<Expression>(Expression::compile(text));
+        expression->set("x", 0.5L);
+        list.push_back({"evaluate embedded/" + label, [expression] {
+            long double result;
+            sink = expression->evaluate(result) == EvalStatus::OK ? result : 0;
+        }});
+    }
+
+    {
+        // The same formulas as "simple" and "trig/log", written with the compile-time front end
+        using namespace formula;
+        constexpr auto x = var<0>;
+        const auto input = std::make_shared<long double>(0.5L); // read through a pointer so nothing folds
+        list.push_back({"evaluate static/simple", [input, f = 3 * x + 2] { sink = f(*input); }});
+        const auto trig = sin(x) * cos(x) + tan(x / 2) + ln(x + 1) + sqrt(x + 2) + log(x + 3, 2) + atan(x) + exp(x);
+        list.push_back({"evaluate static/trig/log", [input, trig] { sink = trig(*input); }});
+    }
+
+    for (const auto& [label, text] : expressions()) {
+        const std::shared_ptr<Node> tree = parseText(text);
+        list.push_back({"evaluate tree/" + label, [tree, variables] {
+            sink = tree->evaluate(variables);
+        }});
+        auto flat = std::make_shared<FlatTree>();
+        Parser(tokenize(text)).parse(*flat);
+        list.push_back({"evaluate flat/" + label, [flat, variables] {
+            sink = flat->evaluate(variables);
+        }});
+        const auto program = std::make_shared<Program>(Compiler::compile(*tree));
+        const std::vector<long double> slots = program->bind(variables);
+        list.push_back({"evaluate program/" + label, [program, slots] {
+            long double result;
+            sink = program->interpret(slots.data(), result) == EvalStatus::OK ? result : 0;
+        }});
+        if (std::shared_ptr<const NativeProgram> native = NativeProgram::compile<long double>(*program)) {
+            list.push_back({"evaluate native/" + label, [native, slots] {
+                long double result;
+                sink = native->run(slots.data(), result) == EvalStatus::OK ? result : 0;
+            }});
+        }
+        if (std::shared_ptr<const NativeProgram> native = NativeProgram::compile<double>(*program)) {
+            const std::vector<double> narrowed(slots.begin(), slots.end());
+            list.push_back({"evaluate native double/" + label, [native, narrowed] {
+                double result;
+                sink = native->run(narrowed.data(), result) == EvalStatus::OK ? result : 0;
+            }});
+        }
+    }
+
+    {
+        const auto program = std::make_shared<Program>(Compiler::compile(*parseText(expressions()[3].second)));
+        addBatchCase<long double>(list, "evaluate batch long/trig/log", program);
+        addBatchCase<double>(list, "evaluate batch double/trig/log", program);
+        addBatchCase<float>(list, "evaluate batch float/trig/log", program);
+        const auto fast = std::make_shared<Program>(*program);
+        fast->useFastMath();
+        addBatchCase<long double>(list, "evaluate batch fast long/trig/log", fast);
+        addBatchCase<double>(list, "evaluate batch fast double/trig/log", fast);
+        addBatchCase<float>(list, "evaluate batch fast float/trig/log", fast);
+    }
+
+    {
+        // The polynomial as written, and rewritten in Horner form by the optimizer
+        const std::string& text = expressions()[6].second;
+        const auto written = std::make_shared<Program>(Compiler::compile(*parseText(text)));
+        const auto horner = std::make_shared<Program>(Compiler::compile(*optimize(parseText(text), SymbolTable())));
+        const std::vector<long double> slots = horner->bind(variables);
+        list.push_back({"evaluate program horner/polynomial", [horner, slots] {
+            long double result;
+            sink = horner->interpret(slots.data(), result) == EvalStatus::OK ? result : 0;
+        }});
+        addBatchCase<double>(list, "evaluate batch double/polynomial", written);
+        addBatchCase<double>(list, "evaluate batch double horner/polynomial", horner);
+    }
+
+    {
+        auto calc = std::make_shared<Calculator>();
+        std::vector<std::string> names;
+        for (int i = 0; i < 64; ++i) { names.push_back("v" + std::to_string(i)); }
+        list.push_back({"calculator/assign 64 + clear", [calc, names] {
+            for (std::size_t i = 0; i < names.size(); ++i) { calc->assign(names[i], static_cast<long double>(i)); }
+            calc->clear();
+        }, names.size(), "assigns"});
+        list.push_back({"calculator/reassign", [calc] {
+            calc->assign("x", 1.5L);
+        }});
+    }
+
+    {
+        constexpr std::size_t lines = 4096;
+        const std::string text = corpus(lines);
+        list.push_back({"end to end/batch", [text] {
+            Session session;
+            std::istringstream input(text);
+            std::ostringstream output;
+            runBatch(session, input, output);
+            sink = static_cast<long double>(output.tellp());
+        }, lines + 1, "lines"});
+        list.push_back({"end to end/uncached batch", [text] {
+            Session session(0);
+            std::istringstream input(text);
+            std::ostringstream output;
+            runBatch(session, input, output);
+            sink = static_cast<long double>(output.tellp());
+        }, lines + 1, "lines"});
+    }
+
+    return list;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const std::string_view filter = argc > 1 ? argv[1] : "";
+    if (filter == "--accuracy") { return checkAccuracy() ? 0 : 1; }
+    for (const Case& bench : cases()) {
+        if (bench.name.find(filter) != std::string::npos) { run(bench); }
+    }
+    return 0;
+}
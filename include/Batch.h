@@ -0,0 +1,42 @@
+/**
+ * @file Batch.h
+ * @brief Non-interactive processing of many input lines
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header declares runBatch, the driver behind the calculator's batch mode. It reads
+ * expressions from a stream in large chunks, runs each line through a Session and writes
+ * the results through a buffer without flushing after every line. There is no prompt or
+ * banner, and an error on one line is reported and processing moves on to the next.
+ * runParallelBatch additionally spreads runs of independent expressions over a thread pool.
+ */
+
+#pragma once
+
+#include "Session.h"
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+
+/**
+ * @brief Processes every line of a stream through a session
+ * @param session The session to run the lines in
+ * @param input Stream to read lines from, until end of input or an exit command
+ * @param output Stream the results are written to in large blocks
+ */
+void runBatch(Session& session, std::istream& input, std::ostream& output);
+
+/**
+ * @brief Processes every line of a stream, evaluating independent expressions in parallel
+ * @param session The session to run the lines in
+ * @param input Stream to read lines from, until end of input or an exit command
+ * @param output Stream the results are written to, in input order
+ * @param threads Number of threads to use, 0 for one per hardware thread
+ * @details Expressions between two state-changing lines (assignments and commands) only read
+ * the session's calculator, so they are evaluated concurrently by per-thread sessions. The
+ * state-changing lines themselves, and the lines of fused blocks, run on the calling thread in
+ * order, acting as barriers.
+ * The output is identical to runBatch().
+ */
+void runParallelBatch(Session& session, std::istream& input, std::ostream& output, std::size_t threads);
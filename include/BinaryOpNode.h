@@ -12,10 +12,12 @@
 #pragma once
 
 #include "Node.h"
+#include "Bytecode.h"
+#include "Optimizer.h"
 
 #include <cmath>
+#include <cstdint>
 #include <memory>
-#include <map>
 #include <stdexcept>
 #include <string>
 
@@ -43,10 +45,10 @@ public:
 
     /**
      * @brief Evaluate the addition operation
-     * @param variables std::map of variable names to values
+     * @param variables Table of variable values
      * @return Sum of left and right nodes
      */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
+    long double evaluate(const SymbolTable& variables) const override {
         return child1->evaluate(variables) + child2->evaluate(variables);
     }
 
@@ -57,6 +59,51 @@ public:
     Node* clone() const override {
         return new AddNode(std::unique_ptr<Node>(child1->clone()), std::unique_ptr<Node>(child2->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the sum
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        const std::uint32_t left = child1->compile(compiler);
+        const std::uint32_t right = child2->compile(compiler);
+        return compiler.emit(OpCode::ADD, left, right);
+    }
+
+    /**
+     * @brief Simplifies the operands, folds constants, drops additions of zero and rewrites polynomials in Horner form
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(child1, constants);
+        simplifyChild(child2, constants);
+        if (std::unique_ptr<Node> folded = foldConstant(*this, {child1.get(), child2.get()})) { return folded; }
+        if (isNumber(*child2, 0)) { return std::move(child1); } // x + 0
+        if (isNumber(*child1, 0)) { return std::move(child2); } // 0 + x
+        return hornerForm(*this);
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return The sum of the derivatives of the operands
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
+
+    /**
+     * @brief Reads the node as a polynomial
+     * @param out Set to the polynomial
+     * @return true if both operands are polynomials in the same variable
+     */
+    bool polynomial(Polynomial& out) const override;
+
+    /**
+     * @brief Lists the terms of the left operand, then the right operand
+     * @param terms Receives the terms
+     */
+    void sumTerms(std::vector<SumTerm>& terms) const override;
 };
 
 /**
@@ -84,10 +131,10 @@ public:
 
     /**
      * @brief Evaluate the subtraction operation
-     * @param variables std::map of variable names to values
+     * @param variables Table of variable values
      * @return Difference of left and right nodes
      */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
+    long double evaluate(const SymbolTable& variables) const override {
         return child1->evaluate(variables) - child2->evaluate(variables);
     }
 
@@ -98,6 +145,50 @@ public:
     Node* clone() const override {
         return new SubtractNode(std::unique_ptr<Node>(child1->clone()), std::unique_ptr<Node>(child2->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the difference
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        const std::uint32_t left = child1->compile(compiler);
+        const std::uint32_t right = child2->compile(compiler);
+        return compiler.emit(OpCode::SUBTRACT, left, right);
+    }
+
+    /**
+     * @brief Simplifies the operands, folds constants and drops subtractions of zero and rewrites polynomials in Horner form
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(child1, constants);
+        simplifyChild(child2, constants);
+        if (std::unique_ptr<Node> folded = foldConstant(*this, {child1.get(), child2.get()})) { return folded; }
+        if (isNumber(*child2, 0)) { return std::move(child1); } // x - 0
+        return hornerForm(*this);
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return The difference of the derivatives of the operands
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
+
+    /**
+     * @brief Reads the node as a polynomial
+     * @param out Set to the polynomial
+     * @return true if both operands are polynomials in the same variable
+     */
+    bool polynomial(Polynomial& out) const override;
+
+    /**
+     * @brief Lists the terms of the left operand, then the right operand as a subtracted term
+     * @param terms Receives the terms
+     */
+    void sumTerms(std::vector<SumTerm>& terms) const override;
 };
 
 /**
@@ -123,10 +214,10 @@ public:
 
     /**
      * @brief Evaluate the multiplication operation
-     * @param variables std::map of variable names to values
+     * @param variables Table of variable values
      * @return Product of left and right nodes
      */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
+    long double evaluate(const SymbolTable& variables) const override {
         return child1->evaluate(variables) * child2->evaluate(variables);
     }
 
@@ -137,6 +228,45 @@ public:
     Node* clone() const override {
         return new MultiplyNode(std::unique_ptr<Node>(child1->clone()), std::unique_ptr<Node>(child2->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the product
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        const std::uint32_t left = child1->compile(compiler);
+        const std::uint32_t right = child2->compile(compiler);
+        return compiler.emit(OpCode::MULTIPLY, left, right);
+    }
+
+    /**
+     * @brief Simplifies the operands, folds constants and drops multiplications by one
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(child1, constants);
+        simplifyChild(child2, constants);
+        if (std::unique_ptr<Node> folded = foldConstant(*this, {child1.get(), child2.get()})) { return folded; }
+        if (isNumber(*child2, 1)) { return std::move(child1); } // x * 1
+        if (isNumber(*child1, 1)) { return std::move(child2); } // 1 * x
+        return nullptr;
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return The derivative by the product rule
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
+
+    /**
+     * @brief Reads the node as a polynomial
+     * @param out Set to the polynomial
+     * @return true if both operands are polynomials in the same variable and one of them has a single term
+     */
+    bool polynomial(Polynomial& out) const override;
 };
 
 /**
@@ -162,11 +292,11 @@ public:
 
 	/**
 	* @brief Evaluate the division operation
-	* @param variables std::map of variable names to values
+	* @param variables Table of variable values
 	* @return Quotient of numerator and denominator nodes
 	* @throws runtime_error if division by zero occurs
     */ 
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
+    long double evaluate(const SymbolTable& variables) const override {
         long double denom = denominator->evaluate(variables);
         if (denom == 0) {
             throw std::runtime_error("division by zero");
@@ -181,6 +311,37 @@ public:
     Node* clone() const override {
         return new DivideNode(std::unique_ptr<Node>(numerator->clone()), std::unique_ptr<Node>(denominator->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the quotient
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        const std::uint32_t denominatorRegister = denominator->compile(compiler);
+        const std::uint32_t numeratorRegister = numerator->compile(compiler);
+        return compiler.emit(OpCode::DIVIDE, numeratorRegister, denominatorRegister);
+    }
+
+    /**
+     * @brief Simplifies the operands, folds constants and drops divisions by one
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(denominator, constants);
+        simplifyChild(numerator, constants);
+        if (std::unique_ptr<Node> folded = foldConstant(*this, {denominator.get(), numerator.get()})) { return folded; }
+        if (isNumber(*denominator, 1)) { return std::move(numerator); } // x / 1
+        return nullptr;
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return The derivative by the quotient rule
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
 };
 
 /**
@@ -206,15 +367,17 @@ public:
 
     /**
      * @brief Evaluate the power operation
-     * @param variables std::map of variable names to values
+     * @param variables Table of variable values
      * @return Result of raising the base to the exponent
 	 * @throws runtime_error if base is negative and exponent is non-integer
      */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
-        if (base->evaluate(variables) < 0 && exponent->evaluate(variables) != floor(exponent->evaluate(variables))) {
+    long double evaluate(const SymbolTable& variables) const override {
+        const long double baseValue = base->evaluate(variables);
+        const long double exponentValue = exponent->evaluate(variables);
+        if (baseValue < 0 && exponentValue != std::floor(exponentValue)) {
             throw std::runtime_error("negative base with non-integer exponent");
         }
-        return pow(base->evaluate(variables), exponent->evaluate(variables));
+        return std::pow(baseValue, exponentValue);
     }
 
     /**
@@ -224,4 +387,42 @@ public:
     Node* clone() const override {
         return new PowerNode(std::unique_ptr<Node>(base->clone()), std::unique_ptr<Node>(exponent->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the power
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        const std::uint32_t baseRegister = base->compile(compiler);
+        const std::uint32_t exponentRegister = exponent->compile(compiler);
+        return compiler.emit(OpCode::POWER, baseRegister, exponentRegister);
+    }
+
+    /**
+     * @brief Simplifies the operands, folds constants and drops powers of one
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(base, constants);
+        simplifyChild(exponent, constants);
+        if (std::unique_ptr<Node> folded = foldConstant(*this, {base.get(), exponent.get()})) { return folded; }
+        if (isNumber(*exponent, 1)) { return std::move(base); } // x ^ 1
+        return nullptr;
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return The derivative by the power rule for exponents that do not depend on the variable, through the logarithm of the base otherwise
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
+
+    /**
+     * @brief Reads the node as a polynomial
+     * @param out Set to the polynomial
+     * @return true if the base is a single term and the exponent a small non-negative integer
+     */
+    bool polynomial(Polynomial& out) const override;
 };
@@ -0,0 +1,546 @@
+/**
+ * @file Bytecode.h
+ * @brief Flat bytecode representation of parsed expressions
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header defines the instruction set, the compiled Program and the Compiler
+ * that lowers an AST into it. A Program is a linear list of instructions where the
+ * result of instruction i is stored in register i, so evaluation is a single loop
+ * over a contiguous array. Variables are resolved once at compile time to integer
+ * slots instead of being looked up by name on every visit. Programs can also be run
+ * over whole columns of inputs, one instruction at a time per block of rows, and
+ * several expressions can be compiled into one program with a result for each.
+ */
+
+#pragma once
+
+#include "SymbolTable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class FlatTree;
+class JitTier;
+class Node;
+struct Routine;
+
+/**
+ * @enum OpCode
+ * @brief Operations understood by the bytecode evaluator
+ *
+ * There is one opcode per AST node type, plus CONSTANT and LOAD which
+ * read from the constant pool and the variable slots respectively. SOLVE,
+ * INTEGRATE and SUM run a whole expression many times; their a operand
+ * indexes the program's routines, which hold the registers they read. The
+ * FAST_ opcodes replace their precise counterparts in programs switched to
+ * fast math, and compute the same functions with the kernels of FastMath.h.
+ */
+enum class OpCode : std::uint8_t {
+    CONSTANT,  ///< Register = constants[a]
+    LOAD,      ///< Register = slots[a]
+    ADD,       ///< Register = r[a] + r[b]
+    SUBTRACT,  ///< Register = r[a] - r[b]
+    MULTIPLY,  ///< Register = r[a] * r[b]
+    DIVIDE,    ///< Register = r[a] / r[b]
+    POWER,     ///< Register = r[a] ^ r[b]
+    NEGATE,    ///< Register = -r[a]
+    ABS,       ///< Register = |r[a]|
+    FACTORIAL, ///< Register = r[a]!
+    SIN,       ///< Register = sin(r[a])
+    COS,       ///< Register = cos(r[a])
+    TAN,       ///< Register = tan(r[a])
+    ASIN,      ///< Register = asin(r[a])
+    ACOS,      ///< Register = acos(r[a])
+    ATAN,      ///< Register = atan(r[a])
+    EXP,       ///< Register = e^r[a]
+    LN,        ///< Register = ln(r[a])
+    LOGTEN,    ///< Register = log10(r[a])
+    LOG,       ///< Register = log(r[a]) / log(r[b])
+    SQRT,      ///< Register = sqrt(r[a])
+    SOLVE,     ///< Register = root of routines[a] found by Newton's method from its guess
+    INTEGRATE, ///< Register = integral of routines[a] between its bounds
+    SUM,       ///< Register = sum of routines[a] over the integers between its bounds
+    FAST_SIN,    ///< Register = fastmath::sin(r[a])
+    FAST_COS,    ///< Register = fastmath::cos(r[a])
+    FAST_TAN,    ///< Register = fastmath::tan(r[a])
+    FAST_EXP,    ///< Register = fastmath::exp(r[a])
+    FAST_LN,     ///< Register = fastmath::ln(r[a])
+    FAST_LOGTEN, ///< Register = fastmath::log10(r[a])
+    FAST_LOG     ///< Register = fastmath::ln(r[a]) / fastmath::ln(r[b])
+};
+
+/**
+ * @enum EvalStatus
+ * @brief Outcome of running a program
+ *
+ * The evaluators report domain errors as one of these instead of throwing, so callers
+ * on a hot path can check a value rather than unwind. statusMessage() gives the text
+ * that the throwing entry points put in their runtime_error.
+ */
+enum class EvalStatus : std::uint8_t {
+    OK,                     ///< The result is valid
+    DIVISION_BY_ZERO,       ///< A divisor was zero
+    NEGATIVE_BASE,          ///< A negative base was raised to a non-integer exponent
+    NEGATIVE_FACTORIAL,     ///< A factorial of a negative number was taken
+    NON_POSITIVE_LOGARITHM, ///< A logarithm of, or with a base of, zero or less was taken
+    LOGARITHM_BASE_ONE,     ///< A logarithm with base 1 was taken
+    NEGATIVE_SQUARE_ROOT,   ///< A square root of a negative number was taken
+    UNBOUND_VARIABLE,       ///< A variable was read before a value was bound to it
+    NO_ROOT,                ///< Newton's method did not converge to a root
+    NO_CONVERGENCE,         ///< An integral did not reach full precision
+    NON_INTEGER_BOUNDS,     ///< A sum's bounds were not integers
+    TOO_MANY_TERMS          ///< A sum had more than Routine::MAX_TERMS terms
+};
+
+/**
+ * @param status The status to describe
+ * @return The error message for the status, matching the one Node::evaluate throws
+ */
+const char* statusMessage(EvalStatus status);
+
+/**
+ * @struct Instruction
+ * @brief A single bytecode instruction
+ *
+ * Operands are register indices, except for CONSTANT and LOAD where
+ * a is an index into the constant pool or the slot array.
+ */
+struct Instruction {
+    OpCode op;       ///< Operation to perform
+    std::uint32_t a; ///< First operand
+    std::uint32_t b; ///< Second operand, unused by unary operations
+};
+
+/**
+ * @struct BasicSlotColumn
+ * @brief Input values for one slot in a batch evaluation
+ *
+ * Row k reads values[k * stride]. A stride of 1 is a regular column,
+ * a stride of 0 broadcasts a single value to every row.
+ */
+template <typename Scalar>
+struct BasicSlotColumn {
+    const Scalar* values; ///< First value of the column
+    std::size_t stride;   ///< Distance between consecutive rows
+};
+
+/**
+ * @brief Input column for the default long double engine
+ */
+using SlotColumn = BasicSlotColumn<long double>;
+
+/**
+ * @enum Precision
+ * @brief Floating-point type a program is evaluated in
+ *
+ * Programs always store their constants as long double. The narrower engines convert
+ * inputs and constants on the way in and results on the way out, and do all arithmetic
+ * in the narrower type, which vectorizes and runs the math library's faster routines.
+ */
+enum class Precision : std::uint8_t {
+    LONG_DOUBLE, ///< Extended precision, the default
+    DOUBLE,      ///< IEEE double precision
+    FLOAT        ///< IEEE single precision
+};
+
+#ifndef CALCULATOR_DEFAULT_PRECISION
+#define CALCULATOR_DEFAULT_PRECISION LONG_DOUBLE ///< Precision used unless another one is selected
+#endif
+
+/**
+ * @brief Precision new sessions evaluate in, set with the CALCULATOR_PRECISION CMake option
+ */
+constexpr Precision DEFAULT_PRECISION = Precision::CALCULATOR_DEFAULT_PRECISION;
+
+/**
+ * @param precision A precision
+ * @return Its name as accepted by parsePrecision()
+ */
+const char* precisionName(Precision precision);
+
+/**
+ * @brief Parses the name of a precision
+ * @param name "long", "double" or "float"
+ * @param precision Set to the matching precision
+ * @return false if the name is not recognized
+ */
+bool parsePrecision(const std::string& name, Precision& precision);
+
+/**
+ * @struct FusedLine
+ * @brief One expression of a program compiled from several
+ */
+struct FusedLine {
+    const Node* expression = nullptr; ///< Root of the expression
+    bool defines = false;             ///< Whether the expression's value is given a name
+    SymbolId variable = 0;            ///< The name, which the expressions after this one read from its register
+};
+
+/**
+ * @class Program
+ * @brief A compiled expression ready for repeated evaluation
+ *
+ * Holds the instruction stream, the constant pool and the symbols of the
+ * variable slots. A Program does not own any variable values; they are
+ * supplied per evaluation as a slot array, in the order given by slotName().
+ */
+class Program {
+private:
+    friend class Compiler;
+    friend class NativeProgram;
+    friend class Snapshot;
+    friend class Stats;
+    friend struct Routine;
+
+    std::vector<Instruction> instructions; ///< Instruction stream in evaluation order
+    std::vector<long double> constants;    ///< Constant pool referenced by CONSTANT
+    std::vector<SymbolId> slotSymbols;     ///< Variable read through each slot
+    std::uint32_t result = 0;              ///< Register holding the final value
+    std::vector<Routine> routines;         ///< Expressions run by SOLVE, INTEGRATE and SUM instructions
+    std::vector<std::uint32_t> outputRegisters; ///< Register holding each expression's value, for a fused program
+    std::shared_ptr<JitTier> tier;         ///< Evaluation counts and native code, shared by copies, null without a JIT
+
+    /**
+     * @brief Runs the instructions, leaving every register's value behind
+     * @tparam Scalar long double, double or float
+     * @param slots Variable values, indexed by slot
+     * @param r Registers, with room for size() values
+     * @return OK, or the first domain error encountered
+     */
+    template <typename Scalar>
+    EvalStatus execute(const Scalar* slots, Scalar* r) const;
+
+    /**
+     * @brief Evaluates the program in a narrower type and widens the result
+     * @tparam Scalar double or float
+     * @param slots Variable values, indexed by slot
+     * @return The value of the expression
+     * @throws runtime_error on domain errors
+     */
+    template <typename Scalar>
+    [[nodiscard]] long double evaluateAs(const std::vector<long double>& slots) const;
+
+    /**
+     * @brief Runs the instructions block by block over many rows and copies out chosen registers
+     * @tparam Scalar long double, double or float
+     * @param columns Input column for each slot, indexed by slot
+     * @param rows Number of rows to evaluate
+     * @param results Registers to copy out
+     * @param count Number of registers in results
+     * @param outputs Destination of each register in results, each with room for rows values
+     * @return OK, or the first domain error encountered
+     */
+    template <typename Scalar>
+    EvalStatus executeBatch(const std::vector<BasicSlotColumn<Scalar>>& columns, std::size_t rows, const std::uint32_t* results,
+                            std::size_t count, Scalar* const* outputs) const;
+
+public:
+
+    /**
+     * @return The number of variable slots the program reads
+     */
+    [[nodiscard]] std::size_t slotCount() const { return slotSymbols.size(); }
+
+    /**
+     * @param slot Index of the slot
+     * @return The name of the variable bound to the slot
+     */
+    [[nodiscard]] const std::string& slotName(const std::size_t slot) const { return SymbolTable::name(slotSymbols[slot]); }
+
+    /**
+     * @param slot Index of the slot
+     * @return The symbol id of the variable bound to the slot
+     */
+    [[nodiscard]] SymbolId slotSymbol(const std::size_t slot) const { return slotSymbols[slot]; }
+
+    /**
+     * @return The number of instructions in the program
+     */
+    [[nodiscard]] std::size_t size() const { return instructions.size(); }
+
+    /**
+     * @return true if the program contains SOLVE, INTEGRATE or SUM instructions, which
+     * have no native translation and cannot be saved in snapshots
+     */
+    [[nodiscard]] bool hasRoutines() const { return !routines.empty(); }
+
+    /**
+     * @brief Switches sin, cos, tan, exp, ln, log10 and log to the fast kernels of FastMath.h,
+     * in this program and in the expressions of its routines
+     * @details The fast kernels trade the standard library's last digits for speed, see FastMath.h
+     * for their error bounds. Domain errors are reported exactly as before.
+     */
+    void useFastMath();
+
+    /**
+     * @return The number of expressions a fused program computes, 0 for a program compiled from one
+     */
+    [[nodiscard]] std::size_t outputCount() const { return outputRegisters.size(); }
+
+    /**
+     * @brief Resolves every slot against a table of variable values
+     * @param variables Table of variable values
+     * @return Slot array suitable for evaluate()
+     * @throws runtime_error if a variable is not defined
+     */
+    [[nodiscard]] std::vector<long double> bind(const SymbolTable& variables) const;
+
+    /**
+     * @brief Evaluates the program without throwing on domain errors
+     * @tparam Scalar long double, double or float, the type all arithmetic is done in
+     * @param slots Variable values, indexed by slot, with room for slotCount() values
+     * @param value Set to the value of the expression if the status is OK
+     * @return OK, or the first domain error encountered
+     * @details Runs the bytecode evaluator until the program has been run JitTier::JIT_THRESHOLD
+     * times in this precision, and its native translation from then on when one is available.
+     */
+    template <typename Scalar>
+    EvalStatus run(const Scalar* slots, Scalar& value) const;
+
+    /**
+     * @brief Evaluates the program in the bytecode evaluator, like run() but never in native code
+     * @tparam Scalar long double, double or float, the type all arithmetic is done in
+     * @param slots Variable values, indexed by slot, with room for slotCount() values
+     * @param value Set to the value of the expression if the status is OK
+     * @return OK, or the first domain error encountered
+     */
+    template <typename Scalar>
+    EvalStatus interpret(const Scalar* slots, Scalar& value) const;
+
+    /**
+     * @brief Evaluates many rows like evaluateBatch(), without throwing on domain errors
+     * @tparam Scalar long double, double or float, the type all arithmetic is done in
+     * @param columns Input column for each slot, indexed by slot
+     * @param rows Number of rows to evaluate
+     * @param output Destination for the result of each row, with room for rows values
+     * @return OK, or the first domain error encountered, in which case output is only partially written
+     */
+    template <typename Scalar>
+    EvalStatus runBatch(const std::vector<BasicSlotColumn<Scalar>>& columns, std::size_t rows, Scalar* output) const;
+
+    /**
+     * @brief Evaluates every expression of a fused program over many rows in one pass
+     * @tparam Scalar long double, double or float, the type all arithmetic is done in
+     * @param columns Input column for each slot, indexed by slot
+     * @param rows Number of rows to evaluate
+     * @param outputs Destination for each expression's results, outputCount() arrays with room for rows values each
+     * @return OK, or the first domain error encountered, in which case the outputs are only partially written
+     * @details Work the expressions have in common, including variable loads, is done once per row.
+     */
+    template <typename Scalar>
+    EvalStatus runFused(const std::vector<BasicSlotColumn<Scalar>>& columns, std::size_t rows, Scalar* const* outputs) const;
+
+    /**
+     * @brief Evaluates the program
+     * @param slots Variable values, indexed by slot
+     * @return The value of the expression
+     * @throws runtime_error on domain errors, with the same messages as Node::evaluate
+     */
+    [[nodiscard]] long double evaluate(const std::vector<long double>& slots) const;
+
+    /**
+     * @brief Evaluates the program in a chosen precision
+     * @param slots Variable values, indexed by slot
+     * @param precision The engine to evaluate in
+     * @return The value of the expression, widened back to long double
+     * @throws runtime_error on domain errors, with the same messages as Node::evaluate
+     */
+    [[nodiscard]] long double evaluate(const std::vector<long double>& slots, Precision precision) const;
+
+    /**
+     * @brief Evaluates the program over many rows of input at once
+     * @param columns Input column for each slot, indexed by slot
+     * @param rows Number of rows to evaluate
+     * @param output Destination for the result of each row, with room for rows values
+     * @throws runtime_error on the first block containing a domain error
+     * @details Rows are processed in blocks of BATCH_BLOCK. Each instruction runs over the
+     * whole block before the next one starts, so every operation is a tight loop over
+     * contiguous registers instead of one dispatch per row.
+     */
+    void evaluateBatch(const std::vector<SlotColumn>& columns, std::size_t rows, long double* output) const;
+
+    static constexpr std::size_t BATCH_BLOCK = 128; ///< Rows evaluated per instruction dispatch
+};
+
+/**
+ * @struct RoutineScratch
+ * @brief Buffers a routine works in, kept between runs so that evaluating it does not allocate
+ * @tparam Scalar long double, double or float
+ */
+template <typename Scalar>
+struct RoutineScratch {
+    std::vector<Scalar> slots;                      ///< Values for the slots of the body
+    std::vector<Scalar> registers;                  ///< Registers of the body, for SOLVE
+    std::vector<Scalar> points;                     ///< Values of the variable in one batch, for INTEGRATE and SUM
+    std::vector<Scalar> weights;                    ///< Quadrature weight of each point, for INTEGRATE
+    std::vector<Scalar> values;                     ///< Value of the body at each point
+    std::vector<BasicSlotColumn<Scalar>> columns;   ///< Columns of the batch over the body
+};
+
+/**
+ * @struct Routine
+ * @brief An expression that a SOLVE, INTEGRATE or SUM instruction evaluates many times
+ *
+ * The expression is compiled into its own program, in which the bound variable is one
+ * slot and every other slot is fed from a register of the enclosing program. Solving
+ * compiles the expression's derivative into the same program, so each Newton step is one
+ * run that yields both values and shares their common subexpressions. Integrals and sums
+ * evaluate all their points through the batch evaluator.
+ */
+struct Routine {
+    static constexpr std::uint32_t NO_SLOT = static_cast<std::uint32_t>(-1); ///< variable when the body does not read it
+    static constexpr long double MAX_TERMS = 1e8L; ///< Most terms a sum may have
+
+    Program body;                      ///< The expression, with the derivative's register in slope for SOLVE
+    std::uint32_t slope = 0;           ///< Register of body holding the derivative, for SOLVE
+    std::uint32_t variable = NO_SLOT;  ///< Slot of body holding the bound variable
+    std::vector<std::uint32_t> inputs; ///< Register of the enclosing program feeding each slot of body, except variable
+    std::uint32_t from = 0;            ///< Register of the enclosing program holding the guess or the lower bound
+    std::uint32_t to = 0;              ///< Register of the enclosing program holding the upper bound, unused by SOLVE
+
+    /**
+     * @brief Runs the routine
+     * @tparam Scalar long double, double or float
+     * @param op SOLVE, INTEGRATE or SUM
+     * @param scratch Buffers to work in, with the values for the slots of body in slots; the
+     * variable's own slot is overwritten. A routine run inside this one needs buffers of its own
+     * @param first The guess or the lower bound
+     * @param second The upper bound, unused by SOLVE
+     * @param value Set to the result if the status is OK
+     * @return OK, the first domain error the expression hit, or the routine's own failure
+     */
+    template <typename Scalar>
+    EvalStatus run(OpCode op, RoutineScratch<Scalar>& scratch, Scalar first, Scalar second, Scalar& value) const;
+
+private:
+    template <typename Scalar>
+    EvalStatus solve(RoutineScratch<Scalar>& scratch, Scalar guess, Scalar& root) const;
+
+    template <typename Scalar>
+    EvalStatus integrate(RoutineScratch<Scalar>& scratch, Scalar lower, Scalar upper, Scalar& integral) const;
+
+    template <typename Scalar>
+    EvalStatus sum(RoutineScratch<Scalar>& scratch, Scalar lower, Scalar upper, Scalar& total) const;
+};
+
+/**
+ * @class Compiler
+ * @brief Lowers an AST into a Program
+ *
+ * Each node emits its own instruction through Node::compile after compiling its
+ * children. The compiler assigns registers, fills the constant pool and maps each
+ * distinct variable to a slot. Every operation is pure, so the compiler also numbers
+ * values: an instruction identical to one already emitted, after ordering the operands
+ * of commutative operations, reuses its register instead of being emitted again. Repeated
+ * subtrees such as the two sin(x * deg2rad) in sin(x * deg2rad)^2 + sin(x * deg2rad) are
+ * therefore computed once per evaluation. Small integer powers become multiplications,
+ * which number the same way, so x^2 and x^3 compute x * x once between them.
+ */
+class Compiler {
+private:
+    /**
+     * @struct InstructionHash
+     * @brief Hash of an instruction's opcode and operands for value numbering
+     */
+    struct InstructionHash {
+        std::size_t operator()(const Instruction& ins) const {
+            const std::uint64_t operands = (static_cast<std::uint64_t>(ins.a) << 32) | ins.b;
+            return std::hash<std::uint64_t>()(operands * 0x9E3779B97F4A7C15ull ^ static_cast<std::uint64_t>(ins.op));
+        }
+    };
+
+    /**
+     * @struct InstructionEqual
+     * @brief Equality of instructions for value numbering
+     */
+    struct InstructionEqual {
+        bool operator()(const Instruction& x, const Instruction& y) const {
+            return x.op == y.op && x.a == y.a && x.b == y.b;
+        }
+    };
+
+    Program program;                             ///< Program being built
+    std::unordered_map<SymbolId, std::uint32_t> slots; ///< Variable to slot index
+    std::unordered_map<SymbolId, std::uint32_t> defined; ///< Variable defined by an earlier fused line to its register
+    std::unordered_map<Instruction, std::uint32_t, InstructionHash, InstructionEqual> numbered; ///< Register already holding each instruction's value
+
+    /**
+     * @brief Appends the multiplications computing an integer power by repeated squaring
+     * @param base Register holding the base
+     * @param exponent The exponent, at least 1
+     * @return The register holding the power
+     */
+    std::uint32_t emitPower(std::uint32_t base, std::uint32_t exponent);
+
+public:
+    static constexpr long double MAX_MULTIPLIED_POWER = 16; ///< Largest integer exponent computed by multiplying rather than std::pow
+
+    /**
+     * @brief Compiles an expression tree
+     * @param expression Root node of the AST
+     * @return The compiled program
+     */
+    static Program compile(const Node& expression);
+
+    /**
+     * @brief Compiles a flat expression tree
+     * @param expression The tree
+     * @return The compiled program, identical to compiling the equivalent Node tree
+     */
+    static Program compile(const FlatTree& expression);
+
+    /**
+     * @brief Compiles several expressions into one program
+     * @param lines The expressions, in order
+     * @return A program with one output per line, and the last line's value as its result
+     * @details The expressions share one slot table and one value numbering, so a variable or a
+     * subexpression that several of them use is computed once. A line reading a variable that an
+     * earlier line defines reads that line's register rather than a slot.
+     */
+    static Program compile(const std::vector<FusedLine>& lines);
+
+    /**
+     * @brief Appends an instruction, unless an identical one was already emitted
+     * @param op Operation to perform
+     * @param a First operand register
+     * @param b Second operand register
+     * @return The register holding the instruction's result
+     * @details A POWER whose exponent is a constant integer from 2 to MAX_MULTIPLIED_POWER is emitted as
+     * multiplications, each of which rounds once, so the power stays within a few ulps of std::pow.
+     */
+    std::uint32_t emit(OpCode op, std::uint32_t a, std::uint32_t b = 0);
+
+    /**
+     * @brief Appends an instruction loading a constant, sharing one register per distinct value
+     * @param value The constant value
+     * @return The register holding the constant
+     */
+    std::uint32_t emitConstant(long double value);
+
+    /**
+     * @brief Appends an instruction loading a variable, allocating a slot on first use
+     * @param symbol The variable's interned id
+     * @return The register holding the variable's value, which for a variable an earlier fused
+     * line defines is that line's register
+     */
+    std::uint32_t emitLoad(SymbolId symbol);
+
+    /**
+     * @brief Appends a SOLVE, INTEGRATE or SUM instruction
+     * @param op The operation
+     * @param body Expression the routine evaluates
+     * @param slope Derivative of body with respect to the variable for SOLVE, nullptr otherwise
+     * @param variable The bound variable, which inside body no longer refers to the variable outside
+     * @param from Register holding the guess or the lower bound
+     * @param to Register holding the upper bound, unused by SOLVE
+     * @return The register holding the routine's result
+     * @details Loads every other variable body reads into this program's registers first.
+     */
+    std::uint32_t emitRoutine(OpCode op, const Node& body, const Node* slope, SymbolId variable, std::uint32_t from, std::uint32_t to);
+};
@@ -6,7 +6,7 @@
  * 
  * @details This header defines the Calculator class which declares functions
  * to evaluate mathematical expressions represented as ASTs,
- * as well as managing variables, their values, and the nodes corresponding to them.
+ * as well as managing variables and their values in an interned symbol table.
  * It also includes functions that format numbers and print tokens in a certain way for
  * better result statements.
 */
@@ -14,37 +14,75 @@
 #pragma once
 
 #include "Node.h"
+#include "Bytecode.h"
 #include "Lexicography.h"
+#include "NumberFormat.h"
+#include "SymbolTable.h"
 
+#include <cstdint>
+#include <iostream>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+/**
+ * @struct Recomputation
+ * @brief Outcome of re-evaluating one live formula after one of its inputs changed
+ */
+struct Recomputation {
+    SymbolId symbol;   ///< The variable whose formula was re-evaluated
+    long double value; ///< Its new value, if status is OK
+    EvalStatus status; ///< OK, or the error that left the variable at its previous value
+};
+
 
 /**
  * @class Calculator
  * @brief The main higher-level engine for evaluating expressions, managing vars, and formatting output
  * 
  * This class declares functions to evaluate expressions represented as ASTs, add, get, and set variables, 
- * and format outputs. It also includes Maps to store variable names, their nodes, and their values, and 
- * functions to format output.
+ * and format outputs. Variable values live in a SymbolTable indexed by interned id, which also records
+ * which variables are preserved, and it includes functions to format output.
  */ 
 class Calculator{
 private:
-	std::map<std::string, long double> variables; ///< Map of variable names to their values
-	std::map<std::string, std::unique_ptr<Node>> varNodes; ///< Map of variable names to their corresponding AST nodes
-	std::set<std::string> preservedValues = {  ///< Predefined constants
-		"pi", "e", "deg2rad", "rad2deg"
-	};
+	friend class Snapshot;
+
+	SymbolTable symbols; ///< Values of all variables, and which of them are preserved
+	std::uint64_t constantsVersion = 0; ///< Bumped whenever getConstants() would return something different
+	std::unordered_map<SymbolId, Program> formulas; ///< Live formula of each variable defined by define()
+	std::unordered_map<SymbolId, std::vector<SymbolId>> dependents; ///< Variables whose formulas read each variable
+	std::vector<Recomputation> recomputations; ///< Formulas re-evaluated by the latest assignment
+
+	/**
+	* @brief Re-evaluates every formula that depends on a variable, in topological order
+	* @param changed The variable that was just written
+	* @param precision The engine the formulas are evaluated in
+	*/
+	void propagate(SymbolId changed, Precision precision);
+
+	/**
+	* @brief Drops a variable's formula and its edges from the dependency graph
+	* @param id The variable, which keeps its current value
+	*/
+	void unlink(SymbolId id);
+
+	/**
+	* @brief Checks whether a variable's value flows into another through formulas
+	* @param from The variable that changes
+	* @param target The variable to look for downstream
+	* @return true if target depends on from, directly or indirectly
+	*/
+	[[nodiscard]] bool reaches(SymbolId from, SymbolId target) const;
 
 public:
 
     /**
 	* @brief Construct a new Calculator object
-	* @details Initializes Maps that store variables, their corresponding nodes on the AST, and their
-    * values, as well as predefines the variables: pi, e, deg2rad, rad2deg
+	* @details Predefines and preserves the variables: pi, e, deg2rad, rad2deg
     */
     Calculator();
 
@@ -54,14 +92,74 @@ public:
 	* @return The result of evaluating the expression as a long double
     */ 
     [[nodiscard]] long double evaluate(const std::unique_ptr<Node>& expression) const;
+
+	/**
+	* @brief Evaluates a compiled expression against the current variables
+	* @param program The program produced by Compiler::compile
+	* @return The result of evaluating the program as a long double
+	* @throws runtime_error if the program reads an undefined variable or hits a domain error
+	*/
+    [[nodiscard]] long double evaluate(const Program& program) const;
+
+	/**
+	* @brief Evaluates a compiled expression against the current variables in a chosen precision
+	* @param program The program produced by Compiler::compile
+	* @param precision The engine to evaluate in
+	* @return The result, widened back to long double
+	* @throws runtime_error if the program reads an undefined variable or hits a domain error
+	*/
+    [[nodiscard]] long double evaluate(const Program& program, Precision precision) const;
+
+	/**
+	* @brief Evaluates a compiled expression once per row of input columns
+	* @param program The program produced by Compiler::compile
+	* @param columns Map of variable names to their value in each row. Variables without a
+	* column use their current value for every row.
+	* @return The result for each row
+	* @throws runtime_error if the columns differ in length, none are given, a variable is
+	* undefined, or a row hits a domain error
+	*/
+	[[nodiscard]] std::vector<long double> evaluateBatch(const Program& program,
+		const std::map<std::string, std::vector<long double>>& columns) const;
     
 	/**
-	* @brief Assigns a value to a variable and creates its corresponding AST node
+	* @brief Assigns a value to a variable
 	* @param name The name of the variable to assign
 	* @param value The value to assign to the variable
     */ 
     void assign(const std::string& name, long double value);
 
+	/**
+	* @brief Assigns a value to a variable by its interned id, without allocating
+	* @param id The symbol of the variable to assign
+	* @param value The value to assign to the variable
+	* @param precision The engine the live formulas reading the variable are re-evaluated in
+	*/
+	void assign(SymbolId id, long double value, Precision precision = Precision::LONG_DOUBLE);
+
+	/**
+	* @brief Assigns a live formula to a variable, which is re-evaluated whenever one of its inputs changes
+	* @param id The symbol of the variable to define
+	* @param formula The variable's expression, compiled without folding preserved values
+	* @param precision The engine the formula and those reading the variable are evaluated in
+	* @return The formula's current value, which the variable now holds
+	* @throws runtime_error if the formula depends on the variable itself, or cannot be evaluated now
+	* @details Plain assignments to the variable later replace the formula with a fixed value.
+	*/
+	long double define(SymbolId id, Program formula, Precision precision = Precision::LONG_DOUBLE);
+
+	/**
+	* @param id The symbol of a variable
+	* @return true if the variable currently holds a live formula
+	*/
+	[[nodiscard]] bool isFormula(const SymbolId id) const { return formulas.count(id) != 0; }
+
+	/**
+	* @brief Gets the formulas re-evaluated by the latest assign() or define()
+	* @return One entry per affected variable, in the order they were recomputed
+	*/
+	[[nodiscard]] const std::vector<Recomputation>& recomputed() const { return recomputations; }
+
     /**
 	* @brief Retrieves the AST node corresponding to a variable
 	* @param name The name of the variable to retrieve
@@ -70,6 +168,14 @@ public:
     */ 
     std::unique_ptr<Node> getVariable(const std::string& name) ;
 
+	/**
+	* @brief Looks up the value of a variable without throwing
+	* @param name The name of the variable to look up
+	* @param value Set to the variable's value if it exists
+	* @return true if the variable exists
+	*/
+	bool lookup(const std::string& name, long double& value) const;
+
 	/**
 	* @brief Updates the value of an existing variable
 	* @param name The name of the variable to update
@@ -78,9 +184,12 @@ public:
     void setVariable(const std::string& name, long double value);
 
 	/**
-	* @brief Prints all currently defined variables and their values to the console
+	* @brief Prints all currently defined variables and their values
+	* @param out Stream to print to, the console by default
+	* @param digits Significant digits of each value, or SHORTEST_DIGITS for the shortest round-trip text
+	* @param precision Engine the values were computed in, which the shortest text reads back in
 	*/ 
-    void printVars() const;
+    void printVars(std::ostream& out = std::cout, int digits = DEFAULT_DIGITS, Precision precision = Precision::LONG_DOUBLE) const;
 
 	/**
 	* @brief Clears all user-defined variables while preserving predefined constants
@@ -102,10 +211,22 @@ public:
 	static std::string formatNumber(long double value);
 
 	/**
-	 * @brief Gets the map of preserved variable names to values
-	 * @return The map of preserved variable names to values
+	 * @brief Gets the names of the preserved variables
+	 * @return The set of preserved variable names
+	 */
+	[[nodiscard]] std::set<std::string> getPreservedValues() const;
+
+	/**
+	 * @brief Gets the table of all variables, whose preserved entries are used for constant folding
+	 * @return The calculator's symbol table
+	 */
+	[[nodiscard]] const SymbolTable& getConstants() const { return symbols; }
+
+	/**
+	 * @brief Gets a counter that changes whenever a preserved variable or the preserved set changes
+	 * @return The current version, used to invalidate compiled expressions with folded constants
 	 */
-	[[nodiscard]] std::set<std::string> getPreservedValues() const { return preservedValues; }
+	[[nodiscard]] std::uint64_t getConstantsVersion() const { return constantsVersion; }
 
 	/**
 	 * @brief Adds a variable name to the list of preserved variables
@@ -0,0 +1,167 @@
+/**
+ * @file Expression.h
+ * @brief Embedding API for compiling an expression once and evaluating it many times
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header defines the Expression class, the entry point for programs that link
+ * calculator_core directly instead of driving the calculator through text. Compiling
+ * runs the lexer, parser, optimizer and bytecode compiler once; afterwards variables
+ * are bound by slot and the expression is evaluated without allocating, looking up
+ * names, or throwing on domain errors.
+ */
+
+#pragma once
+
+#include "Bytecode.h"
+#include "Calculator.h"
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class Expression
+ * @brief A compiled expression together with the values bound to its variables
+ *
+ * Typical use:
+ * @code
+ * Expression f = Expression::compile("x^2 + 3*y");
+ * const std::size_t x = f.slotOf("x"), y = f.slotOf("y");
+ * f.set(y, 2);
+ * for (long double value : inputs) {
+ *     f.set(x, value);
+ *     long double result;
+ *     if (f.evaluate(result) != EvalStatus::OK) { ... }
+ * }
+ * @endcode
+ * An Expression is not safe to evaluate from several threads while another thread is
+ * setting its variables, but independent copies may be used concurrently.
+ */
+class Expression {
+private:
+    Program program;                       ///< The compiled expression
+    std::vector<long double> values;       ///< Bound value of each slot
+    std::vector<bool> bound;               ///< Whether each slot has been given a value
+    std::size_t unbound = 0;               ///< Number of slots without a value
+    mutable std::vector<SlotColumn> batch; ///< Column of each slot for evaluateBatch(), reused between calls
+
+    /**
+     * @brief Wraps a compiled program with no variables bound
+     * @param program The compiled program
+     */
+    explicit Expression(Program program);
+
+public:
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1); ///< slotOf() result for unused names
+
+    /**
+     * @brief Compiles an expression
+     * @param text The expression, which must not be an assignment or a sweep
+     * @return The compiled expression, with no variables bound
+     * @throws runtime_error on lexing or parsing errors, or if text is an assignment or a sweep
+     */
+    static Expression compile(std::string_view text);
+
+    /**
+     * @brief Compiles an expression, folding in a calculator's preserved values
+     * @param text The expression, which must not be an assignment or a sweep
+     * @param constants Calculator whose preserved values (pi, e, ...) are substituted at compile time
+     * @return The compiled expression, with no variables bound
+     * @throws runtime_error on lexing or parsing errors, or if text is an assignment or a sweep
+     */
+    static Expression compile(std::string_view text, const Calculator& constants);
+
+    /**
+     * @brief Compiles an expression read from a stream, such as a large generated file
+     * @param input Stream holding the expression, read until it ends
+     * @return The compiled expression, with no variables bound
+     * @throws runtime_error on lexing or parsing errors, or if the input is an assignment or a sweep
+     * @details The input is lexed and parsed as it is read, so it is never held in memory as a whole
+     * string or token vector. Newlines count as whitespace.
+     */
+    static Expression compile(std::istream& input);
+
+    /**
+     * @brief Compiles an expression read from a stream, folding in a calculator's preserved values
+     * @param input Stream holding the expression, read until it ends
+     * @param constants Calculator whose preserved values (pi, e, ...) are substituted at compile time
+     * @return The compiled expression, with no variables bound
+     * @throws runtime_error on lexing or parsing errors, or if the input is an assignment or a sweep
+     */
+    static Expression compile(std::istream& input, const Calculator& constants);
+
+    /**
+     * @return The number of distinct variables the expression reads
+     */
+    [[nodiscard]] std::size_t slotCount() const { return program.slotCount(); }
+
+    /**
+     * @param slot Index of the slot
+     * @return The name of the variable read through the slot
+     */
+    [[nodiscard]] const std::string& slotName(const std::size_t slot) const { return program.slotName(slot); }
+
+    /**
+     * @param name Name of a variable
+     * @return The slot the variable is read through, or npos if the expression does not use it
+     */
+    [[nodiscard]] std::size_t slotOf(std::string_view name) const;
+
+    /**
+     * @brief Binds a value to a slot
+     * @param slot Index of the slot, less than slotCount()
+     * @param value The value of the variable
+     */
+    void set(const std::size_t slot, const long double value) {
+        values[slot] = value;
+        if (!bound[slot]) {
+            bound[slot] = true;
+            --unbound;
+        }
+    }
+
+    /**
+     * @brief Binds a value to a variable by name
+     * @param name Name of the variable
+     * @param value The value of the variable
+     * @return false if the expression does not use the variable
+     */
+    bool set(std::string_view name, long double value);
+
+    /**
+     * @brief Binds every variable the calculator defines
+     * @param variables Calculator to read the values from
+     * @return The number of slots still without a value
+     */
+    std::size_t bindAll(const Calculator& variables);
+
+    /**
+     * @brief Evaluates the expression with the bound values
+     * @param result Set to the value of the expression if the status is OK
+     * @return OK, UNBOUND_VARIABLE if a slot has no value, or the domain error encountered
+     */
+    EvalStatus evaluate(long double& result) const {
+        if (unbound != 0) { return EvalStatus::UNBOUND_VARIABLE; }
+        return program.run(values.data(), result);
+    }
+
+    /**
+     * @brief Evaluates the expression for many rows of inputs
+     * @param columns Input column for each slot. Slots with a null column, or past the end, use their bound value.
+     * @param rows Number of rows to evaluate
+     * @param output Destination for the result of each row, with room for rows values
+     * @return OK, UNBOUND_VARIABLE if a slot has neither a column nor a value, or the domain error encountered
+     * @details The columns are gathered into a buffer the expression keeps, so unlike evaluate() this
+     * must not be called on the same object from several threads at once.
+     */
+    EvalStatus evaluateBatch(const std::vector<SlotColumn>& columns, std::size_t rows, long double* output) const;
+
+    /**
+     * @return The underlying program
+     */
+    [[nodiscard]] const Program& compiled() const { return program; }
+};
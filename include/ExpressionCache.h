@@ -0,0 +1,147 @@
+/**
+ * @file ExpressionCache.h
+ * @brief LRU cache of compiled expressions
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header defines the ExpressionCache class, which remembers the compiled form of
+ * recently seen input lines so that repeated expressions skip lexing, parsing, folding
+ * and compiling entirely. Entries are keyed by the input with insignificant whitespace removed and
+ * are evicted in least recently used order once the configured capacity is reached.
+ */
+
+#pragma once
+
+#include "Bytecode.h"
+#include "SymbolTable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * @enum LineKind
+ * @brief What a compiled input line does when it runs
+ */
+enum class LineKind {
+    EXPRESSION, ///< Evaluate and print the result
+    ASSIGNMENT, ///< Evaluate and store the result in a variable
+    PRESERVE,   ///< Add a variable to the preserved set
+    REMOVE,     ///< Remove a variable from the preserved set
+    SWEEP       ///< Evaluate and print the result for every value of a range
+};
+
+/**
+ * @struct CompiledExpression
+ * @brief Everything needed to run an input line again without re-parsing it
+ */
+struct CompiledExpression {
+    Program program;                     ///< The optimized, compiled expression, empty for commands
+    Program formula;                     ///< An assignment's expression without preserved values folded in, compiled in reactive mode only
+    LineKind kind = LineKind::EXPRESSION; ///< What the line does
+    std::string assignVar;               ///< The variable assigned, preserved or removed, if any
+    SymbolId assignSymbol = 0;           ///< Interned id of assignVar, for assignments
+    std::string display;                 ///< The line formatted by Calculator::printTokens, up to any sweep clause
+    SymbolId sweepSymbol = 0;            ///< Variable a sweep runs over
+    Program sweepFrom;                   ///< First value of a sweep
+    Program sweepTo;                     ///< Last value of a sweep
+    Program sweepStep;                   ///< Step of a sweep, empty for the default of 1
+};
+
+/**
+ * @class ExpressionCache
+ * @brief Least recently used map from input lines to compiled expressions
+ *
+ * Compiled programs have the values of preserved variables folded in, so the cache
+ * drops everything whenever the calculator reports a new constants version.
+ */
+class ExpressionCache {
+private:
+    /**
+     * @struct Entry
+     * @brief A cached line and its compiled form
+     */
+    struct Entry {
+        std::string key;              ///< Normalized input line
+        CompiledExpression compiled;  ///< Compiled form of the line
+    };
+
+    std::list<Entry> entries;  ///< Entries from most to least recently used
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index; ///< Key to entry, viewing Entry::key
+    std::size_t capacity;          ///< Maximum number of entries
+    std::uint64_t version = 0;     ///< Constants version the entries were compiled against
+    std::size_t hitCount = 0;      ///< Lookups that found an entry
+    std::size_t missCount = 0;     ///< Lookups that did not
+    CompiledExpression uncached;   ///< Last insert when the capacity is 0
+
+    /**
+     * @brief Drops least recently used entries until the size fits the capacity
+     */
+    void trim();
+
+public:
+
+    /**
+     * @brief Construct a new ExpressionCache
+     * @param capacity Maximum number of compiled expressions to keep, 0 disables caching
+     */
+    explicit ExpressionCache(std::size_t capacity = 1024);
+
+    /**
+     * @brief Normalizes an input line into a cache key
+     * @param input The raw input line
+     * @return The line with all whitespace removed except a single space between two word
+     * characters, where it keeps tokens such as "x 1" apart. The lexer treats both forms identically.
+     */
+    static std::string normalize(std::string_view input);
+
+    /**
+     * @brief Looks up a line and marks it as most recently used
+     * @param key The normalized input line
+     * @param constantsVersion The calculator's current constants version
+     * @return The compiled expression, or nullptr on a miss. The pointer stays valid until the next insert().
+     */
+    const CompiledExpression* find(const std::string& key, std::uint64_t constantsVersion);
+
+    /**
+     * @brief Stores the compiled form of a line, evicting the least recently used entry if full
+     * @param key The normalized input line
+     * @param compiled The compiled expression
+     * @return The stored expression. The reference stays valid until the next insert().
+     */
+    const CompiledExpression& insert(const std::string& key, CompiledExpression compiled);
+
+    /**
+     * @brief Removes every entry, keeping the counters
+     */
+    void clear();
+
+    /**
+     * @brief Changes the capacity, evicting entries if it shrinks
+     * @param newCapacity Maximum number of entries, 0 disables caching
+     */
+    void setCapacity(std::size_t newCapacity);
+
+    /**
+     * @return The maximum number of entries
+     */
+    [[nodiscard]] std::size_t getCapacity() const { return capacity; }
+
+    /**
+     * @return The number of entries currently cached
+     */
+    [[nodiscard]] std::size_t size() const { return entries.size(); }
+
+    /**
+     * @return The number of lookups that found an entry
+     */
+    [[nodiscard]] std::size_t hits() const { return hitCount; }
+
+    /**
+     * @return The number of lookups that did not find an entry
+     */
+    [[nodiscard]] std::size_t misses() const { return missCount; }
+};
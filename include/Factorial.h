@@ -0,0 +1,28 @@
+/**
+ * @file Factorial.h
+ * @brief Constant-time factorial shared by the tree and bytecode evaluators
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header declares the factorial kernel used by FactorialNode and the FACTORIAL
+ * instruction. Integer arguments are looked up in a table of every factorial that fits
+ * in a long double, which is built at compile time; other arguments go through the
+ * gamma function.
+ */
+
+#pragma once
+
+/**
+ * @brief Computes x!
+ * @param x A non-negative value; callers report negative values as errors
+ * @return x! for integers, Gamma(x + 1) for non-integers, and infinity past the largest
+ * representable factorial
+ */
+long double factorial(long double x);
+
+/**
+ * @brief Half the width of the central difference that stands in for the derivative of x!
+ * @details The derivative Gamma(x + 1) psi(x + 1) has no closed form among the other
+ * functions, so ((x + h)! - (x - h)!) / 2h is used, which is accurate to about h^2.
+ */
+constexpr long double FACTORIAL_STEP = 1e-6L;
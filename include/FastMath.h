@@ -0,0 +1,219 @@
+/**
+ * @file FastMath.h
+ * @brief Polynomial approximations of the transcendental functions for fast-math mode
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header defines the kernels behind the FAST_ opcodes. Each one reduces its argument
+ * with a few exact operations, evaluates a fixed polynomial in double precision and
+ * rebuilds the result by manipulating bits, with no branches and no table lookups, so a
+ * loop over a block of values vectorizes. A kernel is only accurate inside its range;
+ * the wrappers fall back to the standard library outside it, and the batch evaluator runs
+ * the kernel over the whole block and then redoes the few values outside the range.
+ *
+ * The largest relative errors against the standard library in long double are given by
+ * the _ERROR constants below, which calculator_bench --accuracy checks. The kernels work in
+ * double, and rounding x to double first moves sin, cos and tan by up to |f'(x)| times
+ * ARGUMENT_ROUNDING * |x| on top of that, which dominates near their zeros and near the
+ * poles of tan. Results in float precision are then rounded to float.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace fastmath {
+
+constexpr double TRIG_LIMIT = 1e5; ///< Largest |x| the sin, cos and tan kernels reduce exactly
+constexpr double EXP_LIMIT = 708;  ///< Largest |x| whose exp is a normal double
+
+constexpr double TRIG_ERROR = 3e-9;  ///< Largest relative error of sin and cos for |x| <= TRIG_LIMIT
+constexpr double TAN_ERROR = 5e-9;   ///< Largest relative error of tan for |x| <= TRIG_LIMIT
+constexpr double EXP_ERROR = 1e-8;   ///< Largest relative error of exp for |x| <= EXP_LIMIT
+constexpr double LN_ERROR = 3e-9;    ///< Largest relative error of ln, log10 and log for normal doubles
+constexpr double ARGUMENT_ROUNDING = 1.2e-16; ///< Relative error of rounding a long double to double
+
+/**
+ * @param value A double
+ * @return Its bits
+ */
+inline std::uint64_t bits(const double value) {
+    std::uint64_t out;
+    std::memcpy(&out, &value, sizeof(out));
+    return out;
+}
+
+/**
+ * @param value Bits of a double
+ * @return The double
+ */
+inline double fromBits(const std::uint64_t value) {
+    double out;
+    std::memcpy(&out, &value, sizeof(out));
+    return out;
+}
+
+// Adding then subtracting 1.5 * 2^52 rounds to the nearest integer, which is left in the low bits of the sum
+constexpr double ROUNDER = 6755399441055744.0;
+
+// pi/2 in three parts, the first two with trailing zero bits so that n times them is exact for |n| < 2^20
+constexpr double PIO2_HI = 1.57079632673412561417e+00;
+constexpr double PIO2_MID = 6.07710050630396597660e-11;
+constexpr double PIO2_LO = 2.02226624879595063154e-21;
+constexpr double TWO_OVER_PI = 6.36619772367581382433e-01;
+
+// ln 2 in two parts, the first exact when multiplied by an exponent
+constexpr double LN2_HI = 6.93147180369123816490e-01;
+constexpr double LN2_LO = 1.90821492927058770002e-10;
+constexpr double LOG2E = 1.44269504088896338700e+00;
+constexpr double LOG10E = 4.34294481903251827651e-01;
+
+// Bits of sqrt(1/2), where the reduced argument of ln starts
+constexpr std::uint64_t SQRT_HALF_BITS = 0x3FE6A09E667F3BCDull;
+
+/**
+ * @brief sin and cos of x - n pi/2 over [-pi/4, pi/4], with the quadrant n
+ */
+struct Reduced {
+    double sin;         ///< sin of the reduced argument
+    double cos;         ///< cos of the reduced argument
+    std::uint64_t quadrant; ///< n modulo 4 in the low two bits
+};
+
+/**
+ * @param x Argument with |x| <= TRIG_LIMIT
+ * @return The reduced argument's sin and cos, from odd and even Taylor polynomials
+ * truncated below 2.2e-9 relative error on [-pi/4, pi/4]
+ */
+inline Reduced reduce(const double x) {
+    const double shifted = x * TWO_OVER_PI + ROUNDER;
+    const double n = shifted - ROUNDER;
+    const double r = ((x - n * PIO2_HI) - n * PIO2_MID) - n * PIO2_LO;
+    const double r2 = r * r;
+    const double s = r + r * r2 * (-1.0 / 6 + r2 * (1.0 / 120 + r2 * (-1.0 / 5040 + r2 * (1.0 / 362880))));
+    const double c = 1 + r2 * (-0.5 + r2 * (1.0 / 24 + r2 * (-1.0 / 720 + r2 * (1.0 / 40320 + r2 * (-1.0 / 3628800)))));
+    return {s, c, bits(shifted)};
+}
+
+/**
+ * @param x Argument with |x| <= TRIG_LIMIT
+ * @return sin(x)
+ */
+inline double sinKernel(const double x) {
+    const Reduced reduced = reduce(x);
+    const double value = (reduced.quadrant & 1) ? reduced.cos : reduced.sin;
+    return (reduced.quadrant & 2) ? -value : value;
+}
+
+/**
+ * @param x Argument with |x| <= TRIG_LIMIT
+ * @return cos(x)
+ */
+inline double cosKernel(const double x) {
+    const Reduced reduced = reduce(x);
+    const double value = (reduced.quadrant & 1) ? reduced.sin : reduced.cos;
+    return ((reduced.quadrant + 1) & 2) ? -value : value;
+}
+
+/**
+ * @param x Argument with |x| <= TRIG_LIMIT
+ * @return tan(x)
+ */
+inline double tanKernel(const double x) {
+    const Reduced reduced = reduce(x);
+    return (reduced.quadrant & 1) ? -reduced.cos / reduced.sin : reduced.sin / reduced.cos;
+}
+
+/**
+ * @param x Argument with |x| <= EXP_LIMIT
+ * @return e^x, as 2^n e^r with |r| <= ln(2)/2 and e^r from a degree 7 Taylor polynomial
+ */
+inline double expKernel(const double x) {
+    const double shifted = x * LOG2E + ROUNDER;
+    const double n = shifted - ROUNDER;
+    const double r = (x - n * LN2_HI) - n * LN2_LO;
+    const double p = 1 + r * (1 + r * (1.0 / 2 + r * (1.0 / 6 + r * (1.0 / 24 + r * (1.0 / 120 + r * (1.0 / 720 + r * (1.0 / 5040)))))));
+    return p * fromBits((bits(shifted) + 1023) << 52);
+}
+
+/**
+ * @param x A positive normal double
+ * @return ln(x), as k ln(2) + 2 atanh((m - 1) / (m + 1)) with m in [sqrt(1/2), sqrt(2))
+ */
+inline double lnKernel(const double x) {
+    // The top bits of the offset pattern hold k + 1023, and subtracting k from the exponent leaves m
+    const std::uint64_t offset = bits(x) + (0x3FF0000000000000ull - SQRT_HALF_BITS);
+    const std::uint64_t biased = offset >> 52;
+    const double m = fromBits(bits(x) - ((biased - 1023) << 52));
+    const double k = fromBits(0x4330000000000000ull | biased) - 4503599627370496.0 - 1023;
+    const double f = (m - 1) / (m + 1);
+    const double f2 = f * f;
+    const double atanh = f + f * f2 * (1.0 / 3 + f2 * (1.0 / 5 + f2 * (1.0 / 7 + f2 * (1.0 / 9))));
+    return k * LN2_HI + (2 * atanh + k * LN2_LO);
+}
+
+/**
+ * @param x Any value
+ * @return true if the sin, cos and tan kernels are accurate for x
+ */
+template <typename Scalar>
+bool inTrigRange(const Scalar x) { return std::abs(x) <= TRIG_LIMIT; }
+
+/**
+ * @param x Any value
+ * @return true if the exp kernel is accurate for x
+ */
+template <typename Scalar>
+bool inExpRange(const Scalar x) { return std::abs(x) <= EXP_LIMIT; }
+
+/**
+ * @param x Any value
+ * @return true if the ln kernel is accurate for x
+ */
+template <typename Scalar>
+bool inLnRange(const Scalar x) {
+    return x >= std::numeric_limits<double>::min() && x <= std::numeric_limits<double>::max();
+}
+
+/**
+ * @brief Fast sin, exact in the standard library outside the kernel's range
+ */
+template <typename Scalar>
+Scalar sin(const Scalar x) { return inTrigRange(x) ? static_cast<Scalar>(sinKernel(static_cast<double>(x))) : std::sin(x); }
+
+/**
+ * @brief Fast cos, exact in the standard library outside the kernel's range
+ */
+template <typename Scalar>
+Scalar cos(const Scalar x) { return inTrigRange(x) ? static_cast<Scalar>(cosKernel(static_cast<double>(x))) : std::cos(x); }
+
+/**
+ * @brief Fast tan, exact in the standard library outside the kernel's range
+ */
+template <typename Scalar>
+Scalar tan(const Scalar x) { return inTrigRange(x) ? static_cast<Scalar>(tanKernel(static_cast<double>(x))) : std::tan(x); }
+
+/**
+ * @brief Fast e^x, exact in the standard library outside the kernel's range
+ */
+template <typename Scalar>
+Scalar exp(const Scalar x) { return inExpRange(x) ? static_cast<Scalar>(expKernel(static_cast<double>(x))) : std::exp(x); }
+
+/**
+ * @brief Fast natural logarithm of a positive value, exact in the standard library outside the kernel's range
+ */
+template <typename Scalar>
+Scalar ln(const Scalar x) { return inLnRange(x) ? static_cast<Scalar>(lnKernel(static_cast<double>(x))) : std::log(x); }
+
+/**
+ * @brief Fast base-10 logarithm of a positive value, exact in the standard library outside the kernel's range
+ */
+template <typename Scalar>
+Scalar log10(const Scalar x) {
+    return inLnRange(x) ? static_cast<Scalar>(lnKernel(static_cast<double>(x)) * LOG10E) : std::log10(x);
+}
+
+} // namespace fastmath
@@ -0,0 +1,186 @@
+/**
+ * @file FlatTree.h
+ * @brief Compact expression tree stored in one contiguous array
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header defines FlatNode and the FlatTree class, an alternative to the Node class
+ * hierarchy in which every node is a small plain struct tagged with its OpCode and refers
+ * to its children by index. A whole expression is one vector of nodes and one vector of
+ * constants, the parser appends to it directly, and evaluation is a single switch that
+ * the compiler can inline instead of one virtual call per node.
+ */
+
+#pragma once
+
+#include "Bytecode.h"
+#include "SymbolTable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * @struct FlatNode
+ * @brief One node of a FlatTree
+ *
+ * Operands follow the Instruction conventions: a and b are child node indices, except
+ * for CONSTANT, where a indexes the tree's constants, and LOAD, where a is the symbol
+ * id of the variable. Children are always stored before their parent.
+ */
+struct FlatNode {
+    OpCode op;       ///< Kind of node
+    std::uint32_t a; ///< First operand
+    std::uint32_t b; ///< Second operand, unused by unary nodes
+};
+
+/**
+ * @class FlatTree
+ * @brief An expression tree without pointers or virtual functions
+ *
+ * Nodes are added children first through number(), variable(), unary() and binary(),
+ * which return the index of the new node. Evaluation visits the children of each node
+ * in the same order as the corresponding Node class, so both forms report the same error
+ * first, and with the same messages. A node takes 12 bytes, against 24 to 32 bytes plus
+ * a separate allocation for each Node.
+ */
+class FlatTree {
+public:
+    using Handle = std::uint32_t; ///< What the parser holds for a parsed subtree
+
+private:
+    std::vector<FlatNode> nodes;        ///< Every node, children before parents
+    std::vector<long double> constants; ///< Values of the CONSTANT nodes
+    std::uint32_t root = 0;             ///< Index of the node the expression evaluates to
+
+    /**
+     * @param index A node
+     * @param variables Table of variable values
+     * @return The value of the subtree rooted at the node
+     * @throws runtime_error on undefined variables and domain errors
+     */
+    [[nodiscard]] long double evaluate(std::uint32_t index, const SymbolTable& variables) const;
+
+    /**
+     * @param index A node
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the value of the subtree rooted at the node
+     */
+    std::uint32_t compile(std::uint32_t index, Compiler& compiler) const;
+
+    /**
+     * @brief Appends a node
+     * @return Its index
+     */
+    std::uint32_t add(OpCode op, std::uint32_t a, std::uint32_t b);
+
+    /**
+     * @param index A node
+     * @return true if the node is the constant 0
+     */
+    [[nodiscard]] bool isZero(std::uint32_t index) const;
+
+    /**
+     * @param index A node
+     * @return true if the node is the constant 1
+     */
+    [[nodiscard]] bool isOne(std::uint32_t index) const;
+
+    /* Node builders for derivatives, which skip operations on zeros and ones like the Node rules do */
+    Handle sum(Handle left, Handle right);
+    Handle difference(Handle left, Handle right);
+    Handle product(Handle left, Handle right);
+    Handle quotient(Handle numerator, Handle denominator);
+    Handle negation(Handle operand);
+
+    /**
+     * @param index A node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return Index of a node evaluating to the derivative of the subtree rooted at the node
+     */
+    Handle differentiate(std::uint32_t index, SymbolId variable);
+
+public:
+
+    /**
+     * @brief Adds a numeric constant
+     * @param value The number
+     * @return Index of the new node
+     */
+    Handle number(long double value);
+
+    /**
+     * @brief Adds a variable reference
+     * @param name The variable's name, interned here
+     * @return Index of the new node
+     */
+    Handle variable(std::string_view name);
+
+    /**
+     * @brief Adds a node with one child
+     * @param op NEGATE, ABS, FACTORIAL or one of the single-argument functions
+     * @param operand Index of the child
+     * @return Index of the new node
+     */
+    Handle unary(OpCode op, Handle operand) { return add(op, operand, 0); }
+
+    /**
+     * @brief Adds a node with two children
+     * @param op ADD, SUBTRACT, MULTIPLY, DIVIDE, POWER or LOG
+     * @param left Index of the first operand, the value for LOG
+     * @param right Index of the second operand, the base for LOG
+     * @return Index of the new node
+     */
+    Handle binary(OpCode op, Handle left, Handle right) { return add(op, left, right); }
+
+    /**
+     * @brief Adds the derivative of a subtree
+     * @param expression Index of the subtree
+     * @param variable Name of the variable to differentiate with respect to
+     * @return Index of the new subtree's root, which refers to nodes of the original
+     * subtree instead of copying them
+     * @details Follows the same rules as Node::derivative.
+     */
+    Handle derivative(Handle expression, std::string_view variable);
+
+    /**
+     * @brief Rejects solve, integrate and sum, whose expressions are compiled into routines only from Node trees
+     * @throws runtime_error always
+     */
+    Handle routine(OpCode op, Handle body, std::string_view variable, Handle from, Handle to);
+
+    /**
+     * @brief Selects the node the tree evaluates to
+     * @param node Index of the root, by default the first node
+     */
+    void setRoot(const Handle node) { root = node; }
+
+    /**
+     * @brief Evaluates the expression, which must have at least one node
+     * @details Computes every node in one pass in storage order, so nodes outside the root's
+     * subtree are computed too, but only errors inside it are reported.
+     * @param variables Table of variable values
+     * @return The value of the expression
+     * @throws runtime_error on undefined variables and domain errors, with the same messages as Node::evaluate
+     */
+    [[nodiscard]] long double evaluate(const SymbolTable& variables) const;
+
+    /**
+     * @brief Lowers the expression into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the value of the expression
+     * @details Emits the same instructions as compiling the equivalent Node tree.
+     */
+    std::uint32_t compile(Compiler& compiler) const { return compile(root, compiler); }
+
+    /**
+     * @return The number of nodes in the tree
+     */
+    [[nodiscard]] std::size_t size() const { return nodes.size(); }
+
+    /**
+     * @brief Removes every node, keeping the memory for the next expression
+     */
+    void clear();
+};
@@ -0,0 +1,486 @@
+/**
+ * @file Formula.h
+ * @brief Header-only front end for formulas known at compile time
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header defines expression templates mirroring the node classes in BinaryOpNode.h,
+ * UnaryOpNode.h and FuncNode.h. A formula written with them in C++ source is a nested type
+ * instead of a tree of heap nodes: there is no tokenizing or parsing at startup and no virtual
+ * call per operation, and the compiler sees the whole formula and inlines it. Arity is checked
+ * when the formula is called. Formulas made of arithmetic, absolute values, integer powers and
+ * factorials of integers are constexpr and can be evaluated at compile time. Domain errors throw
+ * the same runtime_error messages as Node::evaluate, and are compile errors in a constant
+ * expression. Nothing here needs calculator_core.
+ *
+ * @code
+ * using namespace formula;
+ * constexpr auto x = var<0>;
+ * constexpr auto y = var<1>;
+ * constexpr auto area = 3 * x * x + y / 2;
+ * static_assert(area(2.0L, 4.0L) == 14);
+ * const auto wave = sin(x * 2) + pow(y, 0.5);
+ * long double value = wave(0.25L, 9.0L);
+ * @endcode
+ */
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace formula {
+
+/**
+ * @struct ScalarOf
+ * @brief Type a formula is evaluated in: the common type of floating-point arguments, long double otherwise
+ */
+template <typename... Args>
+struct ScalarOf {
+    using type = std::conditional_t<(std::is_floating_point_v<Args> && ...), std::common_type_t<Args...>, long double>;
+};
+
+template <>
+struct ScalarOf<> {
+    using type = long double;
+};
+
+/**
+ * @struct Formula
+ * @brief Base of every formula type, giving it a call operator
+ * @tparam Derived The formula type itself
+ *
+ * Derived types provide a static arity, one more than the highest variable index they read,
+ * and a constexpr evaluate() taking the variable values as an array.
+ */
+template <typename Derived>
+struct Formula {
+    /**
+     * @brief Evaluates the formula
+     * @param args Value of each variable, in index order. Integer arguments are evaluated as long double.
+     * @return The value of the formula, in the common floating-point type of the arguments
+     * @throws runtime_error on domain errors
+     */
+    template <typename... Args>
+    constexpr auto operator()(const Args... args) const {
+        static_assert(sizeof...(Args) >= Derived::arity, "formula called with fewer values than it has variables");
+        using Scalar = typename ScalarOf<Args...>::type;
+        const std::array<Scalar, sizeof...(Args)> values{static_cast<Scalar>(args)...};
+        return static_cast<const Derived&>(*this).evaluate(values);
+    }
+};
+
+/**
+ * @brief Whether a type is a formula
+ */
+template <typename T>
+constexpr bool isFormula = std::is_base_of_v<Formula<T>, T>;
+
+/**
+ * @brief Checks whether a value is an integer without std::floor, which is not constexpr
+ * @param x The value
+ * @return true if x is finite and integral, or infinite, matching x == std::floor(x)
+ */
+template <typename Scalar>
+constexpr bool isInteger(const Scalar x) {
+    if (x != x) { return false; } // NaN
+    if (x >= Scalar(9.2e18) || x <= Scalar(-9.2e18)) { return true; } // too large to have a fraction
+    return x == static_cast<Scalar>(static_cast<long long>(x));
+}
+
+/**
+ * @struct Constant
+ * @brief A literal number, like NumberNode
+ */
+struct Constant : Formula<Constant> {
+    static constexpr std::size_t arity = 0; ///< Reads no variables
+    long double value;                      ///< The number
+
+    constexpr explicit Constant(const long double value) : value(value) {}
+
+    template <typename Scalar, std::size_t N>
+    constexpr Scalar evaluate(const std::array<Scalar, N>&) const { return static_cast<Scalar>(value); }
+};
+
+/**
+ * @struct Variable
+ * @brief The value passed in position Index, like VariableNode
+ */
+template <std::size_t Index>
+struct Variable : Formula<Variable<Index>> {
+    static constexpr std::size_t arity = Index + 1; ///< Reads variable Index
+
+    template <typename Scalar, std::size_t N>
+    constexpr Scalar evaluate(const std::array<Scalar, N>& values) const { return values[Index]; }
+};
+
+/**
+ * @brief The variable passed in position Index
+ */
+template <std::size_t Index>
+constexpr Variable<Index> var{};
+
+/**
+ * @brief Wraps a number in a Constant and passes formulas through unchanged
+ */
+template <typename T>
+constexpr auto lift(const T& value) {
+    if constexpr (isFormula<T>) { return value; }
+    else { return Constant(static_cast<long double>(value)); }
+}
+
+/**
+ * @struct Unary
+ * @brief Storage shared by the one-operand formulas
+ */
+template <typename Operand>
+struct Unary {
+    static constexpr std::size_t arity = Operand::arity; ///< Variables read by the operand
+    Operand operand;                                     ///< Operand
+
+    constexpr explicit Unary(const Operand operand) : operand(operand) {}
+};
+
+/**
+ * @struct Binary
+ * @brief Storage shared by the two-operand formulas
+ */
+template <typename Left, typename Right>
+struct Binary {
+    static constexpr std::size_t arity = Left::arity > Right::arity ? Left::arity : Right::arity; ///< Variables read by either operand
+    Left left;   ///< Left operand
+    Right right; ///< Right operand
+
+    constexpr Binary(const Left left, const Right right) : left(left), right(right) {}
+};
+
+/**
+ * @struct Add
+ * @brief Sum of two formulas, like AddNode
+ */
+template <typename Left, typename Right>
+struct Add : Formula<Add<Left, Right>>, Binary<Left, Right> {
+    using Binary<Left, Right>::Binary;
+
+    template <typename Scalar, std::size_t N>
+    constexpr Scalar evaluate(const std::array<Scalar, N>& values) const {
+        return this->left.evaluate(values) + this->right.evaluate(values);
+    }
+};
+
+/**
+ * @struct Subtract
+ * @brief Difference of two formulas, like SubtractNode
+ */
+template <typename Left, typename Right>
+struct Subtract : Formula<Subtract<Left, Right>>, Binary<Left, Right> {
+    using Binary<Left, Right>::Binary;
+
+    template <typename Scalar, std::size_t N>
+    constexpr Scalar evaluate(const std::array<Scalar, N>& values) const {
+        return this->left.evaluate(values) - this->right.evaluate(values);
+    }
+};
+
+/**
+ * @struct Multiply
+ * @brief Product of two formulas, like MultiplyNode
+ */
+template <typename Left, typename Right>
+struct Multiply : Formula<Multiply<Left, Right>>, Binary<Left, Right> {
+    using Binary<Left, Right>::Binary;
+
+    template <typename Scalar, std::size_t N>
+    constexpr Scalar evaluate(const std::array<Scalar, N>& values) const {
+        return this->left.evaluate(values) * this->right.evaluate(values);
+    }
+};
+
+/**
+ * @struct Divide
+ * @brief Quotient of two formulas, like DivideNode
+ */
+template <typename Left, typename Right>
+struct Divide : Formula<Divide<Left, Right>>, Binary<Left, Right> {
+    using Binary<Left, Right>::Binary;
+
+    /**
+     * @throws runtime_error if the denominator is zero
+     */
+    template <typename Scalar, std::size_t N>
+    constexpr Scalar evaluate(const std::array<Scalar, N>& values) const {
+        const Scalar denominator = this->right.evaluate(values);
+        if (denominator == 0) { throw std::runtime_error("division by zero"); }
+        return this->left.evaluate(values) / denominator;
+    }
+};
+
+/**
+ * @struct Power
+ * @brief A formula raised to another, like PowerNode
+ */
+template <typename Left, typename Right>
+struct Power : Formula<Power<Left, Right>>, Binary<Left, Right> {
+    using Binary<Left, Right>::Binary;
+
+    /**
+     * @throws runtime_error if the base is negative and the exponent is not an integer
+     */
+    template <typename Scalar, std::size_t N>
+    Scalar evaluate(const std::array<Scalar, N>& values) const {
+        const Scalar base = this->left.evaluate(values);
+        const Scalar exponent = this->right.evaluate(values);
+        if (base < 0 && !isInteger(exponent)) { throw std::runtime_error("negative base with non-integer exponent"); }
+        return std::pow(base, exponent);
+    }
+};
+
+/**
+ * @struct IntegerPower
+ * @brief A formula raised to a fixed integer exponent by repeated squaring, so it stays constexpr
+ */
+template <int Exponent, typename Operand>
+struct IntegerPower : Formula<IntegerPower<Exponent, Operand>>, Unary<Operand> {
+    using Unary<Operand>::Unary;
+
+    template <typename Scalar, std::size_t N>
+    constexpr Scalar evaluate(const std::array<Scalar, N>& values) const {
+        Scalar base = this->operand.evaluate(values);
+        Scalar result = 1;
+        for (unsigned remaining = Exponent < 0 ? -Exponent : Exponent; remaining != 0; remaining >>= 1) {
+            if (remaining & 1) { result *= base; }
+            base *= base;
+        }
+        return Exponent < 0 ? 1 / result : result;
+    }
+};
+
+/**
+ * @struct Log
+ * @brief Logarithm of a formula in the base of another, like LogNode
+ */
+template <typename Left, typename Right>
+struct Log : Formula<Log<Left, Right>>, Binary<Left, Right> {
+    using Binary<Left, Right>::Binary;
+
+    /**
+     * @throws runtime_error if the base is 1 or non-positive, or if the value is non-positive
+     */
+    template <typename Scalar, std::size_t N>
+    Scalar evaluate(const std::array<Scalar, N>& values) const {
+        const Scalar value = this->left.evaluate(values);
+        const Scalar base = this->right.evaluate(values);
+        if (base == 1.0) { throw std::runtime_error("logarithm base of 1"); }
+        if (base <= 0.0 || value <= 0.0) { throw std::runtime_error("logarithm of non-positive value"); }
+        return std::log(value) / std::log(base);
+    }
+};
+
+/**
+ * @struct Negate
+ * @brief Negation of a formula, like NegateNode
+ */
+template <typename Operand>
+struct Negate : Formula<Negate<Operand>>, Unary<Operand> {
+    using Unary<Operand>::Unary;
+
+    template <typename Scalar, std::size_t N>
+    constexpr Scalar evaluate(const std::array<Scalar, N>& values) const { return -this->operand.evaluate(values); }
+};
+
+/**
+ * @struct Abs
+ * @brief Absolute value of a formula, like AbsNode
+ */
+template <typename Operand>
+struct Abs : Formula<Abs<Operand>>, Unary<Operand> {
+    using Unary<Operand>::Unary;
+
+    template <typename Scalar, std::size_t N>
+    constexpr Scalar evaluate(const std::array<Scalar, N>& values) const {
+        const Scalar value = this->operand.evaluate(values);
+        return value < 0 ? -value : value == 0 ? Scalar(0) : value; // also turns -0 into 0
+    }
+};
+
+/**
+ * @struct Factorial
+ * @brief Factorial of a formula, like FactorialNode
+ *
+ * Integers are multiplied out, which is constexpr and gives the same values as the
+ * factorial table; other values use the gamma function.
+ */
+template <typename Operand>
+struct Factorial : Formula<Factorial<Operand>>, Unary<Operand> {
+    using Unary<Operand>::Unary;
+
+    /**
+     * @throws runtime_error if the value is negative
+     */
+    template <typename Scalar, std::size_t N>
+    constexpr Scalar evaluate(const std::array<Scalar, N>& values) const {
+        const Scalar value = this->operand.evaluate(values);
+        if (value < 0) { throw std::runtime_error("cannot take factorial of negative number"); }
+        if (!isInteger(value)) { return std::tgamma(value + 1); }
+        Scalar result = 1;
+        for (Scalar factor = 2; factor <= value && result != std::numeric_limits<Scalar>::infinity(); ++factor) {
+            result *= factor;
+        }
+        return result;
+    }
+};
+
+// Mirrors one of the function nodes in FuncNode.h that accept any argument
+#define FORMULA_FUNCTION(Name, function)                                                     \
+    template <typename Operand>                                                              \
+    struct Name : Formula<Name<Operand>>, Unary<Operand> {                                   \
+        using Unary<Operand>::Unary;                                                         \
+        using Unary<Operand>::arity;                                                         \
+                                                                                             \
+        template <typename Scalar, std::size_t N>                                            \
+        Scalar evaluate(const std::array<Scalar, N>& values) const {                         \
+            return std::function(this->operand.evaluate(values));                            \
+        }                                                                                    \
+    };                                                                                       \
+                                                                                             \
+    template <typename T, std::enable_if_t<isFormula<T>, int> = 0>                           \
+    constexpr Name<T> function(const T& operand) { return Name<T>(operand); }
+
+FORMULA_FUNCTION(Sin, sin)
+FORMULA_FUNCTION(Cos, cos)
+FORMULA_FUNCTION(Tan, tan)
+FORMULA_FUNCTION(ArcSin, asin)
+FORMULA_FUNCTION(ArcCos, acos)
+FORMULA_FUNCTION(ArcTan, atan)
+FORMULA_FUNCTION(Exp, exp)
+
+#undef FORMULA_FUNCTION
+
+/**
+ * @struct Ln
+ * @brief Natural logarithm of a formula, like LnNode
+ */
+template <typename Operand>
+struct Ln : Formula<Ln<Operand>>, Unary<Operand> {
+    using Unary<Operand>::Unary;
+
+    /**
+     * @throws runtime_error if the value is non-positive
+     */
+    template <typename Scalar, std::size_t N>
+    Scalar evaluate(const std::array<Scalar, N>& values) const {
+        const Scalar value = this->operand.evaluate(values);
+        if (value <= 0.0) { throw std::runtime_error("logarithm of non-positive value"); }
+        return std::log(value);
+    }
+};
+
+/**
+ * @struct LogTen
+ * @brief Base-10 logarithm of a formula, like LogTenNode
+ */
+template <typename Operand>
+struct LogTen : Formula<LogTen<Operand>>, Unary<Operand> {
+    using Unary<Operand>::Unary;
+
+    /**
+     * @throws runtime_error if the value is non-positive
+     */
+    template <typename Scalar, std::size_t N>
+    Scalar evaluate(const std::array<Scalar, N>& values) const {
+        const Scalar value = this->operand.evaluate(values);
+        if (value <= 0.0) { throw std::runtime_error("logarithm of non-positive value"); }
+        return std::log10(value);
+    }
+};
+
+/**
+ * @struct Sqrt
+ * @brief Square root of a formula, like SqrtNode
+ */
+template <typename Operand>
+struct Sqrt : Formula<Sqrt<Operand>>, Unary<Operand> {
+    using Unary<Operand>::Unary;
+
+    /**
+     * @throws runtime_error if the value is negative
+     */
+    template <typename Scalar, std::size_t N>
+    Scalar evaluate(const std::array<Scalar, N>& values) const {
+        const Scalar value = this->operand.evaluate(values);
+        if (value < 0.0) { throw std::runtime_error("square root of negative value"); }
+        return std::sqrt(value);
+    }
+};
+
+/**
+ * @brief Whether at least one operand of an operator is a formula, so numbers alone keep their usual meaning
+ */
+template <typename L, typename R>
+using EnableFormula = std::enable_if_t<isFormula<L> || isFormula<R>, int>;
+
+template <typename L, typename R, EnableFormula<L, R> = 0>
+constexpr auto operator+(const L& left, const R& right) {
+    return Add<decltype(lift(left)), decltype(lift(right))>(lift(left), lift(right));
+}
+
+template <typename L, typename R, EnableFormula<L, R> = 0>
+constexpr auto operator-(const L& left, const R& right) {
+    return Subtract<decltype(lift(left)), decltype(lift(right))>(lift(left), lift(right));
+}
+
+template <typename L, typename R, EnableFormula<L, R> = 0>
+constexpr auto operator*(const L& left, const R& right) {
+    return Multiply<decltype(lift(left)), decltype(lift(right))>(lift(left), lift(right));
+}
+
+template <typename L, typename R, EnableFormula<L, R> = 0>
+constexpr auto operator/(const L& left, const R& right) {
+    return Divide<decltype(lift(left)), decltype(lift(right))>(lift(left), lift(right));
+}
+
+template <typename T, std::enable_if_t<isFormula<T>, int> = 0>
+constexpr Negate<T> operator-(const T& operand) { return Negate<T>(operand); }
+
+/**
+ * @brief The base raised to the exponent; ^ is not used because it binds more loosely than + in C++
+ */
+template <typename L, typename R, EnableFormula<L, R> = 0>
+constexpr auto pow(const L& base, const R& exponent) {
+    return Power<decltype(lift(base)), decltype(lift(exponent))>(lift(base), lift(exponent));
+}
+
+/**
+ * @brief The operand raised to a fixed integer exponent, evaluated by multiplication
+ */
+template <int Exponent, typename T, std::enable_if_t<isFormula<T>, int> = 0>
+constexpr IntegerPower<Exponent, T> pow(const T& operand) { return IntegerPower<Exponent, T>(operand); }
+
+/**
+ * @brief Logarithm of value in the given base, mirroring log(x, y) in the calculator
+ */
+template <typename L, typename R, EnableFormula<L, R> = 0>
+constexpr auto log(const L& value, const R& base) {
+    return Log<decltype(lift(value)), decltype(lift(base))>(lift(value), lift(base));
+}
+
+template <typename T, std::enable_if_t<isFormula<T>, int> = 0>
+constexpr Abs<T> abs(const T& operand) { return Abs<T>(operand); }
+
+template <typename T, std::enable_if_t<isFormula<T>, int> = 0>
+constexpr Factorial<T> factorial(const T& operand) { return Factorial<T>(operand); }
+
+template <typename T, std::enable_if_t<isFormula<T>, int> = 0>
+constexpr Ln<T> ln(const T& operand) { return Ln<T>(operand); }
+
+template <typename T, std::enable_if_t<isFormula<T>, int> = 0>
+constexpr LogTen<T> log10(const T& operand) { return LogTen<T>(operand); }
+
+template <typename T, std::enable_if_t<isFormula<T>, int> = 0>
+constexpr Sqrt<T> sqrt(const T& operand) { return Sqrt<T>(operand); }
+
+} // namespace formula
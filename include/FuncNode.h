@@ -14,10 +14,12 @@
 #pragma once
 
 #include "Node.h"
+#include "Bytecode.h"
+#include "Optimizer.h"
 
 #include <cmath>
+#include <cstdint>
 #include <memory>
-#include <map>
 #include <stdexcept>
 #include <string>
 
@@ -43,10 +45,10 @@ public:
 
     /**
      * @brief Evaluate the sine of the child node
-     * @param variables Map of variable names to values
+     * @param variables Table of variable values
      * @return Sine of the child node's evaluated value
      */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
+    long double evaluate(const SymbolTable& variables) const override {
         return std::sin(child->evaluate(variables));
     }
 
@@ -57,6 +59,32 @@ public:
     Node* clone() const override {
         return new SinNode(std::unique_ptr<Node>(child->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the sine
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        return compiler.emit(OpCode::SIN, child->compile(compiler));
+    }
+
+    /**
+     * @brief Simplifies the operand and folds the node if it is constant
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(child, constants);
+        return foldConstant(*this, {child.get()});
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return cos of the operand times its derivative
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
 };
 
 /**
@@ -80,10 +108,10 @@ public:
 
     /**
      * @brief Evaluate the cosine of the child node
-     * @param variables Map of variable names to values
+     * @param variables Table of variable values
      * @return Cosine of the child node's evaluated value
      */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
+    long double evaluate(const SymbolTable& variables) const override {
         return std::cos(child->evaluate(variables));
     }
 
@@ -94,6 +122,32 @@ public:
     Node* clone() const override {
         return new CosNode(std::unique_ptr<Node>(child->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the cosine
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        return compiler.emit(OpCode::COS, child->compile(compiler));
+    }
+
+    /**
+     * @brief Simplifies the operand and folds the node if it is constant
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(child, constants);
+        return foldConstant(*this, {child.get()});
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return Minus sin of the operand times its derivative
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
 };
 
 /**
@@ -117,10 +171,10 @@ public:
 
     /**
      * @brief Evaluate the tangent of the child node
-     * @param variables Map of variable names to values
+     * @param variables Table of variable values
      * @return Tangent of the child node's evaluated value
      */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
+    long double evaluate(const SymbolTable& variables) const override {
         return std::tan(child->evaluate(variables));
     }
 
@@ -131,6 +185,32 @@ public:
     Node* clone() const override {
         return new TanNode(std::unique_ptr<Node>(child->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the tangent
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        return compiler.emit(OpCode::TAN, child->compile(compiler));
+    }
+
+    /**
+     * @brief Simplifies the operand and folds the node if it is constant
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(child, constants);
+        return foldConstant(*this, {child.get()});
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return The operand's derivative over the square of its cosine
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
 };
 
 /**
@@ -154,10 +234,10 @@ public:
 
     /**
      * @brief Evaluate the arcsine of the child node
-     * @param variables Map of variable names to values
+     * @param variables Table of variable values
      * @return Arcsine of the child node's evaluated value
      */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
+    long double evaluate(const SymbolTable& variables) const override {
         return std::asin(child->evaluate(variables));
     }
 
@@ -168,6 +248,32 @@ public:
     Node* clone() const override {
         return new ArcSinNode(std::unique_ptr<Node>(child->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the arcsine
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        return compiler.emit(OpCode::ASIN, child->compile(compiler));
+    }
+
+    /**
+     * @brief Simplifies the operand and folds the node if it is constant
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(child, constants);
+        return foldConstant(*this, {child.get()});
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return The operand's derivative over sqrt(1 - x^2)
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
 };
 
 /**
@@ -192,10 +298,10 @@ public:
 
     /**
      * @brief Evaluate the arccosine of the child node
-     * @param variables Map of variable names to values
+     * @param variables Table of variable values
      * @return Arccosine of the child node's evaluated value
      */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
+    long double evaluate(const SymbolTable& variables) const override {
         return std::acos(child->evaluate(variables));
     }
 
@@ -206,6 +312,32 @@ public:
     Node* clone() const override {
         return new ArcCosNode(std::unique_ptr<Node>(child->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the arccosine
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        return compiler.emit(OpCode::ACOS, child->compile(compiler));
+    }
+
+    /**
+     * @brief Simplifies the operand and folds the node if it is constant
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(child, constants);
+        return foldConstant(*this, {child.get()});
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return Minus the operand's derivative over sqrt(1 - x^2)
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
 };
 
 /**
@@ -230,10 +362,10 @@ public:
 
     /**
      * @brief Evaluate the arctangent of the child node
-     * @param variables Map of variable names to values
+     * @param variables Table of variable values
      * @return Arctangent of the child node's evaluated value
      */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
+    long double evaluate(const SymbolTable& variables) const override {
         return std::atan(child->evaluate(variables));
     }
 
@@ -244,6 +376,32 @@ public:
     Node* clone() const override {
         return new ArcTanNode(std::unique_ptr<Node>(child->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the arctangent
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        return compiler.emit(OpCode::ATAN, child->compile(compiler));
+    }
+
+    /**
+     * @brief Simplifies the operand and folds the node if it is constant
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(child, constants);
+        return foldConstant(*this, {child.get()});
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return The operand's derivative over 1 + x^2
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
 };
 
 /**
@@ -268,10 +426,10 @@ public:
 
     /**
      * @brief Evaluate e raised to the power of the child node's value
-     * @param variables Map of variable names to values
+     * @param variables Table of variable values
      * @return e^(child node's evaluated value)
      */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
+    long double evaluate(const SymbolTable& variables) const override {
         return std::exp(child->evaluate(variables));
     }
 
@@ -282,6 +440,32 @@ public:
     Node* clone() const override {
         return new ExpNode(std::unique_ptr<Node>(child->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the exponential
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        return compiler.emit(OpCode::EXP, child->compile(compiler));
+    }
+
+    /**
+     * @brief Simplifies the operand and folds the node if it is constant
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(child, constants);
+        return foldConstant(*this, {child.get()});
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return This node times the operand's derivative
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
 };
 
 /**
@@ -307,11 +491,11 @@ public:
 
     /**
      * @brief Evaluate the natural logarithm of the child node's value
-     * @param variables Map of variable names to values
+     * @param variables Table of variable values
      * @return Natural logarithm of the child node's evaluated value
      * @throws std::runtime_error if the value is non-positive
      */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
+    long double evaluate(const SymbolTable& variables) const override {
         long double val = child->evaluate(variables);
         if (val <= 0.0) {
             throw std::runtime_error("logarithm of non-positive value");
@@ -326,6 +510,32 @@ public:
     Node* clone() const override {
         return new LnNode(std::unique_ptr<Node>(child->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the natural logarithm
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        return compiler.emit(OpCode::LN, child->compile(compiler));
+    }
+
+    /**
+     * @brief Simplifies the operand and folds the node if it is constant
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(child, constants);
+        return foldConstant(*this, {child.get()});
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return The operand's derivative over the operand
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
 };
 
 /**
@@ -351,11 +561,11 @@ public:
 
     /**
      * @brief Evaluate the base-10 logarithm of the child node's value
-     * @param variables Map of variable names to values
+     * @param variables Table of variable values
      * @return Base-10 logarithm of the child node's evaluated value
      * @throws std::runtime_error if the value is non-positive
      */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
+    long double evaluate(const SymbolTable& variables) const override {
         long double val = child->evaluate(variables);
         if (val <= 0.0) {
             throw std::runtime_error("logarithm of non-positive value");
@@ -370,6 +580,32 @@ public:
     Node* clone() const override {
         return new LogTenNode(std::unique_ptr<Node>(child->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the base-10 logarithm
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        return compiler.emit(OpCode::LOGTEN, child->compile(compiler));
+    }
+
+    /**
+     * @brief Simplifies the operand and folds the node if it is constant
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(child, constants);
+        return foldConstant(*this, {child.get()});
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return The operand's derivative over the operand times ln 10
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
 };
 
 /**
@@ -397,19 +633,20 @@ public:
 
     /**
      * @brief Evaluate the logarithm of a value with a specified base
-     * @param variables Map of variable names to values
+     * @param variables Table of variable values
      * @return Logarithm of the value with the specified base
      * @throws std::runtime_error if the base is 1 or non-positive, or if the value is non-positive
      */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
+    long double evaluate(const SymbolTable& variables) const override {
         long double baseValue = base->evaluate(variables);
         if (baseValue == 1.0) {
             throw std::runtime_error("logarithm base of 1");
         }
-        if (baseValue <= 0.0 || val->evaluate(variables) <= 0.0) {
+        const long double value = val->evaluate(variables);
+        if (baseValue <= 0.0 || value <= 0.0) {
             throw std::runtime_error("logarithm of non-positive value");
         }
-        return std::log(val->evaluate(variables)) / log(baseValue);
+        return std::log(value) / std::log(baseValue);
     }
 
     /**
@@ -419,6 +656,35 @@ public:
     Node* clone() const override {
         return new LogNode(std::unique_ptr<Node>(val->clone()), std::unique_ptr<Node>(base->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the logarithm
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        const std::uint32_t baseRegister = base->compile(compiler);
+        const std::uint32_t valRegister = val->compile(compiler);
+        return compiler.emit(OpCode::LOG, valRegister, baseRegister);
+    }
+
+    /**
+     * @brief Simplifies the operands and folds the node if both are constant
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(base, constants);
+        simplifyChild(val, constants);
+        return foldConstant(*this, {base.get(), val.get()});
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return The derivative of ln(value) / ln(base) by the quotient rule
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
 };
 
 /**
@@ -444,11 +710,11 @@ public:
 
     /**
      * @brief Evaluate the square root of the child node's value
-     * @param variables Map of variable names to values
+     * @param variables Table of variable values
      * @return Square root of the child node's evaluated value
      * @throws std::runtime_error if the value is negative
      */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
+    long double evaluate(const SymbolTable& variables) const override {
         long double val = child->evaluate(variables);
         if (val < 0.0) {
             throw std::runtime_error("square root of negative value");
@@ -463,4 +729,30 @@ public:
     Node* clone() const override {
         return new SqrtNode(std::unique_ptr<Node>(child->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the square root
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        return compiler.emit(OpCode::SQRT, child->compile(compiler));
+    }
+
+    /**
+     * @brief Simplifies the operand and folds the node if it is constant
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(child, constants);
+        return foldConstant(*this, {child.get()});
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return The operand's derivative over twice this node
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
 };
@@ -0,0 +1,149 @@
+/**
+ * @file Jit.h
+ * @brief Native code generation for frequently evaluated programs
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header defines NativeProgram, which translates a compiled Program into x86-64
+ * machine code, and JitTier, which counts how often a program is run and translates it
+ * once the count crosses JIT_THRESHOLD. Programs evaluated only a few times never pay for
+ * code generation, and the hot ones skip instruction dispatch entirely. Where native code
+ * is not supported the translation simply fails and the bytecode evaluator keeps going.
+ */
+
+#pragma once
+
+#include "Bytecode.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+#if defined(CALCULATOR_JIT) && defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define CALCULATOR_JIT_NATIVE 1 ///< Defined when this build can generate and run native code
+#endif
+
+/**
+ * @class NativeProgram
+ * @brief A program translated into machine code for one precision
+ *
+ * Every register of the program gets a slot in the native stack frame, constants and
+ * variables are read straight from the constant pool and the caller's slot array, and
+ * arithmetic, negation, absolute value and square root are emitted inline, using x87
+ * instructions for long double and SSE for double and float. The remaining operations
+ * call into the same library functions the bytecode evaluator uses, with identical domain
+ * checks, so both paths return the same values and statuses.
+ */
+class NativeProgram {
+private:
+    void* memory = nullptr;      ///< Mapping holding the constants followed by the code
+    std::size_t mappedSize = 0;  ///< Size of the mapping in bytes
+    const void* entry = nullptr; ///< Start of the generated function
+    Precision precision;         ///< Scalar type the code was generated for
+
+    /**
+     * @brief Takes ownership of an executable mapping
+     * @param memory The mapping
+     * @param mappedSize Size of the mapping in bytes
+     * @param entry Start of the generated function inside the mapping
+     * @param precision Scalar type the code works in
+     */
+    NativeProgram(void* memory, std::size_t mappedSize, const void* entry, Precision precision);
+
+public:
+
+    NativeProgram(const NativeProgram&) = delete;
+    NativeProgram& operator=(const NativeProgram&) = delete;
+    ~NativeProgram();
+
+    /**
+     * @brief Translates a program into machine code
+     * @tparam Scalar long double, double or float, the type all arithmetic is done in
+     * @param program The program to translate
+     * @return The native program, or nullptr if this build or platform cannot generate code for it
+     */
+    template <typename Scalar>
+    static std::unique_ptr<NativeProgram> compile(const Program& program);
+
+    /**
+     * @brief Runs the generated code, with the same contract as Program::run
+     * @tparam Scalar The type the program was compiled for
+     * @param slots Variable values, indexed by slot
+     * @param value Set to the value of the expression if the status is OK
+     * @return OK, or the first domain error encountered
+     */
+    template <typename Scalar>
+    EvalStatus run(const Scalar* slots, Scalar& value) const {
+        using Function = EvalStatus (*)(const Scalar*, Scalar*);
+        return reinterpret_cast<Function>(const_cast<void*>(entry))(slots, &value);
+    }
+
+    /**
+     * @return The precision the code was generated for
+     */
+    [[nodiscard]] Precision getPrecision() const { return precision; }
+};
+
+/**
+ * @class JitTier
+ * @brief Evaluation counts and native code of one program, shared by its copies
+ *
+ * Counting is deliberately racy: concurrent evaluations may lose increments, but the
+ * count only ever grows by one at a time, so some evaluation always observes exactly
+ * JIT_THRESHOLD and triggers the translation, which happens at most once per precision.
+ */
+class JitTier {
+private:
+    std::array<std::atomic<std::uint32_t>, 3> evaluations{};        ///< Runs seen so far, per precision
+    std::array<std::atomic<const NativeProgram*>, 3> native{};      ///< Published native code, per precision
+    std::array<std::unique_ptr<NativeProgram>, 3> owned;             ///< Owner of the native code
+    std::array<bool, 3> attempted{};                                ///< Whether translation was tried, per precision
+    std::mutex compiling;                                           ///< Serializes translation
+
+    /**
+     * @brief Translates the program unless that was already tried
+     * @tparam Scalar The precision to translate for
+     * @param program The program this tier belongs to
+     */
+    template <typename Scalar>
+    void tierUp(const Program& program);
+
+public:
+
+    static constexpr std::uint32_t JIT_THRESHOLD = 1000; ///< Evaluations before a program is translated
+
+    /**
+     * @tparam Scalar The precision the program is evaluated in
+     * @return The precision's index into the per-precision arrays
+     */
+    template <typename Scalar>
+    static constexpr std::size_t index() {
+        return static_cast<std::size_t>(std::is_same_v<Scalar, long double> ? Precision::LONG_DOUBLE
+                                        : std::is_same_v<Scalar, double>    ? Precision::DOUBLE
+                                                                            : Precision::FLOAT);
+    }
+
+    /**
+     * @tparam Scalar The precision the program is evaluated in
+     * @return The native code for the precision, or nullptr if the program is not hot yet
+     */
+    template <typename Scalar>
+    [[nodiscard]] const NativeProgram* find() const { return native[index<Scalar>()].load(std::memory_order_acquire); }
+
+    /**
+     * @brief Counts one interpreted evaluation, translating the program when it becomes hot
+     * @tparam Scalar The precision the program is evaluated in
+     * @param program The program this tier belongs to
+     */
+    template <typename Scalar>
+    void record(const Program& program) {
+        std::atomic<std::uint32_t>& count = evaluations[index<Scalar>()];
+        const std::uint32_t seen = count.load(std::memory_order_relaxed) + 1;
+        count.store(seen, std::memory_order_relaxed);
+        if (seen == JIT_THRESHOLD) { tierUp<Scalar>(program); }
+    }
+};
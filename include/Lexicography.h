@@ -5,14 +5,20 @@
  * @date 2025-8-18
  *
  * This header defines the TokenType enum and the Token struct used for
- * tokenizing the input mathematical expressions. It also declares the
- * tokenize function that converts an input string into a vector of Tokens.
+ * tokenizing the input mathematical expressions. The Lexer class hands out
+ * tokens one at a time, from a string or incrementally from a stream, and
+ * the tokenize function collects them into a vector of Tokens.
+ * Tokens do not copy the input: each one is a view into the text it was
+ * read from, and numeric literals are converted once while lexing.
  *
  */
 
 #pragma once
 
+#include <cstddef>
+#include <iosfwd>
 #include <string>
+#include <string_view>
 #include <vector>
 
 
@@ -41,38 +47,102 @@ enum class TokenType {
     ABS,       ///< Absolute value operator (|)
     END,       ///< End of input
     PRESERVE,  ///< Preserve command
-    REMOVE     ///< Remove command
+    REMOVE,    ///< Remove command
+    RANGE      ///< Range operator (..) between the bounds of a sweep
 };
 
 /**
  * @struct Token
  * @brief Represents a token in a mathematical expression
  *
- * This struct encapsulates a token's type and its string value.
+ * This struct encapsulates a token's type, its text and, for numbers, its value.
  * It is used in the tokenization process to represent individual
- * components of the input expression.
+ * components of the input expression. The text is a view into the input
+ * passed to tokenize(), so the input must outlive the token.
  */
 struct Token {
-    TokenType type;    ///< Type of the token
-    std::string value; ///< String value of the token
+    TokenType type;         ///< Type of the token
+    std::string_view value; ///< Text of the token in the input
+    long double number;     ///< Value of a NUMBER token, 0 for other types
 
     /**
      * @brief Construct a new Token object
      * @param type The type of the token
-     * @param value The string value of the token
+     * @param value The text of the token
+     * @param number The numeric value for NUMBER tokens
      */
-    Token(TokenType type, const std::string& value) : type(type), value(value) {}
+    Token(TokenType type, std::string_view value, long double number = 0) : type(type), value(value), number(number) {}
+};
+
+/**
+ * @class Lexer
+ * @brief Produces the tokens of an expression one at a time, on demand
+ *
+ * A Lexer reads either a string that is already in memory or a stream. Stream input is read
+ * in chunks as the tokens are requested, and text that has already been turned into tokens is
+ * dropped when the next chunk arrives, so only the chunk and the token being read stay in memory.
+ * A token's text stays valid until the next call to next() on a stream, and for as long as the
+ * input string lives otherwise.
+ */
+class Lexer {
+private:
+    std::string_view text;          ///< Input that can be read without waiting for the stream
+    std::istream* stream = nullptr; ///< Stream the input comes from, or nullptr for string input
+    std::string buffer;             ///< Unconsumed stream input; text views it
+    std::size_t chunkSize = 0;      ///< Bytes requested from the stream at a time
+    std::size_t position = 0;       ///< Index in text of the next character to read
+    std::size_t tokenStart = 0;     ///< Index in text of the token being read
+
+    /**
+     * @brief Makes sure the character at position is available, reading from the stream if needed
+     * @return false if the input ends before position
+     * @details Refilling moves the current token to the front of the buffer, so position may change.
+     */
+    bool available();
+
+    /**
+     * @brief Drops the text before the current token and reads the next chunk of the stream
+     * @return false if there is no stream or it has no more input
+     */
+    bool refill();
+
+    /**
+     * @return true if the character after position is a '.', so a '.' at position starts a range operator
+     */
+    bool rangeAhead();
+
+public:
+
+    /**
+     * @brief Construct a Lexer over a string
+     * @param input The expression. It must stay alive and unchanged while its tokens are in use.
+     */
+    explicit Lexer(std::string_view input);
+
+    /**
+     * @brief Construct a Lexer that reads the expression from a stream until it ends
+     * @param input The stream to read. It is read no further ahead than chunkSize bytes past the current token.
+     * @param chunkSize Bytes to read at a time
+     */
+    explicit Lexer(std::istream& input, std::size_t chunkSize = 1 << 16);
+
+    /**
+     * @brief Reads the next token
+     * @return The token, or an END token once the input is exhausted, and from then on
+     * @throws std::runtime_error if an unrecognized character or a malformed number is encountered
+     */
+    Token next();
 };
 
 /**
  * @brief Tokenizes an input mathematical expression string
- * @param input The input expression as a string
+ * @param input The input expression. It must stay alive and unchanged while the tokens are in use.
  * @return A vector of Tokens representing the tokenized expression
- * @throws std::runtime_error if an unrecognized character is encountered
+ * @throws std::runtime_error if an unrecognized character or a malformed number is encountered
  *
- * This function processes the input string character by character,
- * identifying and creating tokens for numbers, variables, functions,
- * operators, parentheses, and special commands. It returns a vector
- * of Tokens that can be used for further parsing and evaluation.
+ * This function runs a Lexer over the whole input, identifying and creating
+ * tokens for numbers, variables, functions, operators, parentheses, and special
+ * commands. It returns a vector of Tokens that can be used for further parsing
+ * and evaluation.
  */
-std::vector<Token> tokenize(const std::string& input);
+std::vector<Token> tokenize(std::string_view input);
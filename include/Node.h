@@ -5,15 +5,26 @@
  * @date 2025-8-18
  * 
  * @details This header defines the abstract base class Node, which is the base for all node types in the AST.
- * It declares pure virtual functions for evaluating the node, cloning it, and destructing it.
+ * It declares pure virtual functions for evaluating the node, cloning it, compiling it to bytecode,
+ * simplifying it, differentiating it, and destructing it, and virtual functions reading it as a polynomial
+ * and as the terms of a sum.
  * All node classes inherit from this class and implement these functions.
 */
 
 #pragma once
 
+#include "NodeArena.h"
+#include "SymbolTable.h"
+
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <map>
 #include <memory>
+#include <vector>
+
+class Compiler;
+class Polynomial;
+struct SumTerm;
 
 /**
  * @class Node
@@ -32,13 +43,26 @@ public:
     */
     virtual ~Node() = default;
 
+    /**
+     * @brief Allocates memory for a node of any derived type
+     * @param size Size of the node
+     * @return Memory from the thread's active NodeArena, or from the heap if there is none
+     */
+    static void* operator new(const std::size_t size) { return NodeArena::allocateNode(size); }
+
+    /**
+     * @brief Releases memory obtained from operator new
+     * @param pointer The node's memory
+     */
+    static void operator delete(void* pointer) noexcept { NodeArena::deallocateNode(pointer); }
+
     /**
      * @brief Pure virtual function to evaluate the root expression at this node.
-     * @param variables Map of variable names to their values
+     * @param variables Table of variable values
      * @return The evaluated result as a long double
 	 * @details Must be overridden by all derived classes to provide specific logic for evaluation.
     */
-    virtual long double evaluate(const std::map<std::string, long double>& variables) const = 0;
+    virtual long double evaluate(const SymbolTable& variables) const = 0;
 
     /**
 	 * @brief Pure virtual function to create deep copy of the node
@@ -47,4 +71,56 @@ public:
 	 * The caller is responsible for managing the memory of the cloned node.
      */ 
     virtual Node* clone() const = 0;
+
+    /**
+     * @brief Pure virtual function to lower the node into bytecode
+     * @param compiler Compiler receiving the emitted instructions
+     * @return Index of the register that holds the node's value
+     * @details Children are compiled before the node emits its own instruction, in the same
+     * order evaluate() visits them, so both paths report the same error first.
+     */
+    virtual std::uint32_t compile(Compiler& compiler) const = 0;
+
+    /**
+     * @brief Pure virtual function to simplify the subtree rooted at this node
+     * @param constants Table whose preserved variables, such as pi, are fixed before evaluation
+     * @return A node to replace this one with, or nullptr to keep this node
+     * @details Children are simplified in place first. The replacement may be one of this
+     * node's own children, so the caller must swap it in before touching this node again.
+     */
+    virtual std::unique_ptr<Node> simplify(const SymbolTable& constants) = 0;
+
+    /**
+     * @brief Pure virtual function to differentiate the subtree rooted at this node
+     * @param variable Interned id of the variable to differentiate with respect to
+     * @return A new tree evaluating to the derivative, a NumberNode holding 0 if the
+     * subtree does not depend on the variable
+     * @details The derivative copies the subtrees it needs from this one instead of
+     * referring to them, so compiling both into one program lets value numbering share
+     * every subexpression they have in common. The rules are defined in Derivative.cpp.
+     */
+    virtual std::unique_ptr<Node> derivative(SymbolId variable) const = 0;
+
+    /**
+     * @brief Checks whether the node is a numeric constant
+     * @param value Set to the constant's value if it is one
+     * @return true if the node always evaluates to the same number
+     */
+    virtual bool isConstant(long double& /*value*/) const { return false; }
+
+    /**
+     * @brief Reads the subtree rooted at this node as a polynomial in one variable
+     * @param out Set to the polynomial if the subtree is one
+     * @return true if the subtree is built from constants, one variable, sums and differences,
+     * and products and integer powers of single terms. The rules are defined in Polynomial.cpp.
+     */
+    virtual bool polynomial(Polynomial& /*out*/) const { return false; }
+
+    /**
+     * @brief Lists the operands of the chain of additions and subtractions rooted at this node
+     * @param terms Receives the operands from left to right. Only the left operand of each sum
+     * or difference is followed, so a parenthesized sum on the right is one term.
+     * @details Any other node is a single term; the rules are defined in Polynomial.cpp.
+     */
+    virtual void sumTerms(std::vector<SumTerm>& terms) const;
 };
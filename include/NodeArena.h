@@ -0,0 +1,126 @@
+/**
+ * @file NodeArena.h
+ * @brief Bump allocator for AST nodes
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header defines the NodeArena class, which hands out memory for AST nodes from
+ * a few large contiguous blocks instead of one heap allocation per node. Node overrides
+ * operator new and operator delete to route through the arena that is active on the
+ * current thread, so std::make_unique and clone() need no changes. All nodes of one
+ * expression end up next to each other in memory and are released together.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * @class NodeArena
+ * @brief Region of memory that node allocations are carved out of
+ *
+ * While a NodeArena::Scope is alive, every node created on that thread is placed in the
+ * arena. Deleting such a node runs its destructor but does not free memory; the memory
+ * is reclaimed all at once by reset() or when the arena is destroyed. Every node
+ * allocated from an arena must therefore be destroyed before the arena is reset.
+ * Nodes created outside of any scope use the regular heap.
+ */
+class NodeArena {
+private:
+    /**
+     * @struct Block
+     * @brief One contiguous chunk of arena memory
+     */
+    struct Block {
+        std::unique_ptr<std::byte[]> data; ///< Start of the chunk
+        std::size_t size;                  ///< Capacity in bytes
+        std::size_t used;                  ///< Bytes handed out so far
+    };
+
+    std::vector<Block> blocks;  ///< Chunks in allocation order, the last one is being filled
+    std::size_t blockSize;      ///< Capacity of newly created chunks
+    std::size_t liveNodes = 0;  ///< Nodes allocated and not yet deleted
+
+public:
+
+    /**
+     * @brief Construct a new NodeArena
+     * @param blockSize Size in bytes of each chunk requested from the heap
+     */
+    explicit NodeArena(std::size_t blockSize = 4096);
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    /**
+     * @brief Allocates memory for a node
+     * @param bytes Number of bytes needed
+     * @return Pointer aligned for any node type
+     */
+    void* allocate(std::size_t bytes);
+
+    /**
+     * @brief Records that a node allocated from this arena was deleted
+     */
+    void release() { --liveNodes; }
+
+    /**
+     * @brief Frees every allocation at once, keeping the first chunk for reuse
+     * @throws logic_error if nodes allocated from the arena are still alive
+     */
+    void reset();
+
+    /**
+     * @return The number of nodes allocated from the arena that are still alive
+     */
+    [[nodiscard]] std::size_t live() const { return liveNodes; }
+
+    /**
+     * @return The arena active on the calling thread, or nullptr if nodes go to the heap
+     */
+    static NodeArena* current();
+
+    /**
+     * @brief Allocates a node from the current arena, or the heap if there is none
+     * @param bytes Size of the node
+     * @return Pointer to memory for the node
+     * @details Each allocation is preceded by a small header recording where it came from,
+     * so deallocate() works no matter which arena, if any, is active when the node dies.
+     */
+    static void* allocateNode(std::size_t bytes);
+
+    /**
+     * @brief Releases memory obtained from allocateNode()
+     * @param pointer The node's memory
+     */
+    static void deallocateNode(void* pointer) noexcept;
+
+    /**
+     * @class Scope
+     * @brief RAII guard that makes an arena current on this thread
+     *
+     * Scopes nest; the previously active arena is restored on destruction.
+     */
+    class Scope {
+    private:
+        NodeArena* previous; ///< Arena that was active before this scope
+
+    public:
+
+        /**
+         * @brief Activates the arena for the current thread
+         * @param arena The arena new nodes should be placed in
+         */
+        explicit Scope(NodeArena& arena);
+
+        /**
+         * @brief Restores the previously active arena
+         */
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+};
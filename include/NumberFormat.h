@@ -0,0 +1,87 @@
+/**
+ * @file NumberFormat.h
+ * @brief Conversions between numbers and text on the input and output paths
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header declares the functions that turn numeric literals into values and values
+ * into text, built on std::from_chars and std::to_chars. They never allocate a stream or
+ * touch the locale, and append straight to a caller-owned buffer, so formatting a result
+ * costs a few dozen nanoseconds instead of a temporary string per number.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+enum class Precision : std::uint8_t; // defined in Bytecode.h
+
+/**
+ * @brief Significant digits results are printed with unless configured otherwise, the same as operator<<
+ */
+constexpr int DEFAULT_DIGITS = 6;
+
+/**
+ * @brief Digit setting that prints the shortest text which reads back as the same value
+ */
+constexpr int SHORTEST_DIGITS = 0;
+
+/**
+ * @brief Largest number of significant digits accepted by appendNumber()
+ */
+constexpr int MAX_DIGITS = 40;
+
+/**
+ * @brief Converts the text of a numeric literal
+ * @param text Digits with at most one decimal point, as produced by the lexer
+ * @return The value, read as a double
+ * @throws runtime_error if the text is not a number or is out of range
+ */
+long double parseNumber(std::string_view text);
+
+/**
+ * @brief Appends a value with a given number of significant digits
+ * @param out Buffer the text is appended to
+ * @param value The value to format
+ * @param digits Significant digits, from 1 to MAX_DIGITS, or SHORTEST_DIGITS for the shortest round-trip text
+ * @details With DEFAULT_DIGITS the text is identical to printf's %Lg, and so to operator<< with
+ * default stream settings: trailing zeros are dropped and large or small magnitudes use an exponent.
+ */
+void appendNumber(std::string& out, long double value, int digits = DEFAULT_DIGITS);
+
+/**
+ * @brief Appends a double like the long double overload
+ * @param out Buffer the text is appended to
+ * @param value The value to format
+ * @param digits Significant digits, from 1 to MAX_DIGITS, or SHORTEST_DIGITS for the shortest text that reads back as this double
+ */
+void appendNumber(std::string& out, double value, int digits = DEFAULT_DIGITS);
+
+/**
+ * @brief Appends a float like the long double overload
+ * @param out Buffer the text is appended to
+ * @param value The value to format
+ * @param digits Significant digits, from 1 to MAX_DIGITS, or SHORTEST_DIGITS for the shortest text that reads back as this float
+ */
+void appendNumber(std::string& out, float value, int digits = DEFAULT_DIGITS);
+
+/**
+ * @brief Appends a result of an engine, which the calculator stores as a long double
+ * @param out Buffer the text is appended to
+ * @param value The value to format
+ * @param digits Significant digits, from 1 to MAX_DIGITS, or SHORTEST_DIGITS for the shortest round-trip text
+ * @param precision The engine the value was computed in
+ * @details A value the engine's type represents exactly is formatted as that type, so its shortest text is the
+ * shortest that reads back in that engine; any other value is formatted as a long double.
+ */
+void appendNumber(std::string& out, long double value, int digits, Precision precision);
+
+/**
+ * @brief Appends a value in fixed notation with six decimals, then drops trailing zeros and a trailing point
+ * @param out Buffer the text is appended to
+ * @param value The value to format
+ * @details Identical to std::to_string followed by trimming, which is how tokens have always been echoed.
+ */
+void appendTrimmed(std::string& out, long double value);
@@ -12,7 +12,9 @@
 #pragma once
 
 #include "Node.h"
-#include <map>
+#include "Bytecode.h"
+#include <cstdint>
+#include <memory>
 #include <string>
 
 /**
@@ -35,10 +37,10 @@ public:
 
     /**
      * @brief Evaluate the numeric constant
-     * @param variables Map of variable names to values (not used in this node)
+     * @param variables Table of variable values (not used in this node)
      * @return The numeric value of the constant
      */
-    long double evaluate(const std::map<std::string, long double>& variables) const override { return value; }
+    long double evaluate(const SymbolTable& /*variables*/) const override { return value; }
 
     /**
      * @brief Creates a deep copy of the NumberNode
@@ -47,4 +49,44 @@ public:
     Node* clone() const override {
         return new NumberNode(value);
     }
+
+    /**
+     * @brief Lowers the constant into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the constant
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        return compiler.emitConstant(value);
+    }
+
+    /**
+     * @brief Constants are already as simple as possible
+     * @param constants Table whose preserved variables are known before evaluation (not used in this node)
+     * @return nullptr, the node is always kept
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& /*constants*/) override { return nullptr; }
+
+    /**
+     * @brief Reports the constant's value
+     * @param value Set to the numeric value of the constant
+     * @return true, a NumberNode is always constant
+     */
+    bool isConstant(long double& value) const override {
+        value = this->value;
+        return true;
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return A NumberNode holding 0
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
+
+    /**
+     * @brief Reads the node as a polynomial
+     * @param out Set to the polynomial
+     * @return true, as the constant term
+     */
+    bool polynomial(Polynomial& out) const override;
 };
@@ -0,0 +1,308 @@
+/**
+ * @file NumericNode.h
+ * @brief Nodes that solve, integrate or sum an expression over a bound variable
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header defines SolveNode, IntegrateNode and SumNode. Each holds an expression in
+ * which one variable is bound by the node, so inside the expression the name no longer
+ * refers to the variable of the same name outside, and the operands that give the
+ * variable's starting point or range. The expression is compiled into a routine of its
+ * own that the enclosing program runs as many times as the method needs, so a whole
+ * solve, integral or sum is one evaluation of the line.
+ */
+
+#pragma once
+
+#include "Node.h"
+#include "Bytecode.h"
+#include "NumberNode.h"
+#include "Optimizer.h"
+
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+
+/**
+ * @brief Simplifies the expression of a solve, integral or sum in place
+ * @param body The expression
+ * @param constants Table whose preserved variables are known before evaluation
+ * @param variable The bound variable, which is never replaced by a preserved value of the same name
+ */
+inline void simplifyBody(std::unique_ptr<Node>& body, const SymbolTable& constants, const SymbolId variable) {
+    if (!constants.isPreserved(variable)) {
+        simplifyChild(body, constants);
+        return;
+    }
+    SymbolTable shadowed = constants;
+    shadowed.setPreserved(variable, false);
+    simplifyChild(body, shadowed);
+}
+
+/**
+ * @brief Evaluates a solve, integral or sum node through the bytecode evaluator
+ * @param node The node
+ * @param variables Table of variable values
+ * @return The node's value
+ * @throws runtime_error on undefined variables, domain errors and failures of the method
+ */
+inline long double evaluateRoutine(const Node& node, const SymbolTable& variables) {
+    const Program program = Compiler::compile(node);
+    return program.evaluate(program.bind(variables));
+}
+
+/**
+ * @brief Folds a solve, integral or sum whose result is known before evaluation
+ * @param node The node
+ * @param operands The node's guess or bounds
+ * @return A NumberNode with the node's value, or nullptr if an operand is not constant,
+ * the expression reads a variable other than the bound one, or evaluation fails
+ */
+inline std::unique_ptr<Node> foldRoutine(const Node& node, std::initializer_list<const Node*> operands) {
+    long double unused;
+    for (const Node* operand : operands) {
+        if (!operand->isConstant(unused)) { return nullptr; }
+    }
+    const Program program = Compiler::compile(node);
+    if (program.slotCount() != 0) { return nullptr; }
+    try {
+        return std::make_unique<NumberNode>(program.evaluate({}));
+    } catch (const std::runtime_error&) {
+        return nullptr;
+    }
+}
+
+/**
+ * @class SolveNode
+ * @brief Node representing a root of an expression
+ *
+ * Evaluates to the value of the variable, found by Newton's method from a guess, at
+ * which the expression is zero. The derivative the method needs is worked out
+ * symbolically when the node is built.
+ */
+class SolveNode : public Node {
+private:
+    std::unique_ptr<Node> body;  ///< Expression whose root is found
+    std::unique_ptr<Node> slope; ///< Derivative of the expression with respect to the variable
+    SymbolId variable;           ///< Variable the root is found in
+    std::unique_ptr<Node> guess; ///< Where the iteration starts
+
+    /**
+     * @brief Construct a new SolveNode from parts that are already built
+     */
+    SolveNode(std::unique_ptr<Node> expression, std::unique_ptr<Node> derivative, const SymbolId variable, std::unique_ptr<Node> start)
+        : body(std::move(expression)), slope(std::move(derivative)), variable(variable), guess(std::move(start)) {}
+
+public:
+
+    /**
+     * @brief Construct a new SolveNode
+     * @param expression Expression whose root is found
+     * @param variable Variable the root is found in
+     * @param start Where the iteration starts
+     * @throws runtime_error if the expression cannot be differentiated
+     */
+    SolveNode(std::unique_ptr<Node> expression, const SymbolId variable, std::unique_ptr<Node> start)
+        : body(std::move(expression)), variable(variable), guess(std::move(start)) {
+        slope = body->derivative(variable);
+    }
+
+    /**
+     * @brief Evaluate the root
+     * @param variables Table of variable values
+     * @return The root nearest the guess that the iteration converges to
+     * @throws runtime_error if the iteration does not converge or the expression fails along the way
+     */
+    long double evaluate(const SymbolTable& variables) const override { return evaluateRoutine(*this, variables); }
+
+    /**
+     * @brief Creates a deep copy of the node
+     * @return Pointer to a cloned new SolveNode
+     */
+    Node* clone() const override {
+        return new SolveNode(std::unique_ptr<Node>(body->clone()), std::unique_ptr<Node>(slope->clone()), variable,
+                             std::unique_ptr<Node>(guess->clone()));
+    }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the root
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        const std::uint32_t start = guess->compile(compiler);
+        return compiler.emitRoutine(OpCode::SOLVE, *body, slope.get(), variable, start, start);
+    }
+
+    /**
+     * @brief Simplifies the operands and folds the node if its result is already known
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(guess, constants);
+        simplifyBody(body, constants, variable);
+        simplifyBody(slope, constants, variable);
+        return foldRoutine(*this, {guess.get()});
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return 0, as the root does not move with the guess
+     * @throws runtime_error if the expression depends on the variable
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
+};
+
+/**
+ * @class IntegrateNode
+ * @brief Node representing a definite integral
+ *
+ * Evaluates the integral of an expression over the variable between two bounds by
+ * tanh-sinh quadrature, refined until it reaches the precision of the evaluator. The
+ * expression may be singular at a bound, but a kink or singularity inside the range
+ * has to be split off into integrals of its own.
+ */
+class IntegrateNode : public Node {
+private:
+    std::unique_ptr<Node> body;  ///< Integrand
+    SymbolId variable;           ///< Variable of integration
+    std::unique_ptr<Node> lower; ///< Lower bound
+    std::unique_ptr<Node> upper; ///< Upper bound
+
+public:
+
+    /**
+     * @brief Construct a new IntegrateNode
+     * @param integrand Expression to integrate
+     * @param variable Variable of integration
+     * @param from Lower bound
+     * @param to Upper bound
+     */
+    IntegrateNode(std::unique_ptr<Node> integrand, const SymbolId variable, std::unique_ptr<Node> from, std::unique_ptr<Node> to)
+        : body(std::move(integrand)), variable(variable), lower(std::move(from)), upper(std::move(to)) {}
+
+    /**
+     * @brief Evaluate the integral
+     * @param variables Table of variable values
+     * @return The integral, negated if the upper bound is below the lower one
+     * @throws runtime_error if the integrand fails at a quadrature point or the estimates do not converge
+     */
+    long double evaluate(const SymbolTable& variables) const override { return evaluateRoutine(*this, variables); }
+
+    /**
+     * @brief Creates a deep copy of the node
+     * @return Pointer to a cloned new IntegrateNode
+     */
+    Node* clone() const override {
+        return new IntegrateNode(std::unique_ptr<Node>(body->clone()), variable, std::unique_ptr<Node>(lower->clone()),
+                                 std::unique_ptr<Node>(upper->clone()));
+    }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the integral
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        const std::uint32_t from = lower->compile(compiler);
+        const std::uint32_t to = upper->compile(compiler);
+        return compiler.emitRoutine(OpCode::INTEGRATE, *body, nullptr, variable, from, to);
+    }
+
+    /**
+     * @brief Simplifies the operands and folds the node if its result is already known
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(lower, constants);
+        simplifyChild(upper, constants);
+        simplifyBody(body, constants, variable);
+        return foldRoutine(*this, {lower.get(), upper.get()});
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return The integral of the integrand's derivative
+     * @throws runtime_error if a bound depends on the variable
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
+};
+
+/**
+ * @class SumNode
+ * @brief Node representing a finite sum
+ *
+ * Evaluates the sum of an expression over every integer value of the variable from a
+ * lower to an upper bound, inclusive. The sum is empty when the upper bound is lower.
+ */
+class SumNode : public Node {
+private:
+    std::unique_ptr<Node> body;  ///< Term
+    SymbolId variable;           ///< Index of summation
+    std::unique_ptr<Node> lower; ///< First index
+    std::unique_ptr<Node> upper; ///< Last index
+
+public:
+
+    /**
+     * @brief Construct a new SumNode
+     * @param term Expression to sum
+     * @param variable Index of summation
+     * @param from First index
+     * @param to Last index
+     */
+    SumNode(std::unique_ptr<Node> term, const SymbolId variable, std::unique_ptr<Node> from, std::unique_ptr<Node> to)
+        : body(std::move(term)), variable(variable), lower(std::move(from)), upper(std::move(to)) {}
+
+    /**
+     * @brief Evaluate the sum
+     * @param variables Table of variable values
+     * @return The sum of the terms
+     * @throws runtime_error if a bound is not an integer, there are too many terms or a term fails
+     */
+    long double evaluate(const SymbolTable& variables) const override { return evaluateRoutine(*this, variables); }
+
+    /**
+     * @brief Creates a deep copy of the node
+     * @return Pointer to a cloned new SumNode
+     */
+    Node* clone() const override {
+        return new SumNode(std::unique_ptr<Node>(body->clone()), variable, std::unique_ptr<Node>(lower->clone()),
+                           std::unique_ptr<Node>(upper->clone()));
+    }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the sum
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        const std::uint32_t from = lower->compile(compiler);
+        const std::uint32_t to = upper->compile(compiler);
+        return compiler.emitRoutine(OpCode::SUM, *body, nullptr, variable, from, to);
+    }
+
+    /**
+     * @brief Simplifies the operands and folds the node if its result is already known
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(lower, constants);
+        simplifyChild(upper, constants);
+        simplifyBody(body, constants, variable);
+        return foldRoutine(*this, {lower.get(), upper.get()});
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return The sum of the term's derivatives, 0 with respect to the index itself
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
+};
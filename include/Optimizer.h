@@ -0,0 +1,82 @@
+/**
+ * @file Optimizer.h
+ * @brief Optimization passes run on the AST between parsing and evaluation
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header declares optimize(), the entry point that rewrites a parsed tree into
+ * an equivalent one that is cheaper to evaluate, and the small helpers every node uses
+ * to implement Node::simplify. Constant subtrees are folded into a single NumberNode
+ * and simple identities such as x * 1 and -(-x) are removed. The powers of one variable in
+ * a sum are rebuilt in Horner form.
+ */
+
+#pragma once
+
+#include "Node.h"
+#include "NumberNode.h"
+
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief Simplifies a child in place, replacing it if its simplify() returns a new node
+ * @param child The child to simplify
+ * @param constants Table whose preserved variables are known before evaluation
+ */
+inline void simplifyChild(std::unique_ptr<Node>& child, const SymbolTable& constants) {
+    if (std::unique_ptr<Node> replacement = child->simplify(constants)) {
+        child = std::move(replacement);
+    }
+}
+
+/**
+ * @brief Checks whether a node is the constant value
+ * @param node The node to check
+ * @param value The value to compare against
+ * @return true if the node is a NumberNode holding value
+ */
+inline bool isNumber(const Node& node, const long double value) {
+    long double constant;
+    return node.isConstant(constant) && constant == value;
+}
+
+/**
+ * @brief Folds a node whose children are all constants into a NumberNode
+ * @param node The node to fold
+ * @param children The node's children
+ * @return A NumberNode with the node's value, or nullptr if a child is not constant
+ * or evaluation fails. Failing nodes are kept so the error is reported when the
+ * expression is evaluated, exactly as without folding.
+ */
+inline std::unique_ptr<Node> foldConstant(const Node& node, std::initializer_list<const Node*> children) {
+    long double unused;
+    for (const Node* child : children) {
+        if (!child->isConstant(unused)) { return nullptr; }
+    }
+    try {
+        return std::make_unique<NumberNode>(node.evaluate({}));
+    } catch (const std::runtime_error&) {
+        return nullptr;
+    }
+}
+
+/**
+ * @brief Rewrites the powers of one variable in a sum into Horner form
+ * @param node An AddNode or SubtractNode whose operands are already simplified
+ * @return The sum with its polynomial terms gathered into one Horner form where the first of them
+ * was, the other terms keeping their order, or nullptr if fewer than two terms are gathered or they
+ * have fewer than two powers above the constant one, where the rewrite would save nothing. Terms
+ * that cancel or are multiplied by zero are left as written.
+ */
+std::unique_ptr<Node> hornerForm(const Node& node);
+
+/**
+ * @brief Runs all optimization passes over an expression
+ * @param expression Root of the parsed AST
+ * @param constants Table whose preserved variables are known before evaluation
+ * @return The root of the optimized AST
+ */
+std::unique_ptr<Node> optimize(std::unique_ptr<Node> expression, const SymbolTable& constants);
@@ -9,52 +9,66 @@
  * structure of the input expression. The parser supports various operations,
  * including addition, multiplication, exponentiation, unary operations, and
  * function calls. It also parses variable assignments but leaves the actual
- * assignment to be handled in the main loop.
+ * assignment to be handled in the main loop. The same grammar can also fill a FlatTree,
+ * which stores the expression in one array instead of one object per node.
  *
  */
 
 #pragma once
 
+#include "FlatTree.h"
 #include "Lexicography.h"
 #include "Node.h"
+#include "NodeArena.h"
 
 #include <memory>
 #include <string>
 #include <vector>
 
+/**
+ * @struct Sweep
+ * @brief The "for x in a..b step s" clause that turns an expression into a sweep over a range
+ */
+struct Sweep {
+    std::string variable;       ///< Variable that takes each value of the range
+    std::unique_ptr<Node> from; ///< First value
+    std::unique_ptr<Node> to;   ///< Last value, included when the steps land on it
+    std::unique_ptr<Node> step; ///< Distance between consecutive values, nullptr for the default of 1
+};
+
 /**
  * @class Parser
  * @brief Parses a vector of tokens into an Abstract Syntax Tree (AST)
  *
- * The Parser class implements a recursive descent parser that converts a
+ * The Parser class implements a precedence climbing parser that converts a
  * sequence of tokens into an AST representing the structure of the input
- * expression. It supports various mathematical operations, functions, and
+ * expression in a single pass. It supports various mathematical operations, functions, and
  * variable assignments.
  */
 class Parser {
 private:
 
-    std::vector<Token> tokens;   ///< Vector of tokens to parse
-    std::size_t currIndex;       ///< Current index in the loop
+    std::vector<Token> tokens;   ///< Vector of tokens to parse, empty when they come from a lexer
+    std::size_t currIndex;       ///< Current index in the vector
+    Lexer* lexer = nullptr;      ///< Lexer tokens are pulled from on demand, or nullptr to parse the vector
+    Token current;               ///< The token being parsed
+    bool assignmentAllowed = false; ///< Whether the next token may be the = of an assignment
     bool containsNewVar = false; ///< Whether the expression contains a new variable assignment
     std::string assignmentVar;   ///< The variable being assigned to. Empty if no assignment.
+    bool containsSweep = false;  ///< Whether the line ends in a sweep clause
+    Sweep sweep;                 ///< The sweep clause, if any
+    NodeArena* arena;            ///< Arena the parsed nodes are placed in, or nullptr for the heap
 
     /* Helper functions for loop control */
 
     /**
-     * @return the previous token in the vector if possible, otherwise the current token
-     * This function also decrements currIndex if possible
-     */
-    Token& prev();
-
-    /**
-     * @return the current token in the vector
+     * @return the current token
      */
     Token& curr();
 
     /**
-     * @return the next token in the vector if possible, otherwise the current token
-     * This function also increments currIndex if possible
+     * @return the next token, pulled from the lexer or the vector, or the END token once the input is exhausted
+     * @throws runtime_error if the token is an = outside an assignment or a preserve or remove command that does not start the line
      */
     Token& next();
 
@@ -64,58 +78,115 @@ private:
      */
     bool checkType(TokenType type);
 
-    /* Parsing functions, ordered in descending levels of precedence */
+    /* Parsing functions, from the whole line down to its smallest pieces. Each is a template over
+       the tree being built, either a builder of Node objects or a FlatTree, which both add a node
+       through number(), variable(), unary() and binary() and refer to a parsed subtree by a Handle.
+       Derivatives and routines are added through derivative() and routine(). */
 
     /**
-     * @return A unique pointer to the root node of the whole parsed AST
-     * This is the entry point for parsing expressions.
+     * @param tree The tree being built
+     * @return The root of the whole parsed AST
+     * This function detects an assignment, parses the expression and rejects trailing tokens.
+     * @throws runtime_error if = is used anywhere but right after a leading variable
+     */
+    template <typename Tree>
+    typename Tree::Handle parseStatement(Tree& tree);
+
+    /**
+     * @brief Parses a sweep clause, starting at its "for"
+     * @details for, in and step are only keywords here, so they remain valid variable names everywhere else.
+     * The bounds are always built as Node trees, evaluated once per run of the line.
+     * @throws runtime_error if the clause is malformed
+     */
+    void parseSweep();
+
+    /**
+     * @brief Reads the ", variable" that follows the expression argument of diff, solve, integrate and sum
+     * @param function Name of the function, for the error messages
+     * @return The variable's name
+     * @throws runtime_error if the comma or the variable is missing
+     */
+    std::string parseBoundVariable(const std::string& function);
+
+    /**
+     * @param tree The tree being built
+     * @return The root of the parsed AST
+     * This is the entry point for parsing expressions, including function arguments and grouped expressions.
      */
-    std::unique_ptr<Node> parseExpression();
+    template <typename Tree>
+    typename Tree::Handle parseExpression(Tree& tree);
 
     /**
-     * @return A unique pointer to the root node of the parsed AST
-     * This function handles parsing of assignment expressions.
+     * @param type A token type
+     * @return The precedence of the binary operator, higher binding tighter, or 0 if the token is not one
      */
-    std::unique_ptr<Node> parseAssignment();
+    static int precedence(TokenType type);
 
     /**
-     * @return A unique pointer to the root node of the parsed AST
-     * This function handles parsing of addition and subtraction expressions.
+     * @param tree The tree being built
+     * @param minPrecedence The loosest operator this call may consume
+     * @return The root of the parsed AST
+     * This function handles parsing of addition, subtraction, multiplication, division and exponentiation
+     * by precedence climbing.
      */
-    std::unique_ptr<Node> parseAddition();
+    template <typename Tree>
+    typename Tree::Handle parseBinary(Tree& tree, int minPrecedence);
 
     /**
-     * @return A unique pointer to the root node of the parsed AST
-     * This function handles parsing of multiplication and division expressions.
+     * @param tree The tree being built
+     * @param minPrecedence The loosest operator this call may consume
+     * @param left The first operand, already parsed
+     * @return The root of the parsed AST
      */
-    std::unique_ptr<Node> parseMultiplication();
+    template <typename Tree>
+    typename Tree::Handle parseBinary(Tree& tree, int minPrecedence, typename Tree::Handle left);
 
     /**
-     * @return A unique pointer to the root node of the parsed AST
-     * This function handles parsing of exponentiation expressions.
+     * @param tree The tree being built
+     * @param operand The operand the postfix operators apply to
+     * @return The root of the parsed AST
+     * This function handles parsing of factorials, which follow their operand.
      */
-    std::unique_ptr<Node> parsePower();
+    template <typename Tree>
+    typename Tree::Handle parsePostfix(Tree& tree, typename Tree::Handle operand);
 
     /**
-     * @return A unique pointer to the root node of the parsed AST
+     * @param tree The tree being built
+     * @return The root of the parsed AST
      * This function handles parsing of unary operations (e.g., negation).
      */
-    std::unique_ptr<Node> parseUnary();
+    template <typename Tree>
+    typename Tree::Handle parseUnary(Tree& tree);
 
     /**
-     * @return A unique pointer to the root node of the parsed AST
+     * @param tree The tree being built
+     * @return The root of the parsed AST
      * This function handles parsing of primary expressions, including numbers,
      * variables, function calls, and parenthesized expressions.
      */
-    std::unique_ptr<Node> parsePrimary();
+    template <typename Tree>
+    typename Tree::Handle parsePrimary(Tree& tree);
 
 public:
 
     /**
      * @brief Construct a new Parser object
      * @param tokens Vector of tokens to parse
+     * @param arena Optional arena to allocate the AST from. The arena must outlive the tree
+     * returned by parse().
      */
-    Parser(std::vector<Token> tokens);
+    Parser(std::vector<Token> tokens, NodeArena* arena = nullptr);
+
+    /**
+     * @brief Construct a Parser that pulls its tokens from a lexer as it goes
+     * @param lexer The lexer to read from, which must outlive the parser
+     * @param arena Optional arena to allocate the AST from. The arena must outlive the tree
+     * returned by parse().
+     * @throws runtime_error if the first token cannot be lexed
+     * @details Only the current token is held at any time, so long input is never materialized as a
+     * token vector, and only the nesting depth of the expression determines the parser's own memory.
+     */
+    explicit Parser(Lexer& lexer, NodeArena* arena = nullptr);
 
     /**
      * @brief Public parse function that serves as the entry point for parsing
@@ -123,16 +194,37 @@ public:
      */
     std::unique_ptr<Node> parse();
 
+    /**
+     * @brief Parses into a flat tree instead of allocating Node objects
+     * @param tree Cleared, then filled with the parsed expression, reusing its memory
+     * @details Accepts the same input and reports the same errors as parse(). The arena is not used.
+     */
+    void parse(FlatTree& tree);
+
+    /**
+     * @brief Parses a line that is only a sweep clause, such as the one opening a fused block
+     * @return The clause, whose bounds the caller may take ownership of
+     * @throws runtime_error if the tokens are not exactly "for x in a..b" with an optional "step s"
+     */
+    Sweep& parseSweepClause();
+
     /**
      * @brief Check if the parsed expression is an assignment
-     * @return true if the expression is an assignment, false otherwise
-     */
-    bool isAssignment() const {
-        for (const Token token : tokens) {
-            if (token.type == TokenType::ASSIGN) { return true; }
-		}
-        return false;
-    }
+     * @return true if the expression is an assignment, false otherwise. Only meaningful after parse().
+     */
+    bool isAssignment() const { return containsNewVar; }
+
+    /**
+     * @brief Check if the line is a sweep, an expression followed by "for x in a..b" and an optional "step s"
+     * @return true if the line ends in a sweep clause. Only meaningful after parse().
+     */
+    bool isSweep() const { return containsSweep; }
+
+    /**
+     * @brief Get the sweep clause, whose bounds the caller may take ownership of
+     * @return The clause, empty unless isSweep()
+     */
+    Sweep& getSweep() { return sweep; }
 
     /**
      * @brief Get the variable being assigned to
@@ -0,0 +1,130 @@
+/**
+ * @file Polynomial.h
+ * @brief Polynomials in one variable, as recognized in expression trees
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header defines the Polynomial class, the coefficient form that Node::polynomial
+ * reads a subtree into, and that the optimizer rebuilds in Horner form. Only operations
+ * that keep the coefficients as accurate as the expression they come from are allowed:
+ * sums, and products and integer powers where one side is a single term. A product of
+ * two sums such as (x - 1)^2 is not expanded, since its expanded coefficients could
+ * cancel badly near the roots. A reading that combines terms of one power with opposite
+ * signs, as in x^3 - x^3, or multiplies a term by zero is marked, since for an infinite
+ * or overflowing x the expression is NaN where the coefficients give a number.
+ */
+
+#pragma once
+
+#include "SymbolTable.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Node;
+
+/**
+ * @struct SumTerm
+ * @brief One operand of a chain of additions and subtractions, as Node::sumTerms lists it
+ */
+struct SumTerm {
+    const Node* node;  ///< The operand
+    bool subtracted;   ///< true if it is subtracted from the terms before it
+};
+
+/**
+ * @class Polynomial
+ * @brief Sum of constant multiples of powers of one variable
+ */
+class Polynomial {
+public:
+    static constexpr std::size_t MAX_DEGREE = 32; ///< Highest power of the variable a polynomial may have
+
+private:
+    std::vector<long double> coefficients; ///< Coefficient of each power of the variable, lowest first
+    std::string name;                      ///< Name of the variable, empty for a constant
+    SymbolId variable = 0;                 ///< Interned id of the variable, unused for a constant
+    bool folded = false;                   ///< Set once terms of opposite signs were combined or a term vanished
+
+    /**
+     * @return Number of nonzero coefficients, the constant term included
+     */
+    [[nodiscard]] std::size_t nonzero() const;
+
+public:
+
+    /**
+     * @brief The polynomial with only a constant term
+     * @param value The constant
+     */
+    explicit Polynomial(long double value = 0) : coefficients{value} {}
+
+    /**
+     * @brief The polynomial x
+     * @param name Name of the variable
+     * @param variable Its interned id
+     */
+    Polynomial(const std::string& name, SymbolId variable) : coefficients{0, 1}, name(name), variable(variable) {}
+
+    /**
+     * @brief Makes this polynomial refer to the other's variable if it is a constant
+     * @param other The other polynomial
+     * @return false if they are in different variables
+     */
+    bool unify(const Polynomial& other);
+
+    /**
+     * @brief Adds another polynomial to this one
+     * @param other The polynomial to add
+     * @param sign 1 to add, -1 to subtract
+     * @return false, leaving this polynomial unspecified, if the two are in different variables
+     */
+    bool add(const Polynomial& other, long double sign = 1);
+
+    /**
+     * @brief Multiplies this polynomial by another
+     * @param other The factor
+     * @return false, leaving this polynomial unspecified, if neither has a single term, if they are
+     * in different variables or if the product's degree is above MAX_DEGREE
+     */
+    bool multiply(const Polynomial& other);
+
+    /**
+     * @brief Raises this polynomial to a power
+     * @param exponent The exponent
+     * @return false, leaving this polynomial unspecified, unless it has a single term and the exponent
+     * is a non-negative integer keeping the degree at most MAX_DEGREE
+     */
+    bool raise(long double exponent);
+
+    /**
+     * @brief Negates every coefficient
+     */
+    void negate();
+
+    /**
+     * @return Number of nonzero coefficients of powers of the variable, leaving out the constant term
+     */
+    [[nodiscard]] std::size_t terms() const;
+
+    /**
+     * @return true if terms were folded together on the way to these coefficients, so that they differ
+     * from the expression where it is infinite or overflows
+     */
+    [[nodiscard]] bool foldsTerms() const { return folded; }
+
+    /**
+     * @param other Another polynomial in the same variable
+     * @return true if, for some power, the two have nonzero coefficients of opposite signs
+     */
+    [[nodiscard]] bool opposes(const Polynomial& other) const;
+
+    /**
+     * @brief Builds the polynomial in Horner form
+     * @return A tree evaluating (c_n x^(n-k) + c_k) x^(k-j) + c_j and so on down the nonzero coefficients, so
+     * that each term costs one addition and one multiplication by the gap's power
+     */
+    [[nodiscard]] std::unique_ptr<Node> horner() const;
+};
@@ -0,0 +1,38 @@
+/**
+ * @file Server.h
+ * @brief Long-running socket server that keeps one session per client
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header declares runServer, the driver behind the calculator's server mode. It
+ * listens on a TCP or Unix domain socket and serves every client from a single thread
+ * with a poll() event loop. Each connection gets its own Session, so variables, preserved
+ * values and reactive formulas persist between a client's requests, and a client may send
+ * any number of lines without waiting for the responses, which come back in order.
+ */
+
+#pragma once
+
+#include "Session.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+/**
+ * @brief Serves sessions over a socket until the process is interrupted
+ * @param address "PORT" or "HOST:PORT" for TCP, on the loopback interface if no host is
+ * given, or a path containing '/' for a Unix domain socket, which is removed on exit
+ * @param setup Called on every new connection's session before it reads any input, after file commands are turned off
+ * @param cacheCapacity Number of compiled lines each session keeps for reuse
+ * @throws runtime_error if the address is invalid or cannot be listened on, or if this
+ * platform has no POSIX sockets
+ * @details Every line a client sends is run through its session exactly as in batch mode,
+ * and the response appended to the connection's output. A connection stops being read
+ * while a large amount of its output is unsent, and is closed after an exit command or
+ * once the client has shut down its side and every response has been written. SIGINT
+ * and SIGTERM stop the server. Each connection interns its variable names into a
+ * SymbolRegistry of its own, released when it closes, so one client's names neither use
+ * up the SymbolTable::MAX_SYMBOLS of another nor grow its tables.
+ */
+void runServer(const std::string& address, const std::function<void(Session&)>& setup, std::size_t cacheCapacity);
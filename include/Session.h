@@ -0,0 +1,218 @@
+/**
+ * @file Session.h
+ * @brief Line-by-line driver shared by the interactive and batch front ends
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header defines the Session class, which owns a Calculator together with the
+ * node arena and expression cache used to process its input, and turns one input line
+ * into the text the user should see. Output is appended to a caller-owned buffer so
+ * front ends decide when to write and flush it.
+ */
+
+#pragma once
+
+#include "Calculator.h"
+#include "ExpressionCache.h"
+#include "NodeArena.h"
+#include "Stats.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @class Session
+ * @brief A calculator and its per-line processing state
+ *
+ * Handles the special commands (help, vars, clear, cache, stats, reactive, precision, fastmath, digits, save, load,
+ * preserve, remove, fuse, exit),
+ * and otherwise compiles, evaluates and reports each expression or assignment. Between fuse and end, lines are
+ * collected instead and then compiled and evaluated together as one fused block.
+ * Errors are reported as an "Error: ..." line and never stop the session.
+ */
+class Session {
+private:
+    Calculator calc;        ///< Variables and constants of the session
+    NodeArena arena;        ///< Arena each line's tree is parsed into
+    ExpressionCache cache;  ///< Compiled form of recently seen lines
+    bool reactive = false;  ///< Whether assignments are kept as live formulas
+    Precision precision = DEFAULT_PRECISION; ///< Engine expressions are evaluated in
+    bool fastMath = false;  ///< Whether programs are compiled to the fast kernels of FastMath.h
+    int digits = DEFAULT_DIGITS; ///< Significant digits results are printed with
+    bool fileAccess = true; ///< Whether save and load may read and write files
+    Stats stats;            ///< Where the time goes, only recorded in builds with CALCULATOR_STATS
+    std::function<void(std::string&)> sink; ///< Takes the output of long responses as they are produced, if set
+    bool fusing = false;    ///< Whether lines are being collected into a fused block
+    CompiledExpression fusedClause; ///< The open block's sweep clause, with kind SWEEP if it has one
+    std::vector<std::string> fusedLines; ///< Lines of the open block
+
+    /**
+     * @brief Compiles a line, or fetches its compiled form from the cache
+     * @param line The input line
+     * @param constants The calculator whose preserved values are folded into the program
+     * @return The compiled line, valid until the next call
+     * @throws runtime_error on lexing or parsing errors
+     */
+    const CompiledExpression& compileLine(std::string_view line, const Calculator& constants);
+
+    /**
+     * @brief Evaluates a compiled expression and appends the echoed line and result
+     * @param compiled The compiled expression line
+     * @param variables The calculator to evaluate against
+     * @param out Buffer the result is appended to
+     * @return The value of the expression
+     */
+    long double report(const CompiledExpression& compiled, const Calculator& variables, std::string& out);
+
+    /**
+     * @brief Evaluates a compiled sweep and appends one line per point
+     * @param compiled The compiled sweep line
+     * @param variables The calculator to evaluate against, whose value of the swept variable is ignored
+     * @param out Buffer the results are appended to, handed to the sink every SINK_THRESHOLD bytes
+     * @throws runtime_error if the range is empty, infinite or too long, or the expression reads an undefined variable
+     * @details The points go through the program's batch evaluator a block at a time. Points that
+     * hit a domain error get an error line of their own and the sweep carries on.
+     */
+    void sweep(const CompiledExpression& compiled, const Calculator& variables, std::string& out);
+
+    /**
+     * @brief Compiles the lines of the open fused block together and evaluates them
+     * @param out Buffer the results are appended to, handed to the sink every SINK_THRESHOLD bytes
+     * @throws runtime_error on lexing or parsing errors, undefined variables, or a malformed range
+     * @details Without a sweep clause the block runs once: assignments are stored in order and
+     * every line gets its usual response, unless a domain error stops the whole block before
+     * anything is stored. With one, each point of the range is one row evaluated in a single pass,
+     * nothing is stored, and each row is reported on one line.
+     */
+    void fuse(std::string& out);
+
+    /**
+     * @brief Appends the formulas the latest assignment recomputed
+     * @param out Buffer to append one line per recomputed variable to
+     */
+    void reportRecomputed(std::string& out) const;
+
+public:
+
+    /**
+     * @brief Construct a new Session
+     * @param cacheCapacity Number of compiled lines to keep for reuse
+     */
+    explicit Session(std::size_t cacheCapacity = 1024);
+
+    /**
+     * @brief Processes one line of input
+     * @param line The input line, without its line terminator
+     * @param out Buffer the response, terminated by a newline, is appended to
+     * @return false if the line asked to exit, true otherwise
+     */
+    bool execute(std::string_view line, std::string& out);
+
+    /**
+     * @brief Evaluates an expression line against another calculator without modifying it
+     * @param line The input line, which must not be an assignment or a command
+     * @param shared The calculator to read variables and constants from
+     * @param out Buffer the response, terminated by a newline, is appended to
+     * @details Only this session's arena and cache are written, so several sessions may
+     * evaluate against the same calculator concurrently as long as nothing modifies it.
+     */
+    void evaluateShared(std::string_view line, const Calculator& shared, std::string& out);
+
+    /**
+     * @brief Checks whether a line can be handed to evaluateShared()
+     * @param line The input line
+     * @return true if the line is neither a command nor an assignment, so running it cannot change any state
+     * @details Conservative: any line containing '=' counts as an assignment, even if it fails to parse.
+     */
+    static bool isReadOnly(std::string_view line);
+
+    /**
+     * @return true between a fuse line and its end, while lines are collected rather than run
+     */
+    [[nodiscard]] bool isFusing() const { return fusing; }
+
+    /**
+     * @return The session's calculator
+     */
+    Calculator& calculator() { return calc; }
+
+    /**
+     * @brief Selects the engine expressions and assignments are evaluated in
+     * @param newPrecision The precision to use from now on
+     */
+    void setPrecision(const Precision newPrecision) { precision = newPrecision; }
+
+    /**
+     * @return The engine expressions and assignments are evaluated in
+     */
+    [[nodiscard]] Precision getPrecision() const { return precision; }
+
+    /**
+     * @brief Selects whether assignments are kept as live formulas
+     * @param enabled true for live formulas, false for stored values
+     * @details Clears the expression cache, since only assignments compiled in reactive mode carry a formula.
+     */
+    void setReactive(bool enabled);
+
+    /**
+     * @brief Selects whether lines compiled from now on use the fast kernels of FastMath.h
+     * @param enabled true for the fast kernels, false for the standard library
+     * @details Clears the expression cache, whose programs were compiled for the previous setting. Live formulas
+     * already defined keep the kernels they were compiled with.
+     */
+    void setFastMath(bool enabled);
+
+    /**
+     * @return Whether lines are compiled to the fast kernels
+     */
+    [[nodiscard]] bool getFastMath() const { return fastMath; }
+
+    /**
+     * @brief Selects how many significant digits results are printed with
+     * @param newDigits From 1 to MAX_DIGITS, or SHORTEST_DIGITS for the shortest text that reads back as the same value
+     */
+    void setDigits(const int newDigits) { digits = newDigits; }
+
+    /**
+     * @return The number of significant digits results are printed with
+     */
+    [[nodiscard]] int getDigits() const { return digits; }
+
+    /**
+     * @brief Selects whether save and load may act on files
+     * @param enabled false to answer both commands with an error, as sessions of remote clients do
+     */
+    void setFileAccess(const bool enabled) { fileAccess = enabled; }
+
+    /**
+     * @brief Sets where the output of long responses goes while they are still being produced
+     * @param newSink Called with the output buffer once a sweep has appended SINK_THRESHOLD bytes
+     * to it; expected to write the buffer out and clear it. An empty function keeps everything in the buffer.
+     */
+    void setSink(std::function<void(std::string&)> newSink) { sink = std::move(newSink); }
+
+    static constexpr std::size_t SINK_THRESHOLD = 1 << 16; ///< Output a sweep accumulates before calling the sink
+
+    static constexpr std::size_t MAX_SWEEP_POINTS = 100000000; ///< Most points a single sweep may have
+
+    /**
+     * @return The statistics recorded by this session, all zero unless built with CALCULATOR_STATS
+     */
+    Stats& statistics() { return stats; }
+
+    /**
+     * @return The session's expression cache
+     */
+    const ExpressionCache& expressionCache() const { return cache; }
+
+    /**
+     * @brief Formats a result the same way the console prints a long double
+     * @param value The value to format
+     * @return The value with up to DEFAULT_DIGITS significant digits
+     */
+    static std::string formatResult(long double value);
+};
@@ -0,0 +1,62 @@
+/**
+ * @file Snapshot.h
+ * @brief Saving and restoring a calculator's variables in a compact binary file
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header defines the Snapshot class, which writes every variable of a Calculator,
+ * its preserved flag and, for live formulas, the compiled program to a versioned binary
+ * file, and reads such a file back. Loading decodes the programs directly instead of
+ * lexing and parsing their source, so restoring thousands of variables takes one pass
+ * over the file rather than a replay of the script that created them.
+ */
+
+#pragma once
+
+#include "Calculator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @class Snapshot
+ * @brief Reader and writer of the snapshot file format
+ *
+ * A snapshot starts with a fixed header holding the magic bytes, the format version and
+ * the size and layout of long double on the machine that wrote it, followed by a table of
+ * variable names with their flags and values, and by the formulas, whose slots refer to
+ * that table by index. Ids are interned again on load, so a snapshot can be read by any
+ * process. Every count, index and name is checked while decoding, and a truncated or damaged
+ * file, or one naming a variable twice or by a name the lexer would not read as a variable,
+ * is rejected before any name is interned or the calculator is touched.
+ */
+class Snapshot {
+public:
+
+    static constexpr std::uint32_t VERSION = 1; ///< Format version written by save() and accepted by load()
+
+    /**
+     * @brief Writes the variables of a calculator to a file
+     * @param calc The calculator to save
+     * @param path The file to create or overwrite
+     * @throws runtime_error if the file cannot be written
+     * @details Formulas that solve, integrate or sum are saved as their current value only,
+     * since the routines those run are not part of the format.
+     */
+    static void save(const Calculator& calc, const std::string& path);
+
+    /**
+     * @brief Restores the variables saved in a file
+     * @param calc The calculator to load into
+     * @param path The snapshot file
+     * @return The number of variables restored
+     * @throws runtime_error if the file cannot be read, was written by another version or
+     * on an incompatible machine, or is corrupt
+     * @details Every variable in the snapshot takes its saved value, preserved flag and
+     * formula, as if the script that built it had been replayed; other variables are kept.
+     * A saved formula that would form a cycle with the calculator's own formulas is restored
+     * as its saved value only.
+     */
+    static std::size_t load(Calculator& calc, const std::string& path);
+};
@@ -0,0 +1,182 @@
+/**
+ * @file Stats.h
+ * @brief Optional timing and evaluation counters for sessions
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header defines the Stats class, which accumulates how long each stage of the line
+ * pipeline takes, a histogram of whole-line latencies, how many nodes of each type were
+ * evaluated and how often the expression cache hit. Sessions only record into it when the
+ * calculator is configured with -DCALCULATOR_STATS=ON; otherwise CALCULATOR_IF_STATS drops
+ * every recording statement at compile time and the counters stay at zero.
+ */
+
+#pragma once
+
+#include "Bytecode.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef CALCULATOR_STATS
+#define CALCULATOR_IF_STATS(...) __VA_ARGS__ ///< Keeps a recording statement in instrumented builds
+#else
+#define CALCULATOR_IF_STATS(...)              ///< Drops a recording statement in regular builds
+#endif
+
+/**
+ * @enum Stage
+ * @brief Steps a line goes through, in order
+ */
+enum class Stage : std::uint8_t {
+    LEX,      ///< tokenize and formatting the tokens for display
+    PARSE,    ///< Parser::parse
+    OPTIMIZE, ///< Constant folding
+    COMPILE,  ///< Lowering to bytecode
+    EVALUATE  ///< Running the program, in any precision
+};
+
+/**
+ * @class Stats
+ * @brief Counters describing where a session spends its time
+ *
+ * Stage timings are accumulated per call, line latencies are kept as a histogram of
+ * power-of-two buckets of nanoseconds, and node evaluations are counted per node type
+ * from the instructions of each program run, so subexpressions shared by value
+ * numbering count once. Counters from several sessions can be merged into one.
+ */
+class Stats {
+public:
+    using Clock = std::chrono::steady_clock; ///< Clock every duration is measured with
+
+    static constexpr std::size_t STAGES = 5;         ///< Number of Stage values
+    static constexpr std::size_t NODE_TYPES = 31;    ///< Number of OpCode values
+    static constexpr std::size_t LATENCY_BUCKETS = 40; ///< Bucket k holds lines taking [2^k, 2^(k+1)) ns, the last one anything longer
+
+#ifdef CALCULATOR_STATS
+    static constexpr bool ENABLED = true; ///< Whether sessions record statistics in this build
+#else
+    static constexpr bool ENABLED = false; ///< Whether sessions record statistics in this build
+#endif
+
+    /**
+     * @class Stopwatch
+     * @brief Charges the time between successive laps to the stage each lap names
+     */
+    class Stopwatch {
+    private:
+        Stats& stats;           ///< Where the laps are recorded
+        Clock::time_point last; ///< End of the previous lap
+
+    public:
+        /**
+         * @brief Starts timing
+         * @param stats Where the laps are recorded
+         */
+        explicit Stopwatch(Stats& stats) : stats(stats), last(Clock::now()) {}
+
+        /**
+         * @brief Records the time since the previous lap, or since construction, against a stage
+         * @param stage The stage that just finished
+         */
+        void lap(Stage stage);
+    };
+
+    /**
+     * @class LineTimer
+     * @brief Records the time from its construction to its destruction as one line
+     */
+    class LineTimer {
+    private:
+        Stats& stats;              ///< Where the line is recorded
+        Clock::time_point started; ///< When the line arrived
+
+    public:
+        /**
+         * @brief Starts timing a line
+         * @param stats Where the line is recorded
+         */
+        explicit LineTimer(Stats& stats) : stats(stats), started(Clock::now()) {}
+        LineTimer(const LineTimer&) = delete;
+        LineTimer& operator=(const LineTimer&) = delete;
+        ~LineTimer();
+    };
+
+private:
+    std::array<std::uint64_t, STAGES> stageCalls{};          ///< Times each stage ran
+    std::array<std::uint64_t, STAGES> stageNanos{};          ///< Total time spent in each stage
+    std::array<std::uint64_t, LATENCY_BUCKETS> latencies{};  ///< Histogram of whole-line latencies
+    std::array<std::uint64_t, NODE_TYPES> nodeCounts{};      ///< Nodes evaluated, by OpCode
+    std::uint64_t lineCount = 0;     ///< Lines processed
+    std::uint64_t lineNanos = 0;     ///< Total time spent on them
+    std::uint64_t slowestLine = 0;   ///< Longest time spent on one line
+    std::uint64_t cacheHits = 0;     ///< Lines found in the expression cache
+    std::uint64_t cacheMisses = 0;   ///< Lines that had to be compiled
+
+    /**
+     * @brief Estimates a latency percentile from the histogram
+     * @param fraction Fraction of lines, between 0 and 1
+     * @return The upper bound in nanoseconds of the bucket holding that fraction of lines
+     */
+    [[nodiscard]] std::uint64_t percentile(double fraction) const;
+
+public:
+
+    /**
+     * @brief Records the time one stage took
+     * @param stage The stage
+     * @param nanoseconds How long it took
+     */
+    void addStage(Stage stage, std::uint64_t nanoseconds);
+
+    /**
+     * @brief Records the time one whole line took, from receiving it to appending its response
+     * @param nanoseconds How long it took
+     */
+    void addLine(std::uint64_t nanoseconds);
+
+    /**
+     * @brief Counts the nodes evaluated by running a program
+     * @param program The program that was run
+     * @param runs How many times it ran, once per point for a sweep
+     */
+    void addEvaluation(const Program& program, std::uint64_t runs = 1);
+
+    /**
+     * @brief Records one expression cache lookup
+     * @param hit Whether the line was found
+     */
+    void addCacheLookup(const bool hit) { ++(hit ? cacheHits : cacheMisses); }
+
+    /**
+     * @brief Adds another session's counters to these
+     * @param other The counters to add
+     */
+    void merge(const Stats& other);
+
+    /**
+     * @brief Sets every counter back to zero
+     */
+    void reset() { *this = Stats(); }
+
+    /**
+     * @return The number of lines recorded
+     */
+    [[nodiscard]] std::uint64_t lines() const { return lineCount; }
+
+    /**
+     * @brief Formats the counters as a table for the console
+     * @return Several lines of text, each terminated by a newline
+     */
+    [[nodiscard]] std::string report() const;
+
+    /**
+     * @brief Formats the counters as one JSON object
+     * @return The object, terminated by a newline
+     * @details Durations are in nanoseconds. Empty histogram buckets and node types are left out.
+     */
+    [[nodiscard]] std::string json() const;
+};
@@ -0,0 +1,180 @@
+/**
+ * @file SymbolTable.h
+ * @brief Interned variable names and a flat table of their values
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header defines SymbolId and the SymbolRegistry and SymbolTable classes. Every
+ * variable name is interned once into a registry that hands out dense integer ids, so
+ * nodes and compiled programs refer to variables by id. A SymbolTable stores values in
+ * a contiguous vector indexed by id, making lookups and assignments plain array
+ * accesses instead of string comparisons in a tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Dense integer id of an interned variable name
+ */
+using SymbolId = std::uint32_t;
+
+/**
+ * @class SymbolRegistry
+ * @brief Names interned so far and the ids handed out for them
+ *
+ * SymbolTable::intern() and SymbolTable::name() use the registry made current on the
+ * calling thread by a SymbolRegistry::Scope, or a process-wide one outside of any scope.
+ * Ids mean nothing outside the registry that handed them out, so trees, programs and
+ * tables built under one registry must only be used under it. The server gives each
+ * connection its own, so that a client's names count against its own cap only and are
+ * released with its connection.
+ */
+class SymbolRegistry {
+private:
+    friend class SymbolTable;
+
+    std::mutex mutex;                                   ///< Guards the names, since parallel batch sessions parse on several threads
+    std::deque<std::string> names;                      ///< Indexed by id; a deque, so references handed out stay valid
+    std::unordered_map<std::string_view, SymbolId> ids; ///< Views into names
+    std::size_t text = 0;                               ///< Characters of all names
+
+public:
+    SymbolRegistry() = default;
+    SymbolRegistry(const SymbolRegistry&) = delete;
+    SymbolRegistry& operator=(const SymbolRegistry&) = delete;
+
+    /**
+     * @class Scope
+     * @brief RAII guard that makes a registry current on this thread
+     *
+     * Scopes nest; the previously current registry is restored on destruction.
+     */
+    class Scope {
+    private:
+        SymbolRegistry* previous; ///< Registry that was current before this scope
+
+    public:
+        /**
+         * @brief Makes the registry current
+         * @param registry The registry to intern into, which must outlive the scope
+         */
+        explicit Scope(SymbolRegistry& registry);
+
+        /**
+         * @brief Restores the previously current registry
+         */
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+};
+
+/**
+ * @class SymbolTable
+ * @brief Values of a set of variables, indexed by symbol id
+ *
+ * Each symbol is either undefined or holds a value, and may additionally be marked
+ * preserved, which exempts it from clear() and lets the optimizer treat it as a
+ * constant. The table grows to the largest id it has been given and never shrinks.
+ */
+class SymbolTable {
+private:
+    static constexpr std::uint8_t DEFINED = 1;   ///< Flag for symbols that hold a value
+    static constexpr std::uint8_t PRESERVED = 2; ///< Flag for symbols kept by clear()
+
+    std::vector<long double> values;  ///< Value of each symbol, meaningful only if DEFINED
+    std::vector<std::uint8_t> flags;  ///< DEFINED and PRESERVED bits of each symbol
+    std::vector<SymbolId> definedIds; ///< Every DEFINED symbol, in order of definition
+
+    /**
+     * @brief Makes room for a symbol id
+     * @param id The id that must be addressable
+     */
+    void reserve(SymbolId id);
+
+public:
+    static constexpr std::size_t MAX_SYMBOLS = 1 << 20;     ///< Most distinct names a registry holds
+    static constexpr std::size_t MAX_SYMBOL_TEXT = 1 << 24; ///< Most characters of all those names together
+
+    /**
+     * @brief Looks up or assigns the id of a name in the current registry
+     * @param name The variable name
+     * @return The name's id, the same for every call with an equal name
+     * @throws runtime_error for a new name once the registry holds MAX_SYMBOLS names or MAX_SYMBOL_TEXT
+     * characters, since names are only released with their registry
+     * @details Thread-safe. Ids are handed out in first-seen order starting at 0.
+     */
+    static SymbolId intern(std::string_view name);
+
+    /**
+     * @param id An id returned by intern() under the current registry
+     * @return The interned name, valid for the lifetime of the registry
+     */
+    static const std::string& name(SymbolId id);
+
+    /**
+     * @brief Reads the value of a symbol
+     * @param id The symbol
+     * @param value Set to the symbol's value if it is defined
+     * @return true if the symbol is defined
+     */
+    bool lookup(const SymbolId id, long double& value) const {
+        if (id >= flags.size() || !(flags[id] & DEFINED)) { return false; }
+        value = values[id];
+        return true;
+    }
+
+    /**
+     * @param id The symbol
+     * @return true if the symbol holds a value
+     */
+    [[nodiscard]] bool contains(const SymbolId id) const { return id < flags.size() && (flags[id] & DEFINED); }
+
+    /**
+     * @param id The symbol
+     * @return true if the symbol is marked preserved
+     */
+    [[nodiscard]] bool isPreserved(const SymbolId id) const { return id < flags.size() && (flags[id] & PRESERVED); }
+
+    /**
+     * @brief Defines or overwrites a symbol's value
+     * @param id The symbol
+     * @param value The new value
+     */
+    void set(const SymbolId id, const long double value) {
+        if (id >= flags.size()) { reserve(id); }
+        if (!(flags[id] & DEFINED)) {
+            flags[id] |= DEFINED;
+            definedIds.push_back(id);
+        }
+        values[id] = value;
+    }
+
+    /**
+     * @brief Marks or unmarks a symbol as preserved
+     * @param id The symbol
+     * @param preserved Whether the symbol should survive clear()
+     */
+    void setPreserved(SymbolId id, bool preserved);
+
+    /**
+     * @brief Undefines every symbol that is not preserved
+     * @details Costs one pass over the defined symbols; no memory is freed or allocated.
+     */
+    void clear();
+
+    /**
+     * @return Every defined symbol, in order of definition
+     */
+    [[nodiscard]] const std::vector<SymbolId>& symbols() const { return definedIds; }
+};
@@ -0,0 +1,103 @@
+/**
+ * @file ThreadPool.h
+ * @brief Fixed-size work-stealing thread pool
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This header defines the ThreadPool class, which runs a range of independent tasks
+ * across a fixed set of threads. Each worker starts on its own contiguous share of the
+ * range and, once that is exhausted, steals tasks from the back of other workers'
+ * queues, so uneven task costs still keep every core busy.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Runs parallel loops on persistent worker threads
+ *
+ * The thread calling parallelFor() takes part as worker 0, so a pool of size n
+ * starts n - 1 threads.
+ */
+class ThreadPool {
+private:
+    /**
+     * @struct Queue
+     * @brief Tasks dealt to one worker
+     */
+    struct Queue {
+        std::mutex mutex;              ///< Guards tasks
+        std::deque<std::size_t> tasks; ///< Task indices, popped from the front by the owner and stolen from the back
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues; ///< One queue per worker
+    std::vector<std::thread> threads;           ///< Workers 1 to n - 1
+
+    std::mutex mutex;                 ///< Guards everything below
+    std::condition_variable wake;     ///< Signals workers that a job started or the pool stops
+    std::condition_variable finished; ///< Signals the caller that every worker is done
+    const std::function<void(std::size_t, std::size_t)>* job = nullptr; ///< Loop body of the running job
+    std::size_t generation = 0;       ///< Incremented per job so workers notice new work
+    std::size_t active = 0;           ///< Worker threads still running the current job
+    bool stopping = false;            ///< Set when the pool is destroyed
+    std::exception_ptr failure;       ///< First exception thrown by a task
+
+    /**
+     * @brief Body of each worker thread
+     * @param worker Index of the worker
+     */
+    void workerLoop(std::size_t worker);
+
+    /**
+     * @brief Runs tasks from the worker's own queue, then steals until no work is left
+     * @param worker Index of the worker
+     */
+    void drain(std::size_t worker);
+
+    /**
+     * @brief Takes the next task for a worker
+     * @param worker Index of the worker
+     * @param task Set to the task index
+     * @return false if every queue is empty
+     */
+    bool take(std::size_t worker, std::size_t& task);
+
+public:
+
+    /**
+     * @brief Construct a new ThreadPool
+     * @param size Number of workers including the calling thread, 0 for one per hardware thread
+     */
+    explicit ThreadPool(std::size_t size = 0);
+
+    /**
+     * @brief Stops and joins all worker threads
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @return The number of workers, including the calling thread
+     */
+    [[nodiscard]] std::size_t size() const { return queues.size(); }
+
+    /**
+     * @brief Runs task(i, worker) for every i in [0, count) and waits for all of them
+     * @param count Number of tasks
+     * @param task Loop body, given the task index and the index of the worker running it
+     * @throws Rethrows the first exception thrown by a task, after every task has finished
+     */
+    void parallelFor(std::size_t count, const std::function<void(std::size_t, std::size_t)>& task);
+};
@@ -11,9 +11,13 @@
 #pragma once
 
 #include "Node.h"
+#include "Bytecode.h"
+#include "Factorial.h"
+#include "Optimizer.h"
 
+#include <cmath>
+#include <cstdint>
 #include <memory>
-#include <map>
 #include <string>
 
 /**
@@ -38,10 +42,10 @@ public:
 
 	/**
     * @brief Evaluate the negation operation
-	* @param variables std::map of variable names to values
+	* @param variables Table of variable values
 	* @return Negated value of child node
     */ 
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
+    long double evaluate(const SymbolTable& variables) const override {
         return -child->evaluate(variables);
     }
 
@@ -52,6 +56,41 @@ public:
     Node* clone() const override {
         return new NegateNode(std::unique_ptr<Node>(child->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the negated value
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        return compiler.emit(OpCode::NEGATE, child->compile(compiler));
+    }
+
+    /**
+     * @brief Simplifies the operand, folds constants and cancels double negation
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(child, constants);
+        if (std::unique_ptr<Node> folded = foldConstant(*this, {child.get()})) { return folded; }
+        if (auto* inner = dynamic_cast<NegateNode*>(child.get())) { return std::move(inner->child); } // -(-x)
+        return nullptr;
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return The negated derivative of the operand
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
+
+    /**
+     * @brief Reads the node as a polynomial
+     * @param out Set to the polynomial
+     * @return true if the operand is a polynomial
+     */
+    bool polynomial(Polynomial& out) const override;
 };
 
 /**
@@ -75,11 +114,11 @@ public:
 
     /**
 	* @brief Evaluate the absolute value operation
-	* @param variables std::map of variable names to values 
+	* @param variables Table of variable values
 	* @return Absolute value of child node
     */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
-        return abs(child->evaluate(variables));
+    long double evaluate(const SymbolTable& variables) const override {
+        return std::abs(child->evaluate(variables));
     }
 
     /**
@@ -89,6 +128,32 @@ public:
     Node* clone() const override {
         return new AbsNode(std::unique_ptr<Node>(child->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the absolute value
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        return compiler.emit(OpCode::ABS, child->compile(compiler));
+    }
+
+    /**
+     * @brief Simplifies the operand and folds the node if it is constant
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(child, constants);
+        return foldConstant(*this, {child.get()});
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return The operand's derivative times its sign, undefined where the operand is zero
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
 };
 
 class FactorialNode : public Node {
@@ -105,20 +170,14 @@ public:
 
     /**
      * @brief Evaluate the factorial operation
-     * @param variables std::map of variable names to values
-     * @return Factorial of value of chile node
+     * @param variables Table of variable values
+     * @return Factorial of value of child node, through the gamma function for non-integers
      * @throws runtime_error if child evaluates to negative number
     */
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
-
-        if (child->evaluate(variables) < 0) { throw std::runtime_error("cannot take factorial of negative number"); }
-
-        long double result = 1;
-        for (int i = 1; i <= static_cast<int>(child->evaluate(variables)); ++i) {
-            result *= i;
-		}
-
-        return result;
+    long double evaluate(const SymbolTable& variables) const override {
+        const long double value = child->evaluate(variables);
+        if (value < 0) { throw std::runtime_error("cannot take factorial of negative number"); }
+        return factorial(value);
     }
 
     /**
@@ -128,4 +187,30 @@ public:
     Node* clone() const override {
 		return new FactorialNode(std::unique_ptr<Node>(child->clone()));
     }
+
+    /**
+     * @brief Lowers the node into bytecode
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the factorial
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        return compiler.emit(OpCode::FACTORIAL, child->compile(compiler));
+    }
+
+    /**
+     * @brief Simplifies the operand and folds the node if it is constant
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return The replacement node, or nullptr to keep this node
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        simplifyChild(child, constants);
+        return foldConstant(*this, {child.get()});
+    }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return A central difference of the factorial, which has no closed form derivative among the other functions
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
 };
@@ -5,28 +5,32 @@
  * @date 2025-8-18
  * 
  * @details This header defines the VariableNode class which represents variables in the AST.
- * It includes methods to evaluate the variable's value based on a provided std::map of variable names to
- * values, and to clone the node.
+ * It includes methods to evaluate the variable's value based on a provided SymbolTable of variable
+ * values, and to clone the node. The name is interned once on construction, so lookups index an array.
 */
 
 #pragma once
 
 #include "Node.h"
+#include "Bytecode.h"
+#include "NumberNode.h"
 
+#include <cstdint>
+#include <memory>
 #include <stdexcept>
 #include <string>
-#include <map>
 
 /**
  * @class VariableNode
  * @brief Node representing a variable in the AST
  * 
- * Evaluates to the value of the variable from a provided std::map of variable names to values.
- * Throws an error if the variable is not found in the std::map.
+ * Evaluates to the value of the variable from a provided SymbolTable.
+ * Throws an error if the variable is not defined in the table.
  */
 class VariableNode : public Node {
 private:
     std::string name; ///< Name of the variable
+    SymbolId id;      ///< Interned id of the name
 
 public:
 
@@ -35,18 +39,26 @@ public:
      * @param varName Name of the variable
 	 */
     VariableNode(const std::string& varName)
-        : name(varName) {}
+        : name(varName), id(SymbolTable::intern(varName)) {}
+
+    /**
+     * @brief Construct a new VariableNode from an already interned name
+     * @param varName Name of the variable
+     * @param varId Id returned by SymbolTable::intern for the name
+     */
+    VariableNode(const std::string& varName, const SymbolId varId)
+        : name(varName), id(varId) {}
     
 	/**
 	* @brief Evaluate the variable node by looking up the variable's value
-	* @param variables std::map of variable names to their values
+	* @param variables Table of variable values
 	* @return The value of the variable
-	* @throws runtime_error if the variable is not found in the std::map
+	* @throws runtime_error if the variable is not defined in the table
     */ 
-    long double evaluate(const std::map<std::string, long double>& variables) const override {
-        auto it = variables.find(name);
-        if (it != variables.end()) {
-            return it->second;
+    long double evaluate(const SymbolTable& variables) const override {
+        long double value;
+        if (variables.lookup(id, value)) {
+            return value;
         }
         throw std::runtime_error(name + " is not recognized as a variable, function, or operation");
     }
@@ -56,8 +68,44 @@ public:
      * @return Pointer to a cloned new VariableNode
 	 */
     Node* clone() const override {
-        return new VariableNode(name);
+        return new VariableNode(name, id);
+    }
+
+    /**
+     * @brief Lowers the variable into a slot load
+     * @param compiler Compiler receiving the instructions
+     * @return Register holding the variable's value
+     */
+    std::uint32_t compile(Compiler& compiler) const override {
+        return compiler.emitLoad(id);
+    }
+
+    /**
+     * @brief Replaces the variable with its value if it is a preserved constant
+     * @param constants Table whose preserved variables are known before evaluation
+     * @return A NumberNode holding the constant's value, or nullptr to keep the variable
+     */
+    std::unique_ptr<Node> simplify(const SymbolTable& constants) override {
+        long double value;
+        if (constants.isPreserved(id) && constants.lookup(id, value)) {
+            return std::make_unique<NumberNode>(value);
+        }
+        return nullptr;
     }
+
+    /**
+     * @brief Differentiates the node
+     * @param variable Id of the variable to differentiate with respect to
+     * @return A NumberNode holding 1 for the variable itself and 0 for any other
+     */
+    std::unique_ptr<Node> derivative(SymbolId variable) const override;
+
+    /**
+     * @brief Reads the node as a polynomial
+     * @param out Set to the polynomial
+     * @return true, as the polynomial x
+     */
+    bool polynomial(Polynomial& out) const override;
 };
 
 
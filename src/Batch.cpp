@@ -0,0 +1,198 @@
+/**
+ * @file Batch.cpp
+ * @brief Implementation of the batch mode drivers
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * Input is read a chunk at a time and split into lines in place; only a line that
+ * straddles two chunks is copied. Responses accumulate in one string that is written
+ * out whenever it grows past a threshold and once more at the end. The parallel driver
+ * gathers a window of lines, hands long runs of read-only lines to a thread pool in
+ * blocks, and splices each block's output back in input order.
+ */
+
+#include "Batch.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Bytes requested from the input per read
+constexpr std::size_t READ_CHUNK = 1 << 20;
+
+// Buffered output is written once it reaches this size
+constexpr std::size_t WRITE_THRESHOLD = 1 << 16;
+
+// Lines gathered before the parallel driver processes them
+constexpr std::size_t WINDOW_LINES = 1 << 14;
+
+// Lines evaluated by one pool task
+constexpr std::size_t TASK_LINES = 64;
+
+// Shorter runs of read-only lines are not worth waking the pool for
+constexpr std::size_t PARALLEL_MIN_LINES = 2 * TASK_LINES;
+
+// Calls handle on every line of the input, without its terminator, until it returns false
+template <typename Handler>
+void forEachLine(std::istream& input, Handler handle) {
+    std::vector<char> chunk(READ_CHUNK);
+    std::string pending; // start of a line whose end is in the next chunk
+    bool running = true;
+
+    const auto processLine = [&](std::string_view line) {
+        if (!line.empty() && line.back() == '\r') { line.remove_suffix(1); } // tolerate CRLF input
+        running = handle(line);
+    };
+
+    while (running && input) {
+        input.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        const std::string_view data(chunk.data(), static_cast<std::size_t>(input.gcount()));
+
+        std::size_t start = 0;
+        while (running) {
+            const std::size_t end = data.find('\n', start);
+            if (end == std::string_view::npos) {
+                pending.append(data.substr(start));
+                break;
+            }
+            if (pending.empty()) { processLine(data.substr(start, end - start)); }
+            else {
+                pending.append(data.substr(start, end - start));
+                processLine(pending);
+                pending.clear();
+            }
+            start = end + 1;
+        }
+    }
+
+    // Last line without a trailing newline
+    if (running && !pending.empty()) { processLine(pending); }
+}
+
+// Writes the buffered output once it has grown large enough
+void writeIfFull(std::string& out, std::ostream& output) {
+    if (out.size() >= WRITE_THRESHOLD) {
+        output.write(out.data(), static_cast<std::streamsize>(out.size()));
+        out.clear();
+    }
+}
+
+// Writes everything buffered, for sweeps whose output would otherwise pile up in memory
+void writeAll(std::string& out, std::ostream& output) {
+    output.write(out.data(), static_cast<std::streamsize>(out.size()));
+    out.clear();
+}
+
+} // namespace
+
+// Runs each line through the session as soon as it is split off
+void runBatch(Session& session, std::istream& input, std::ostream& output) {
+    std::string out;
+    out.reserve(2 * WRITE_THRESHOLD);
+    session.setSink([&output](std::string& buffer) { writeAll(buffer, output); });
+
+    forEachLine(input, [&](const std::string_view line) {
+        const bool running = session.execute(line, out);
+        writeIfFull(out, output);
+        return running;
+    });
+
+    session.setSink(nullptr);
+    output.write(out.data(), static_cast<std::streamsize>(out.size()));
+    output.flush();
+}
+
+// Gathers windows of lines and evaluates runs of read-only ones on the pool
+void runParallelBatch(Session& session, std::istream& input, std::ostream& output, const std::size_t threads) {
+    ThreadPool pool(threads);
+    std::vector<std::unique_ptr<Session>> workers;
+    for (std::size_t i = 0; i < pool.size(); ++i) {
+        workers.push_back(std::make_unique<Session>(session.expressionCache().getCapacity()));
+    }
+
+    std::string text;                                      // the window's lines, back to back
+    std::vector<std::pair<std::size_t, std::size_t>> lines; // offset and length of each line in text
+    std::vector<std::string> results;                       // output of each pool task
+    std::string out;
+    out.reserve(2 * WRITE_THRESHOLD);
+    bool running = true;
+    session.setSink([&output](std::string& buffer) { writeAll(buffer, output); });
+
+    const auto line = [&](const std::size_t i) {
+        return std::string_view(text).substr(lines[i].first, lines[i].second);
+    };
+
+    const auto processWindow = [&]() {
+        std::size_t i = 0;
+        while (running && i < lines.size()) {
+            // State-changing lines, and every line of a fused block, run in order on this thread
+            if (session.isFusing() || !Session::isReadOnly(line(i))) {
+                running = session.execute(line(i), out);
+                writeIfFull(out, output);
+                ++i;
+                continue;
+            }
+
+            std::size_t end = i;
+            while (end < lines.size() && Session::isReadOnly(line(end))) { ++end; }
+
+            if (end - i < PARALLEL_MIN_LINES) {
+                for (; i < end; ++i) { session.execute(line(i), out); }
+            }
+            else {
+                // Nothing writes to the calculator until every task is done
+                const Calculator& shared = session.calculator();
+                for (const std::unique_ptr<Session>& worker : workers) {
+                    worker->setPrecision(session.getPrecision());
+                    worker->setFastMath(session.getFastMath());
+                    worker->setDigits(session.getDigits());
+                }
+                const std::size_t first = i;
+                const std::size_t tasks = (end - first + TASK_LINES - 1) / TASK_LINES;
+                results.resize(tasks);
+                pool.parallelFor(tasks, [&](const std::size_t task, const std::size_t worker) {
+                    std::string& result = results[task];
+                    result.clear();
+                    const std::size_t taskEnd = std::min(end, first + (task + 1) * TASK_LINES);
+                    for (std::size_t k = first + task * TASK_LINES; k < taskEnd; ++k) {
+                        workers[worker]->evaluateShared(line(k), shared, result);
+                    }
+                });
+                for (std::size_t task = 0; task < tasks; ++task) {
+                    out += results[task];
+                    writeIfFull(out, output);
+                }
+#ifdef CALCULATOR_STATS
+                // Fold the workers' counters in, so a later stats line sees every line so far
+                for (const std::unique_ptr<Session>& worker : workers) {
+                    session.statistics().merge(worker->statistics());
+                    worker->statistics().reset();
+                }
+#endif
+                i = end;
+            }
+            writeIfFull(out, output);
+        }
+        text.clear();
+        lines.clear();
+    };
+
+    forEachLine(input, [&](const std::string_view current) {
+        lines.emplace_back(text.size(), current.size());
+        text.append(current);
+        if (lines.size() == WINDOW_LINES) { processWindow(); }
+        return running;
+    });
+    if (running) { processWindow(); }
+
+    session.setSink(nullptr);
+    output.write(out.data(), static_cast<std::streamsize>(out.size()));
+    output.flush();
+}
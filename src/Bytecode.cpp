@@ -0,0 +1,570 @@
+/**
+ * @file Bytecode.cpp
+ * @brief Implementation of the bytecode compiler and evaluator
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This file implements the Compiler, which collects the instructions emitted by each
+ * node, and the Program evaluator, which runs them in a single loop over a register
+ * array, either for one set of inputs or block by block over columns of inputs; a fused
+ * program copies out one column per expression it was compiled from.
+ * Domain checks mirror the ones in the node classes so all paths report the same errors.
+ * The evaluators report errors as status codes; the throwing entry points wrap them.
+ */
+
+#include "Bytecode.h"
+#include "Factorial.h"
+#include "FastMath.h"
+#include "FlatTree.h"
+#include "Jit.h"
+#include "Node.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Applies f element-wise over a block; kept trivial so the compiler can vectorize it
+template <typename Scalar, typename Function>
+void mapBlock(Scalar* out, const Scalar* a, const std::size_t n, Function f) {
+    for (std::size_t k = 0; k < n; ++k) { out[k] = f(a[k]); }
+}
+
+// Two-operand version of mapBlock
+template <typename Scalar, typename Function>
+void mapBlock(Scalar* out, const Scalar* a, const Scalar* b, const std::size_t n, Function f) {
+    for (std::size_t k = 0; k < n; ++k) { out[k] = f(a[k], b[k]); }
+}
+
+// Runs a fast kernel over a whole block, where it vectorizes, then redoes the few elements outside its range precisely
+template <typename Scalar, typename Kernel, typename InRange, typename Precise>
+void mapFast(Scalar* out, const Scalar* a, const std::size_t n, Kernel kernel, InRange inRange, Precise precise) {
+    for (std::size_t k = 0; k < n; ++k) { out[k] = static_cast<Scalar>(kernel(static_cast<double>(a[k]))); }
+    for (std::size_t k = 0; k < n; ++k) {
+        if (!inRange(a[k])) { out[k] = precise(a[k]); }
+    }
+}
+
+// The buffers of the routines running on this thread, one per level of nesting, kept for the next
+// routine to run at that level. Each is held by pointer so that growing the stack leaves it in place
+template <typename Scalar>
+class ScratchFrame {
+private:
+    struct Stack {
+        std::vector<std::unique_ptr<RoutineScratch<Scalar>>> frames;
+        std::size_t depth = 0;
+    };
+
+    static Stack& stack() {
+        thread_local Stack frames;
+        return frames;
+    }
+
+    RoutineScratch<Scalar>* current;
+
+public:
+    ScratchFrame() {
+        Stack& s = stack();
+        if (s.depth == s.frames.size()) { s.frames.push_back(std::make_unique<RoutineScratch<Scalar>>()); }
+        current = s.frames[s.depth++].get();
+    }
+    ~ScratchFrame() { --stack().depth; }
+    ScratchFrame(const ScratchFrame&) = delete;
+    ScratchFrame& operator=(const ScratchFrame&) = delete;
+
+    [[nodiscard]] RoutineScratch<Scalar>& scratch() const { return *current; }
+};
+
+// Gathers the slots of a routine's body from the registers read returns and runs the routine
+template <typename Scalar, typename Read>
+EvalStatus callRoutine(const OpCode op, const Routine& routine, Read read, Scalar& value) {
+    const ScratchFrame<Scalar> frame;
+    RoutineScratch<Scalar>& scratch = frame.scratch();
+    scratch.slots.resize(routine.inputs.size());
+    for (std::size_t slot = 0; slot < routine.inputs.size(); ++slot) {
+        if (slot != routine.variable) { scratch.slots[slot] = read(routine.inputs[slot]); }
+    }
+    return routine.run(op, scratch, read(routine.from), read(routine.to), value);
+}
+
+// Returns true if pred holds for any element of the block, without an early exit
+template <typename Scalar, typename Predicate>
+bool anyOf(const Scalar* a, const std::size_t n, Predicate pred) {
+    bool found = false;
+    for (std::size_t k = 0; k < n; ++k) { found |= pred(a[k]); }
+    return found;
+}
+
+} // namespace
+
+const char* statusMessage(const EvalStatus status) {
+    switch (status) {
+        case EvalStatus::OK: return "no error";
+        case EvalStatus::DIVISION_BY_ZERO: return "division by zero";
+        case EvalStatus::NEGATIVE_BASE: return "negative base with non-integer exponent";
+        case EvalStatus::NEGATIVE_FACTORIAL: return "cannot take factorial of negative number";
+        case EvalStatus::NON_POSITIVE_LOGARITHM: return "logarithm of non-positive value";
+        case EvalStatus::LOGARITHM_BASE_ONE: return "logarithm base of 1";
+        case EvalStatus::NEGATIVE_SQUARE_ROOT: return "square root of negative value";
+        case EvalStatus::UNBOUND_VARIABLE: return "variable has no value";
+        case EvalStatus::NO_ROOT: return "solve did not converge to a root";
+        case EvalStatus::NO_CONVERGENCE: return "integral did not converge";
+        case EvalStatus::NON_INTEGER_BOUNDS: return "sum bounds must be integers";
+        case EvalStatus::TOO_MANY_TERMS: return "sum has too many terms";
+    }
+    return "unknown error";
+}
+
+const char* precisionName(const Precision precision) {
+    switch (precision) {
+        case Precision::LONG_DOUBLE: return "long";
+        case Precision::DOUBLE: return "double";
+        case Precision::FLOAT: return "float";
+    }
+    return "unknown";
+}
+
+bool parsePrecision(const std::string& name, Precision& precision) {
+    if (name == "long") { precision = Precision::LONG_DOUBLE; }
+    else if (name == "double") { precision = Precision::DOUBLE; }
+    else if (name == "float") { precision = Precision::FLOAT; }
+    else { return false; }
+    return true;
+}
+
+// Compiles the tree rooted at expression into a new program
+Program Compiler::compile(const Node& expression) {
+    Compiler compiler;
+    compiler.program.result = expression.compile(compiler);
+#ifdef CALCULATOR_JIT_NATIVE
+    compiler.program.tier = std::make_shared<JitTier>();
+#endif
+    return std::move(compiler.program);
+}
+
+// Compiles a flat tree the same way, node by node from its root
+Program Compiler::compile(const FlatTree& expression) {
+    Compiler compiler;
+    compiler.program.result = expression.compile(compiler);
+#ifdef CALCULATOR_JIT_NATIVE
+    compiler.program.tier = std::make_shared<JitTier>();
+#endif
+    return std::move(compiler.program);
+}
+
+// Compiles the lines in order with one compiler, so value numbering spans all of them
+Program Compiler::compile(const std::vector<FusedLine>& lines) {
+    Compiler compiler;
+    for (const FusedLine& line : lines) {
+        const std::uint32_t output = line.expression->compile(compiler);
+        compiler.program.outputRegisters.push_back(output);
+        if (line.defines) { compiler.defined[line.variable] = output; }
+    }
+    if (!lines.empty()) { compiler.program.result = compiler.program.outputRegisters.back(); }
+#ifdef CALCULATOR_JIT_NATIVE
+    compiler.program.tier = std::make_shared<JitTier>();
+#endif
+    return std::move(compiler.program);
+}
+
+// Returns the register of an identical earlier instruction, or appends the instruction and returns the register it writes
+std::uint32_t Compiler::emit(const OpCode op, std::uint32_t a, std::uint32_t b) {
+    if (op == OpCode::POWER && program.instructions[b].op == OpCode::CONSTANT) {
+        const long double exponent = program.constants[program.instructions[b].a];
+        if (exponent >= 2 && exponent <= MAX_MULTIPLIED_POWER && exponent == std::floor(exponent)) {
+            return emitPower(a, static_cast<std::uint32_t>(exponent));
+        }
+    }
+    // Exact in IEEE arithmetic, so x * y and y * x can share a register
+    if ((op == OpCode::ADD || op == OpCode::MULTIPLY) && b < a) { std::swap(a, b); }
+    const Instruction ins{op, a, b};
+    auto [it, inserted] = numbered.try_emplace(ins, static_cast<std::uint32_t>(program.instructions.size()));
+    if (inserted) { program.instructions.push_back(ins); }
+    return it->second;
+}
+
+// Left to right over the exponent's bits: square for each bit, and multiply by the base for each set bit
+std::uint32_t Compiler::emitPower(const std::uint32_t base, const std::uint32_t exponent) {
+    int bit = 31;
+    while ((exponent >> bit) == 0) { --bit; }
+    std::uint32_t power = base;
+    while (bit-- > 0) {
+        power = emit(OpCode::MULTIPLY, power, power);
+        if ((exponent >> bit) & 1) { power = emit(OpCode::MULTIPLY, power, base); }
+    }
+    return power;
+}
+
+// Adds the value to the constant pool unless an identical value is already there, and loads it into a register
+std::uint32_t Compiler::emitConstant(const long double value) {
+    // Pools are small after folding, so a scan is enough. 0 and -0 stay distinct, and NaN never matches
+    const auto same = [value](const long double pooled) {
+        return pooled == value && std::signbit(pooled) == std::signbit(value);
+    };
+    const auto pooled = std::find_if(program.constants.begin(), program.constants.end(), same);
+    if (pooled != program.constants.end()) {
+        return emit(OpCode::CONSTANT, static_cast<std::uint32_t>(pooled - program.constants.begin()));
+    }
+    program.constants.push_back(value);
+    return emit(OpCode::CONSTANT, static_cast<std::uint32_t>(program.constants.size() - 1));
+}
+
+// Loads a variable, giving each distinct symbol its own slot
+std::uint32_t Compiler::emitLoad(const SymbolId symbol) {
+    if (const auto line = defined.find(symbol); line != defined.end()) { return line->second; }
+    auto [it, inserted] = slots.try_emplace(symbol, static_cast<std::uint32_t>(program.slotSymbols.size()));
+    if (inserted) { program.slotSymbols.push_back(symbol); }
+    return emit(OpCode::LOAD, it->second);
+}
+
+// Compiles the body into a program of its own, fed every variable but the bound one from this program
+std::uint32_t Compiler::emitRoutine(const OpCode op, const Node& body, const Node* slope, const SymbolId variable,
+                                    const std::uint32_t from, const std::uint32_t to) {
+    Compiler inner;
+    inner.program.result = body.compile(inner);
+    Routine routine;
+    if (slope) { routine.slope = slope->compile(inner); }
+    routine.body = std::move(inner.program);
+    routine.inputs.resize(routine.body.slotCount());
+    for (std::uint32_t slot = 0; slot < routine.inputs.size(); ++slot) {
+        if (routine.body.slotSymbols[slot] == variable) { routine.variable = slot; }
+        else { routine.inputs[slot] = emitLoad(routine.body.slotSymbols[slot]); }
+    }
+    routine.from = from;
+    routine.to = to;
+    program.routines.push_back(std::move(routine));
+    return emit(op, static_cast<std::uint32_t>(program.routines.size() - 1));
+}
+
+// The fast counterpart of each function that has one
+void Program::useFastMath() {
+    for (Instruction& ins : instructions) {
+        switch (ins.op) {
+            case OpCode::SIN: ins.op = OpCode::FAST_SIN; break;
+            case OpCode::COS: ins.op = OpCode::FAST_COS; break;
+            case OpCode::TAN: ins.op = OpCode::FAST_TAN; break;
+            case OpCode::EXP: ins.op = OpCode::FAST_EXP; break;
+            case OpCode::LN: ins.op = OpCode::FAST_LN; break;
+            case OpCode::LOGTEN: ins.op = OpCode::FAST_LOGTEN; break;
+            case OpCode::LOG: ins.op = OpCode::FAST_LOG; break;
+            default: break;
+        }
+    }
+    for (Routine& routine : routines) { routine.body.useFastMath(); }
+}
+
+// Looks up every slot's variable once so evaluation can index an array
+std::vector<long double> Program::bind(const SymbolTable& variables) const {
+    std::vector<long double> slots(slotSymbols.size());
+    for (std::size_t slot = 0; slot < slotSymbols.size(); ++slot) {
+        if (!variables.lookup(slotSymbols[slot], slots[slot])) {
+            throw std::runtime_error(SymbolTable::name(slotSymbols[slot]) + " is not recognized as a variable, function, or operation");
+        }
+    }
+    return slots;
+}
+
+// Runs the native translation once the program is hot, and the bytecode evaluator until then
+template <typename Scalar>
+EvalStatus Program::run(const Scalar* slots, Scalar& value) const {
+    if (tier) {
+        if (const NativeProgram* native = tier->find<Scalar>()) { return native->run(slots, value); }
+        tier->record<Scalar>(*this);
+    }
+    return interpret(slots, value);
+}
+
+// Runs the instruction stream in registers that belong to this call
+template <typename Scalar>
+EvalStatus Program::interpret(const Scalar* slots, Scalar& value) const {
+    // Reused between calls so the hot loop does not allocate. Routines run other programs
+    // while this one is running, so a program that has them keeps registers of its own
+    thread_local std::vector<Scalar> shared;
+    std::vector<Scalar> own;
+    std::vector<Scalar>& registers = routines.empty() ? shared : own;
+    if (registers.size() < instructions.size()) { registers.resize(instructions.size()); }
+    if (const EvalStatus status = execute(slots, registers.data()); status != EvalStatus::OK) { return status; }
+    value = registers[result];
+    return EvalStatus::OK;
+}
+
+// Writes instruction i's result to register i
+template <typename Scalar>
+EvalStatus Program::execute(const Scalar* slots, Scalar* r) const {
+    for (std::size_t i = 0; i < instructions.size(); ++i) {
+        const Instruction& ins = instructions[i];
+        switch (ins.op) {
+            case OpCode::CONSTANT: r[i] = static_cast<Scalar>(constants[ins.a]); break;
+            case OpCode::LOAD: r[i] = slots[ins.a]; break;
+            case OpCode::ADD: r[i] = r[ins.a] + r[ins.b]; break;
+            case OpCode::SUBTRACT: r[i] = r[ins.a] - r[ins.b]; break;
+            case OpCode::MULTIPLY: r[i] = r[ins.a] * r[ins.b]; break;
+            case OpCode::DIVIDE:
+                if (r[ins.b] == 0) { return EvalStatus::DIVISION_BY_ZERO; }
+                r[i] = r[ins.a] / r[ins.b];
+                break;
+            case OpCode::POWER:
+                if (r[ins.a] < 0 && r[ins.b] != std::floor(r[ins.b])) {
+                    return EvalStatus::NEGATIVE_BASE;
+                }
+                r[i] = std::pow(r[ins.a], r[ins.b]);
+                break;
+            case OpCode::NEGATE: r[i] = -r[ins.a]; break;
+            case OpCode::ABS: r[i] = std::abs(r[ins.a]); break;
+            case OpCode::FACTORIAL:
+                if (r[ins.a] < 0) { return EvalStatus::NEGATIVE_FACTORIAL; }
+                r[i] = static_cast<Scalar>(factorial(r[ins.a]));
+                break;
+            case OpCode::SIN: r[i] = std::sin(r[ins.a]); break;
+            case OpCode::COS: r[i] = std::cos(r[ins.a]); break;
+            case OpCode::TAN: r[i] = std::tan(r[ins.a]); break;
+            case OpCode::ASIN: r[i] = std::asin(r[ins.a]); break;
+            case OpCode::ACOS: r[i] = std::acos(r[ins.a]); break;
+            case OpCode::ATAN: r[i] = std::atan(r[ins.a]); break;
+            case OpCode::EXP: r[i] = std::exp(r[ins.a]); break;
+            case OpCode::LN:
+                if (r[ins.a] <= 0.0) { return EvalStatus::NON_POSITIVE_LOGARITHM; }
+                r[i] = std::log(r[ins.a]);
+                break;
+            case OpCode::LOGTEN:
+                if (r[ins.a] <= 0.0) { return EvalStatus::NON_POSITIVE_LOGARITHM; }
+                r[i] = std::log10(r[ins.a]);
+                break;
+            case OpCode::LOG:
+                if (r[ins.b] == 1.0) { return EvalStatus::LOGARITHM_BASE_ONE; }
+                if (r[ins.b] <= 0.0 || r[ins.a] <= 0.0) { return EvalStatus::NON_POSITIVE_LOGARITHM; }
+                r[i] = std::log(r[ins.a]) / std::log(r[ins.b]);
+                break;
+            case OpCode::SQRT:
+                if (r[ins.a] < 0.0) { return EvalStatus::NEGATIVE_SQUARE_ROOT; }
+                r[i] = std::sqrt(r[ins.a]);
+                break;
+            case OpCode::SOLVE:
+            case OpCode::INTEGRATE:
+            case OpCode::SUM: {
+                const auto read = [r](const std::uint32_t index) { return r[index]; };
+                if (const EvalStatus status = callRoutine(ins.op, routines[ins.a], read, r[i]); status != EvalStatus::OK) {
+                    return status;
+                }
+                break;
+            }
+            case OpCode::FAST_SIN: r[i] = fastmath::sin(r[ins.a]); break;
+            case OpCode::FAST_COS: r[i] = fastmath::cos(r[ins.a]); break;
+            case OpCode::FAST_TAN: r[i] = fastmath::tan(r[ins.a]); break;
+            case OpCode::FAST_EXP: r[i] = fastmath::exp(r[ins.a]); break;
+            case OpCode::FAST_LN:
+                if (r[ins.a] <= 0.0) { return EvalStatus::NON_POSITIVE_LOGARITHM; }
+                r[i] = fastmath::ln(r[ins.a]);
+                break;
+            case OpCode::FAST_LOGTEN:
+                if (r[ins.a] <= 0.0) { return EvalStatus::NON_POSITIVE_LOGARITHM; }
+                r[i] = fastmath::log10(r[ins.a]);
+                break;
+            case OpCode::FAST_LOG:
+                if (r[ins.b] == 1.0) { return EvalStatus::LOGARITHM_BASE_ONE; }
+                if (r[ins.b] <= 0.0 || r[ins.a] <= 0.0) { return EvalStatus::NON_POSITIVE_LOGARITHM; }
+                r[i] = fastmath::ln(r[ins.a]) / fastmath::ln(r[ins.b]);
+                break;
+        }
+    }
+    return EvalStatus::OK;
+}
+
+// Narrows the slots, runs the narrower engine and widens the result
+template <typename Scalar>
+long double Program::evaluateAs(const std::vector<long double>& slots) const {
+    thread_local std::vector<Scalar> narrowed;
+    narrowed.assign(slots.begin(), slots.end());
+    Scalar value;
+    if (const EvalStatus status = run(narrowed.data(), value); status != EvalStatus::OK) {
+        throw std::runtime_error(statusMessage(status));
+    }
+    return value;
+}
+
+long double Program::evaluate(const std::vector<long double>& slots, const Precision precision) const {
+    switch (precision) {
+        case Precision::DOUBLE: return evaluateAs<double>(slots);
+        case Precision::FLOAT: return evaluateAs<float>(slots);
+        case Precision::LONG_DOUBLE: break;
+    }
+    return evaluate(slots);
+}
+
+long double Program::evaluate(const std::vector<long double>& slots) const {
+    long double value;
+    if (const EvalStatus status = run(slots.data(), value); status != EvalStatus::OK) {
+        throw std::runtime_error(statusMessage(status));
+    }
+    return value;
+}
+
+template <typename Scalar>
+EvalStatus Program::runBatch(const std::vector<BasicSlotColumn<Scalar>>& columns, const std::size_t rows, Scalar* output) const {
+    return executeBatch(columns, rows, &result, 1, &output);
+}
+
+template <typename Scalar>
+EvalStatus Program::runFused(const std::vector<BasicSlotColumn<Scalar>>& columns, const std::size_t rows, Scalar* const* outputs) const {
+    return executeBatch(columns, rows, outputRegisters.data(), outputRegisters.size(), outputs);
+}
+
+// Runs the program block by block: every instruction processes BATCH_BLOCK rows before the next one runs
+template <typename Scalar>
+EvalStatus Program::executeBatch(const std::vector<BasicSlotColumn<Scalar>>& columns, const std::size_t rows,
+                                 const std::uint32_t* results, const std::size_t count, Scalar* const* outputs) const {
+    constexpr std::size_t B = BATCH_BLOCK;
+
+    // One block of registers per instruction, reused between calls unless routines may need the buffer themselves
+    thread_local std::vector<Scalar> shared;
+    std::vector<Scalar> own;
+    std::vector<Scalar>& registers = routines.empty() ? shared : own;
+    if (registers.size() < instructions.size() * B) { registers.resize(instructions.size() * B); }
+    const auto reg = [&](const std::uint32_t index) { return registers.data() + index * B; };
+
+    for (std::size_t start = 0; start < rows; start += B) {
+        const std::size_t n = std::min(B, rows - start);
+
+        for (std::size_t i = 0; i < instructions.size(); ++i) {
+            const Instruction& ins = instructions[i];
+            Scalar* out = reg(static_cast<std::uint32_t>(i));
+
+            switch (ins.op) {
+                case OpCode::CONSTANT: std::fill(out, out + n, static_cast<Scalar>(constants[ins.a])); break;
+                case OpCode::LOAD: {
+                    const BasicSlotColumn<Scalar>& column = columns[ins.a];
+                    if (column.stride == 0) { std::fill(out, out + n, *column.values); }
+                    else {
+                        const Scalar* values = column.values + start * column.stride;
+                        for (std::size_t k = 0; k < n; ++k) { out[k] = values[k * column.stride]; }
+                    }
+                    break;
+                }
+                case OpCode::ADD: mapBlock(out, reg(ins.a), reg(ins.b), n, [](Scalar x, Scalar y) { return x + y; }); break;
+                case OpCode::SUBTRACT: mapBlock(out, reg(ins.a), reg(ins.b), n, [](Scalar x, Scalar y) { return x - y; }); break;
+                case OpCode::MULTIPLY: mapBlock(out, reg(ins.a), reg(ins.b), n, [](Scalar x, Scalar y) { return x * y; }); break;
+                case OpCode::DIVIDE:
+                    if (anyOf(reg(ins.b), n, [](Scalar x) { return x == 0; })) { return EvalStatus::DIVISION_BY_ZERO; }
+                    mapBlock(out, reg(ins.a), reg(ins.b), n, [](Scalar x, Scalar y) { return x / y; });
+                    break;
+                case OpCode::POWER: {
+                    const Scalar* base = reg(ins.a);
+                    const Scalar* exponent = reg(ins.b);
+                    bool invalid = false;
+                    for (std::size_t k = 0; k < n; ++k) { invalid |= base[k] < 0 && exponent[k] != std::floor(exponent[k]); }
+                    if (invalid) { return EvalStatus::NEGATIVE_BASE; }
+                    mapBlock(out, base, exponent, n, [](Scalar x, Scalar y) { return std::pow(x, y); });
+                    break;
+                }
+                case OpCode::NEGATE: mapBlock(out, reg(ins.a), n, [](Scalar x) { return -x; }); break;
+                case OpCode::ABS: mapBlock(out, reg(ins.a), n, [](Scalar x) { return std::abs(x); }); break;
+                case OpCode::FACTORIAL:
+                    if (anyOf(reg(ins.a), n, [](Scalar x) { return x < 0; })) { return EvalStatus::NEGATIVE_FACTORIAL; }
+                    mapBlock(out, reg(ins.a), n, [](Scalar x) { return static_cast<Scalar>(factorial(x)); });
+                    break;
+                case OpCode::SIN: mapBlock(out, reg(ins.a), n, [](Scalar x) { return std::sin(x); }); break;
+                case OpCode::COS: mapBlock(out, reg(ins.a), n, [](Scalar x) { return std::cos(x); }); break;
+                case OpCode::TAN: mapBlock(out, reg(ins.a), n, [](Scalar x) { return std::tan(x); }); break;
+                case OpCode::ASIN: mapBlock(out, reg(ins.a), n, [](Scalar x) { return std::asin(x); }); break;
+                case OpCode::ACOS: mapBlock(out, reg(ins.a), n, [](Scalar x) { return std::acos(x); }); break;
+                case OpCode::ATAN: mapBlock(out, reg(ins.a), n, [](Scalar x) { return std::atan(x); }); break;
+                case OpCode::EXP: mapBlock(out, reg(ins.a), n, [](Scalar x) { return std::exp(x); }); break;
+                case OpCode::LN:
+                    if (anyOf(reg(ins.a), n, [](Scalar x) { return x <= 0.0; })) { return EvalStatus::NON_POSITIVE_LOGARITHM; }
+                    mapBlock(out, reg(ins.a), n, [](Scalar x) { return std::log(x); });
+                    break;
+                case OpCode::LOGTEN:
+                    if (anyOf(reg(ins.a), n, [](Scalar x) { return x <= 0.0; })) { return EvalStatus::NON_POSITIVE_LOGARITHM; }
+                    mapBlock(out, reg(ins.a), n, [](Scalar x) { return std::log10(x); });
+                    break;
+                case OpCode::LOG:
+                    if (anyOf(reg(ins.b), n, [](Scalar x) { return x == 1.0; })) { return EvalStatus::LOGARITHM_BASE_ONE; }
+                    if (anyOf(reg(ins.b), n, [](Scalar x) { return x <= 0.0; }) ||
+                        anyOf(reg(ins.a), n, [](Scalar x) { return x <= 0.0; })) {
+                        return EvalStatus::NON_POSITIVE_LOGARITHM;
+                    }
+                    mapBlock(out, reg(ins.a), reg(ins.b), n, [](Scalar x, Scalar y) { return std::log(x) / std::log(y); });
+                    break;
+                case OpCode::SQRT:
+                    if (anyOf(reg(ins.a), n, [](Scalar x) { return x < 0.0; })) { return EvalStatus::NEGATIVE_SQUARE_ROOT; }
+                    mapBlock(out, reg(ins.a), n, [](Scalar x) { return std::sqrt(x); });
+                    break;
+                case OpCode::SOLVE:
+                case OpCode::INTEGRATE:
+                case OpCode::SUM:
+                    // Each row is a whole solve, integral or sum, which batches its own points
+                    for (std::size_t k = 0; k < n; ++k) {
+                        const auto read = [&](const std::uint32_t index) { return reg(index)[k]; };
+                        if (const EvalStatus status = callRoutine(ins.op, routines[ins.a], read, out[k]); status != EvalStatus::OK) {
+                            return status;
+                        }
+                    }
+                    break;
+                case OpCode::FAST_SIN:
+                    mapFast(out, reg(ins.a), n, fastmath::sinKernel, fastmath::inTrigRange<Scalar>, [](Scalar x) { return std::sin(x); });
+                    break;
+                case OpCode::FAST_COS:
+                    mapFast(out, reg(ins.a), n, fastmath::cosKernel, fastmath::inTrigRange<Scalar>, [](Scalar x) { return std::cos(x); });
+                    break;
+                case OpCode::FAST_TAN:
+                    mapFast(out, reg(ins.a), n, fastmath::tanKernel, fastmath::inTrigRange<Scalar>, [](Scalar x) { return std::tan(x); });
+                    break;
+                case OpCode::FAST_EXP:
+                    mapFast(out, reg(ins.a), n, fastmath::expKernel, fastmath::inExpRange<Scalar>, [](Scalar x) { return std::exp(x); });
+                    break;
+                case OpCode::FAST_LN:
+                    if (anyOf(reg(ins.a), n, [](Scalar x) { return x <= 0.0; })) { return EvalStatus::NON_POSITIVE_LOGARITHM; }
+                    mapFast(out, reg(ins.a), n, fastmath::lnKernel, fastmath::inLnRange<Scalar>, [](Scalar x) { return std::log(x); });
+                    break;
+                case OpCode::FAST_LOGTEN:
+                    if (anyOf(reg(ins.a), n, [](Scalar x) { return x <= 0.0; })) { return EvalStatus::NON_POSITIVE_LOGARITHM; }
+                    mapFast(out, reg(ins.a), n, [](double x) { return fastmath::lnKernel(x) * fastmath::LOG10E; },
+                            fastmath::inLnRange<Scalar>, [](Scalar x) { return std::log10(x); });
+                    break;
+                case OpCode::FAST_LOG: {
+                    if (anyOf(reg(ins.b), n, [](Scalar x) { return x == 1.0; })) { return EvalStatus::LOGARITHM_BASE_ONE; }
+                    if (anyOf(reg(ins.b), n, [](Scalar x) { return x <= 0.0; }) ||
+                        anyOf(reg(ins.a), n, [](Scalar x) { return x <= 0.0; })) {
+                        return EvalStatus::NON_POSITIVE_LOGARITHM;
+                    }
+                    Scalar numerator[B];
+                    const auto precise = [](Scalar x) { return std::log(x); };
+                    mapFast(numerator, reg(ins.a), n, fastmath::lnKernel, fastmath::inLnRange<Scalar>, precise);
+                    mapFast(out, reg(ins.b), n, fastmath::lnKernel, fastmath::inLnRange<Scalar>, precise);
+                    mapBlock(out, numerator, out, n, [](Scalar x, Scalar y) { return x / y; });
+                    break;
+                }
+            }
+        }
+        for (std::size_t j = 0; j < count; ++j) { std::copy(reg(results[j]), reg(results[j]) + n, outputs[j] + start); }
+    }
+    return EvalStatus::OK;
+}
+
+void Program::evaluateBatch(const std::vector<SlotColumn>& columns, const std::size_t rows, long double* output) const {
+    if (const EvalStatus status = runBatch(columns, rows, output); status != EvalStatus::OK) {
+        throw std::runtime_error(statusMessage(status));
+    }
+}
+
+// The engines available at runtime
+template EvalStatus Program::run(const long double*, long double&) const;
+template EvalStatus Program::run(const double*, double&) const;
+template EvalStatus Program::run(const float*, float&) const;
+template EvalStatus Program::interpret(const long double*, long double&) const;
+template EvalStatus Program::interpret(const double*, double&) const;
+template EvalStatus Program::interpret(const float*, float&) const;
+template EvalStatus Program::execute(const long double*, long double*) const;
+template EvalStatus Program::execute(const double*, double*) const;
+template EvalStatus Program::execute(const float*, float*) const;
+template EvalStatus Program::runBatch(const std::vector<BasicSlotColumn<long double>>&, std::size_t, long double*) const;
+template EvalStatus Program::runBatch(const std::vector<BasicSlotColumn<double>>&, std::size_t, double*) const;
+template EvalStatus Program::runBatch(const std::vector<BasicSlotColumn<float>>&, std::size_t, float*) const;
+template EvalStatus Program::runFused(const std::vector<BasicSlotColumn<long double>>&, std::size_t, long double* const*) const;
+template EvalStatus Program::runFused(const std::vector<BasicSlotColumn<double>>&, std::size_t, double* const*) const;
+template EvalStatus Program::runFused(const std::vector<BasicSlotColumn<float>>&, std::size_t, float* const*) const;
@@ -11,20 +11,45 @@
  */
 
 #include "Calculator.h"
+#include "NumberFormat.h"
 #include "VariableNode.h"
 
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
-Calculator::Calculator() {
+namespace {
+
+// Narrows the slots to the engine's type, runs the formula and widens its value, as Program::evaluate does
+template <typename Scalar>
+EvalStatus runAs(const Program& formula, const std::vector<long double>& slots, long double& value) {
+    thread_local std::vector<Scalar> narrowed;
+    narrowed.assign(slots.begin(), slots.end());
+    Scalar result;
+    const EvalStatus status = formula.run(narrowed.data(), result);
+    if (status == EvalStatus::OK) { value = result; }
+    return status;
+}
+
+EvalStatus runIn(const Program& formula, const std::vector<long double>& slots, const Precision precision, long double& value) {
+    switch (precision) {
+        case Precision::DOUBLE: return runAs<double>(formula, slots, value);
+        case Precision::FLOAT: return runAs<float>(formula, slots, value);
+        case Precision::LONG_DOUBLE: break;
+    }
+    return formula.run(slots.data(), value);
+}
 
-    // Variables and their corresponding nodes
-    variables = std::map<std::string, long double>();
-    varNodes = std::map<std::string, std::unique_ptr<Node>>();
+} // namespace
+
+Calculator::Calculator() {
 
     // Predefined variables
 	assign("pi", 3.141592653589793);
@@ -41,75 +66,233 @@ Calculator::Calculator() {
 
 // Evaluates the given expression node and returns the result
 long double Calculator::evaluate(const std::unique_ptr<Node>& expression) const {
-    return expression->evaluate(variables);
+    return expression->evaluate(symbols);
+}
+
+// Binds the program's slots to the current variable values and runs it
+long double Calculator::evaluate(const Program& program) const {
+    return program.evaluate(program.bind(symbols));
+}
+
+// Binds the slots in long double and lets the program narrow them for its engine
+long double Calculator::evaluate(const Program& program, const Precision precision) const {
+    return program.evaluate(program.bind(symbols), precision);
+}
+
+// Evaluates the program over columns of variable values, broadcasting variables without a column
+std::vector<long double> Calculator::evaluateBatch(const Program& program,
+    const std::map<std::string, std::vector<long double>>& columns) const {
+    if (columns.empty()) {
+        throw std::runtime_error("batch evaluation needs at least one input column");
+    }
+    const std::size_t rows = columns.begin()->second.size();
+
+    std::vector<SlotColumn> slots;
+    slots.reserve(program.slotCount());
+    std::vector<long double> broadcast(program.slotCount()); // values of variables without a column
+    for (std::size_t slot = 0; slot < program.slotCount(); ++slot) {
+        const std::string& name = program.slotName(slot);
+        if (auto column = columns.find(name); column != columns.end()) {
+            if (column->second.size() != rows) {
+                throw std::runtime_error("input column " + name + " has a different number of rows");
+            }
+            slots.push_back({column->second.data(), 1});
+        }
+        else if (symbols.lookup(program.slotSymbol(slot), broadcast[slot])) {
+            slots.push_back({&broadcast[slot], 0});
+        }
+        else {
+            throw std::runtime_error(name + " is not recognized as a variable, function, or operation");
+        }
+    }
+
+    std::vector<long double> results(rows);
+    program.evaluateBatch(slots, rows, results.data());
+    return results;
 }
 
-// Assigns a value to a variable and creates its corresponding VariableNode
+// Assigns a value to a variable, interning its name on first use
 void Calculator::assign(const std::string& name, const long double value) {
-    variables[name] = value;
-    varNodes[name] = std::make_unique<VariableNode>(name);
+    assign(SymbolTable::intern(name), value);
+}
+
+// Stores the value, invalidating folded constants if the variable is preserved, and updates live formulas
+void Calculator::assign(const SymbolId id, const long double value, const Precision precision) {
+    if (!formulas.empty()) { unlink(id); } // a fixed value replaces any formula
+    if (symbols.isPreserved(id)) { ++constantsVersion; }
+    symbols.set(id, value);
+    propagate(id, precision);
+}
+
+// Evaluates the formula now, then records which variables it reads
+long double Calculator::define(const SymbolId id, Program formula, const Precision precision) {
+    for (std::size_t slot = 0; slot < formula.slotCount(); ++slot) {
+        const SymbolId input = formula.slotSymbol(slot);
+        if (input == id || reaches(id, input)) {
+            throw std::runtime_error("circular definition of " + SymbolTable::name(id));
+        }
+    }
+    const long double value = formula.evaluate(formula.bind(symbols), precision);
+
+    unlink(id);
+    for (std::size_t slot = 0; slot < formula.slotCount(); ++slot) {
+        dependents[formula.slotSymbol(slot)].push_back(id);
+    }
+    formulas.insert_or_assign(id, std::move(formula));
+
+    if (symbols.isPreserved(id)) { ++constantsVersion; }
+    symbols.set(id, value);
+    propagate(id, precision);
+    return value;
+}
+
+// Depth-first post-order over the dependents gives a reverse topological order of everything downstream
+void Calculator::propagate(const SymbolId changed, const Precision precision) {
+    recomputations.clear();
+    if (dependents.find(changed) == dependents.end()) { return; }
+
+    std::vector<SymbolId> order;
+    std::unordered_set<SymbolId> visited = {changed};
+    std::vector<std::pair<SymbolId, std::size_t>> stack = {{changed, 0}};
+    while (!stack.empty()) {
+        auto& [id, next] = stack.back();
+        const auto edges = dependents.find(id);
+        if (edges != dependents.end() && next < edges->second.size()) {
+            const SymbolId child = edges->second[next++];
+            if (visited.insert(child).second) { stack.emplace_back(child, 0); }
+            continue;
+        }
+        order.push_back(id);
+        stack.pop_back();
+    }
+    order.pop_back(); // the changed variable itself
+
+    // A formula that fails keeps its previous value, and its dependents are computed from that
+    std::vector<long double> slots;
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        const Program& formula = formulas.at(*it);
+        slots.resize(formula.slotCount());
+        Recomputation result{*it, 0, EvalStatus::OK};
+        for (std::size_t slot = 0; slot < formula.slotCount() && result.status == EvalStatus::OK; ++slot) {
+            if (!symbols.lookup(formula.slotSymbol(slot), slots[slot])) { result.status = EvalStatus::UNBOUND_VARIABLE; }
+        }
+        if (result.status == EvalStatus::OK) { result.status = runIn(formula, slots, precision, result.value); }
+        if (result.status == EvalStatus::OK) {
+            if (symbols.isPreserved(*it)) { ++constantsVersion; }
+            symbols.set(*it, result.value);
+        }
+        recomputations.push_back(result);
+    }
+}
+
+void Calculator::unlink(const SymbolId id) {
+    const auto formula = formulas.find(id);
+    if (formula == formulas.end()) { return; }
+    for (std::size_t slot = 0; slot < formula->second.slotCount(); ++slot) {
+        const auto edges = dependents.find(formula->second.slotSymbol(slot));
+        edges->second.erase(std::find(edges->second.begin(), edges->second.end(), id));
+        if (edges->second.empty()) { dependents.erase(edges); }
+    }
+    formulas.erase(formula);
+}
+
+bool Calculator::reaches(const SymbolId from, const SymbolId target) const {
+    std::vector<SymbolId> pending = {from};
+    std::unordered_set<SymbolId> visited;
+    while (!pending.empty()) {
+        const SymbolId id = pending.back();
+        pending.pop_back();
+        if (id == target) { return true; }
+        if (!visited.insert(id).second) { continue; }
+        if (const auto edges = dependents.find(id); edges != dependents.end()) {
+            pending.insert(pending.end(), edges->second.begin(), edges->second.end());
+        }
+    }
+    return false;
 }
 
-// Retrieves a clone of the VariableNode for the given variable name
+// Creates a VariableNode for the given variable name
 std::unique_ptr<Node> Calculator::getVariable(const std::string& name)  {
-    if (const auto thing = varNodes.find(name); thing != varNodes.end()) {
-        return std::unique_ptr<Node>(thing->second->clone());
+    const SymbolId id = SymbolTable::intern(name);
+    if (symbols.contains(id)) {
+        return std::make_unique<VariableNode>(name, id);
     }
     throw std::runtime_error("variable not found");
 }
 
+// Finds a variable's value, reporting a missing one instead of throwing
+bool Calculator::lookup(const std::string& name, long double& value) const {
+    return symbols.lookup(SymbolTable::intern(name), value);
+}
+
 // Sets the value of an existing variable
 void Calculator::setVariable(const std::string& name, const long double value) {
-    variables[name] = value;
+    assign(SymbolTable::intern(name), value);
 }
 
-// Prints all variables and their values
-void Calculator::printVars() const {
-    for (const auto&[fst, snd] : variables) {
-        std::cout << fst << " = " << snd << std::endl;
+// Prints all variables and their values, sorted by name
+void Calculator::printVars(std::ostream& out, const int digits, const Precision precision) const {
+    std::vector<std::pair<std::string, long double>> sorted;
+    sorted.reserve(symbols.symbols().size());
+    for (const SymbolId id : symbols.symbols()) {
+        long double value;
+        symbols.lookup(id, value);
+        sorted.emplace_back(SymbolTable::name(id), value);
     }
+    std::sort(sorted.begin(), sorted.end());
+    std::string text;
+    for (const auto&[fst, snd] : sorted) {
+        text += fst;
+        text += " = ";
+        appendNumber(text, snd, digits, precision);
+        text += '\n';
+    }
+    out << text;
 }
 
-// Clears all variables except those that are preserved
+// Clears all variables except those that are preserved, in one pass over the defined symbols
 void Calculator::clear() {
-	std::map<std::string, long double> preservedVars;
-    for (const auto& name : preservedValues) {
-        if (auto it = variables.find(name); it != variables.end()) {
-            preservedVars[name] = it->second;
-        }
-    }
-	
-    variables.clear();
-    varNodes.clear();
+    symbols.clear();
+    recomputations.clear();
 
-    for (const auto&[fst, snd] : preservedVars) {
-		assign(fst, snd);
+    // Cleared variables lose their formulas too
+    std::vector<SymbolId> dropped;
+    for (const auto& [id, formula] : formulas) {
+        if (!symbols.contains(id)) { dropped.push_back(id); }
     }
+    for (const SymbolId id : dropped) { unlink(id); }
 }
 
 // Formats a long double to a string, removing unnecessary trailing zeros
 std::string Calculator::formatNumber(const long double value) {
-    std::string str = std::to_string(value);
-    // Remove trailing zeros
-    str.erase(str.find_last_not_of('0') + 1, std::string::npos);
-    // If the last character is a decimal point, remove it
-    if (!str.empty() && str.back() == '.') {
-        str.pop_back();
-    }
+    std::string str;
+    appendTrimmed(str, value);
     return str;
 }
 
 // Adds a variable to the set of preserved values
 void Calculator::addPreservedValue(const std::string& name) {
-    if (variables.find(name) == variables.end()) {
+    const SymbolId id = SymbolTable::intern(name);
+    if (!symbols.contains(id)) {
 		throw std::runtime_error("variable " + name + " does not exist and cannot be preserved.");
 	}
-	preservedValues.insert(name);
+	symbols.setPreserved(id, true);
+    ++constantsVersion;
+}
+
+// Collects the names of preserved variables
+std::set<std::string> Calculator::getPreservedValues() const {
+    std::set<std::string> names;
+    for (const SymbolId id : symbols.symbols()) {
+        if (symbols.isPreserved(id)) { names.insert(SymbolTable::name(id)); }
+    }
+    return names;
 }
 
 // Removes a variable from the set of preserved values
 void Calculator::removePreservedValue(const std::string& name) {
-    preservedValues.erase(name);
+    symbols.setPreserved(SymbolTable::intern(name), false);
+    ++constantsVersion;
 }
 
 // Formats and prints a list of tokens as a string
@@ -129,7 +312,7 @@ std::string Calculator::printTokens(const std::vector<Token>& tokens)
         
         // Handle number, where in some cases we want a space after and in some cases we don't
         if (token.type == TokenType::NUMBER) {
-            result += formatNumber(stod(token.value)); 
+            appendTrimmed(result, token.number);
 
             // The only cases where we don't want a space after a number is when there is a 
             // closing parenthesis or a comma right after
@@ -160,7 +343,8 @@ std::string Calculator::printTokens(const std::vector<Token>& tokens)
             token.type == TokenType::POWER ||
             token.type == TokenType::COMMA ||
             token.type == TokenType::ASSIGN) {
-            result += token.value + " ";
+            result += token.value;
+            result += " ";
         }
 
         // Special case for absolute value ||
@@ -171,7 +355,10 @@ std::string Calculator::printTokens(const std::vector<Token>& tokens)
             if (absCounter % 2 == 0) { result += token.value; } 
 
             // Second absolute value - add space
-            else { result += token.value + " "; }
+            else {
+                result += token.value;
+                result += " ";
+            }
             absCounter++;
         }
         
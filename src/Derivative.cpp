@@ -0,0 +1,231 @@
+/**
+ * @file Derivative.cpp
+ * @brief Differentiation rules of every node class
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * Each node builds its derivative out of copies of its own subtrees, so the rules need
+ * every node class at once and live here instead of in the headers. Terms that are known
+ * to be zero are dropped as the derivative is built, which keeps the derivative of an
+ * expression that barely depends on the variable about as small as the expression, and
+ * the optimizer folds whatever constants are left. Compiled together with the original
+ * expression, value numbering shares the copied subtrees, so one run of the program
+ * yields both the value and the derivative.
+ */
+
+#include "BinaryOpNode.h"
+#include "Factorial.h"
+#include "FuncNode.h"
+#include "NumberNode.h"
+#include "NumericNode.h"
+#include "Optimizer.h"
+#include "UnaryOpNode.h"
+#include "VariableNode.h"
+
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+
+using NodePtr = std::unique_ptr<Node>;
+
+NodePtr copy(const NodePtr& node) { return NodePtr(node->clone()); }
+
+NodePtr number(const long double value) { return std::make_unique<NumberNode>(value); }
+
+bool isZero(const NodePtr& node) { return isNumber(*node, 0); }
+
+NodePtr sum(NodePtr left, NodePtr right) {
+    if (isZero(left)) { return right; }
+    if (isZero(right)) { return left; }
+    return std::make_unique<AddNode>(std::move(left), std::move(right));
+}
+
+NodePtr difference(NodePtr left, NodePtr right) {
+    if (isZero(right)) { return left; }
+    if (isZero(left)) { return std::make_unique<NegateNode>(std::move(right)); }
+    return std::make_unique<SubtractNode>(std::move(left), std::move(right));
+}
+
+// Zero if either factor is, even where the other is infinite, since a zero derivative term is exact
+NodePtr product(NodePtr left, NodePtr right) {
+    if (isZero(left) || isZero(right)) { return number(0); }
+    if (isNumber(*left, 1)) { return right; }
+    if (isNumber(*right, 1)) { return left; }
+    return std::make_unique<MultiplyNode>(std::move(left), std::move(right));
+}
+
+NodePtr quotient(NodePtr numerator, NodePtr denominator) {
+    if (isZero(numerator)) { return numerator; }
+    return std::make_unique<DivideNode>(std::move(numerator), std::move(denominator));
+}
+
+NodePtr negation(NodePtr operand) {
+    if (isZero(operand)) { return operand; }
+    return std::make_unique<NegateNode>(std::move(operand));
+}
+
+// x * x, which compiles to one multiplication of a shared register
+NodePtr square(const NodePtr& node) { return std::make_unique<MultiplyNode>(copy(node), copy(node)); }
+
+} // namespace
+
+std::unique_ptr<Node> NumberNode::derivative(SymbolId) const { return number(0); }
+
+std::unique_ptr<Node> VariableNode::derivative(const SymbolId variable) const { return number(id == variable ? 1 : 0); }
+
+std::unique_ptr<Node> AddNode::derivative(const SymbolId variable) const {
+    return sum(child1->derivative(variable), child2->derivative(variable));
+}
+
+std::unique_ptr<Node> SubtractNode::derivative(const SymbolId variable) const {
+    return difference(child1->derivative(variable), child2->derivative(variable));
+}
+
+// (uv)' = u'v + uv'
+std::unique_ptr<Node> MultiplyNode::derivative(const SymbolId variable) const {
+    return sum(product(child1->derivative(variable), copy(child2)), product(copy(child1), child2->derivative(variable)));
+}
+
+// (u/v)' = u'/v when v is constant, (u'v - uv') / v^2 otherwise
+std::unique_ptr<Node> DivideNode::derivative(const SymbolId variable) const {
+    NodePtr top = numerator->derivative(variable);
+    NodePtr bottom = denominator->derivative(variable);
+    if (isZero(bottom)) { return quotient(std::move(top), copy(denominator)); }
+    return quotient(difference(product(std::move(top), copy(denominator)), product(copy(numerator), std::move(bottom))),
+                    square(denominator));
+}
+
+// (u^c)' = c u^(c-1) u', which stays defined for negative bases, and (u^v)' = u^v (v' ln u + v u'/u) in general
+std::unique_ptr<Node> PowerNode::derivative(const SymbolId variable) const {
+    NodePtr baseDerivative = base->derivative(variable);
+    NodePtr exponentDerivative = exponent->derivative(variable);
+    if (isZero(exponentDerivative)) {
+        if (isZero(baseDerivative)) { return baseDerivative; }
+        NodePtr lowered = std::make_unique<PowerNode>(copy(base), difference(copy(exponent), number(1)));
+        return product(product(copy(exponent), std::move(lowered)), std::move(baseDerivative));
+    }
+    NodePtr logarithmic = product(std::move(exponentDerivative), std::make_unique<LnNode>(copy(base)));
+    NodePtr polynomial = quotient(product(copy(exponent), std::move(baseDerivative)), copy(base));
+    return product(std::make_unique<PowerNode>(copy(base), copy(exponent)), sum(std::move(logarithmic), std::move(polynomial)));
+}
+
+std::unique_ptr<Node> NegateNode::derivative(const SymbolId variable) const { return negation(child->derivative(variable)); }
+
+// |u|' = u' u / |u|
+std::unique_ptr<Node> AbsNode::derivative(const SymbolId variable) const {
+    NodePtr inner = child->derivative(variable);
+    if (isZero(inner)) { return inner; }
+    return product(quotient(copy(child), std::make_unique<AbsNode>(copy(child))), std::move(inner));
+}
+
+// u!' = ((u + h)! - (u - h)!) / 2h u', see FACTORIAL_STEP
+std::unique_ptr<Node> FactorialNode::derivative(const SymbolId variable) const {
+    NodePtr inner = child->derivative(variable);
+    if (isZero(inner)) { return inner; }
+    NodePtr above = std::make_unique<FactorialNode>(sum(copy(child), number(FACTORIAL_STEP)));
+    NodePtr below = std::make_unique<FactorialNode>(difference(copy(child), number(FACTORIAL_STEP)));
+    return product(quotient(difference(std::move(above), std::move(below)), number(2 * FACTORIAL_STEP)), std::move(inner));
+}
+
+std::unique_ptr<Node> SinNode::derivative(const SymbolId variable) const {
+    NodePtr inner = child->derivative(variable);
+    if (isZero(inner)) { return inner; }
+    return product(std::make_unique<CosNode>(copy(child)), std::move(inner));
+}
+
+std::unique_ptr<Node> CosNode::derivative(const SymbolId variable) const {
+    NodePtr inner = child->derivative(variable);
+    if (isZero(inner)) { return inner; }
+    return negation(product(std::make_unique<SinNode>(copy(child)), std::move(inner)));
+}
+
+std::unique_ptr<Node> TanNode::derivative(const SymbolId variable) const {
+    NodePtr inner = child->derivative(variable);
+    if (isZero(inner)) { return inner; }
+    const NodePtr cosine = std::make_unique<CosNode>(copy(child));
+    return quotient(std::move(inner), square(cosine));
+}
+
+std::unique_ptr<Node> ArcSinNode::derivative(const SymbolId variable) const {
+    NodePtr inner = child->derivative(variable);
+    if (isZero(inner)) { return inner; }
+    return quotient(std::move(inner), std::make_unique<SqrtNode>(difference(number(1), square(child))));
+}
+
+std::unique_ptr<Node> ArcCosNode::derivative(const SymbolId variable) const {
+    NodePtr inner = child->derivative(variable);
+    if (isZero(inner)) { return inner; }
+    return negation(quotient(std::move(inner), std::make_unique<SqrtNode>(difference(number(1), square(child)))));
+}
+
+std::unique_ptr<Node> ArcTanNode::derivative(const SymbolId variable) const {
+    NodePtr inner = child->derivative(variable);
+    if (isZero(inner)) { return inner; }
+    return quotient(std::move(inner), sum(number(1), square(child)));
+}
+
+std::unique_ptr<Node> ExpNode::derivative(const SymbolId variable) const {
+    NodePtr inner = child->derivative(variable);
+    if (isZero(inner)) { return inner; }
+    return product(std::make_unique<ExpNode>(copy(child)), std::move(inner));
+}
+
+std::unique_ptr<Node> LnNode::derivative(const SymbolId variable) const {
+    return quotient(child->derivative(variable), copy(child));
+}
+
+std::unique_ptr<Node> LogTenNode::derivative(const SymbolId variable) const {
+    NodePtr inner = child->derivative(variable);
+    if (isZero(inner)) { return inner; }
+    return quotient(std::move(inner), product(copy(child), number(std::log(10.0L))));
+}
+
+// (ln u / ln b)' = (u'/u ln b - ln u b'/b) / (ln b)^2, just u' / (u ln b) for a constant base
+std::unique_ptr<Node> LogNode::derivative(const SymbolId variable) const {
+    NodePtr valueDerivative = val->derivative(variable);
+    NodePtr baseDerivative = base->derivative(variable);
+    if (isZero(baseDerivative)) {
+        return quotient(std::move(valueDerivative), product(copy(val), std::make_unique<LnNode>(copy(base))));
+    }
+    const NodePtr baseLog = std::make_unique<LnNode>(copy(base));
+    NodePtr valueTerm = product(quotient(std::move(valueDerivative), copy(val)), copy(baseLog));
+    NodePtr baseTerm = product(std::make_unique<LnNode>(copy(val)), quotient(std::move(baseDerivative), copy(base)));
+    return quotient(difference(std::move(valueTerm), std::move(baseTerm)), square(baseLog));
+}
+
+std::unique_ptr<Node> SqrtNode::derivative(const SymbolId variable) const {
+    NodePtr inner = child->derivative(variable);
+    if (isZero(inner)) { return inner; }
+    return quotient(std::move(inner), product(number(2), std::make_unique<SqrtNode>(copy(child))));
+}
+
+// The root moves with the expression's other variables by -f_t / f_x at the root, which would need the
+// derivatives evaluated at a point only known after solving, so that case is refused
+std::unique_ptr<Node> SolveNode::derivative(const SymbolId target) const {
+    if (target != variable && !isZero(body->derivative(target))) {
+        throw std::runtime_error("cannot differentiate solve with respect to " + SymbolTable::name(target) +
+                                 ", which its expression depends on");
+    }
+    return number(0);
+}
+
+// Differentiates under the integral sign; bounds that move would need the integrand evaluated at them
+std::unique_ptr<Node> IntegrateNode::derivative(const SymbolId target) const {
+    if (!isZero(lower->derivative(target)) || !isZero(upper->derivative(target))) {
+        throw std::runtime_error("cannot differentiate an integral whose bounds depend on " + SymbolTable::name(target));
+    }
+    if (target == variable) { return number(0); }
+    NodePtr inner = body->derivative(target);
+    if (isZero(inner)) { return inner; }
+    return std::make_unique<IntegrateNode>(std::move(inner), variable, copy(lower), copy(upper));
+}
+
+// The bounds only take integer values, so only the terms contribute
+std::unique_ptr<Node> SumNode::derivative(const SymbolId target) const {
+    if (target == variable) { return number(0); }
+    NodePtr inner = body->derivative(target);
+    if (isZero(inner)) { return inner; }
+    return std::make_unique<SumNode>(std::move(inner), variable, copy(lower), copy(upper));
+}
@@ -0,0 +1,101 @@
+/**
+ * @file Expression.cpp
+ * @brief Implementation of the embedding API
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * Compilation reuses the same pipeline as the interactive calculator. Nodes are
+ * parsed onto the heap since the tree is discarded as soon as it is compiled.
+ */
+
+#include "Expression.h"
+#include "Lexicography.h"
+#include "Optimizer.h"
+#include "Parser.h"
+
+#include <istream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// Parses, folds and compiles the lexer's tokens into a program, lexing as the parser asks for tokens
+Program compileText(Lexer& lexer, const SymbolTable& constants) {
+    Parser parser(lexer);
+    std::unique_ptr<Node> expression = parser.parse();
+    if (parser.isAssignment()) {
+        throw std::runtime_error("assignments cannot be compiled as expressions");
+    }
+    if (parser.isSweep()) {
+        throw std::runtime_error("sweeps cannot be compiled as expressions");
+    }
+    expression = optimize(std::move(expression), constants);
+    return Compiler::compile(*expression);
+}
+
+} // namespace
+
+Expression::Expression(Program program)
+    : program(std::move(program)), values(this->program.slotCount()), bound(this->program.slotCount()),
+      unbound(this->program.slotCount()), batch(this->program.slotCount()) {}
+
+Expression Expression::compile(const std::string_view text) {
+    Lexer lexer(text);
+    return Expression(compileText(lexer, SymbolTable()));
+}
+
+Expression Expression::compile(const std::string_view text, const Calculator& constants) {
+    Lexer lexer(text);
+    return Expression(compileText(lexer, constants.getConstants()));
+}
+
+Expression Expression::compile(std::istream& input) {
+    Lexer lexer(input);
+    return Expression(compileText(lexer, SymbolTable()));
+}
+
+Expression Expression::compile(std::istream& input, const Calculator& constants) {
+    Lexer lexer(input);
+    return Expression(compileText(lexer, constants.getConstants()));
+}
+
+// Slots are few, so a linear scan beats building an index
+std::size_t Expression::slotOf(const std::string_view name) const {
+    for (std::size_t slot = 0; slot < program.slotCount(); ++slot) {
+        if (program.slotName(slot) == name) { return slot; }
+    }
+    return npos;
+}
+
+bool Expression::set(const std::string_view name, const long double value) {
+    const std::size_t slot = slotOf(name);
+    if (slot == npos) { return false; }
+    set(slot, value);
+    return true;
+}
+
+std::size_t Expression::bindAll(const Calculator& variables) {
+    for (std::size_t slot = 0; slot < program.slotCount(); ++slot) {
+        long double value;
+        if (variables.getConstants().lookup(program.slotSymbol(slot), value)) { set(slot, value); }
+    }
+    return unbound;
+}
+
+// Broadcasts the bound value into every slot the caller did not supply a column for
+EvalStatus Expression::evaluateBatch(const std::vector<SlotColumn>& columns, const std::size_t rows,
+                                     long double* output) const {
+    for (std::size_t slot = 0; slot < batch.size(); ++slot) {
+        if (slot < columns.size() && columns[slot].values) {
+            batch[slot] = columns[slot];
+        } else if (bound[slot]) {
+            batch[slot] = {&values[slot], 0};
+        } else {
+            return EvalStatus::UNBOUND_VARIABLE;
+        }
+    }
+    return program.runBatch(batch, rows, output);
+}
@@ -0,0 +1,90 @@
+/**
+ * @file ExpressionCache.cpp
+ * @brief Implementation of the LRU expression cache
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * Entries live in a list ordered by recency, and a hash map from key to list position
+ * makes lookups, promotions and evictions constant time.
+ */
+
+#include "ExpressionCache.h"
+
+#include <cctype>
+#include <string>
+#include <string_view>
+
+ExpressionCache::ExpressionCache(const std::size_t capacity) : capacity(capacity) {}
+
+// Drops whitespace except between two word characters, where it separates tokens that would otherwise merge
+std::string ExpressionCache::normalize(const std::string_view input) {
+    const auto isWord = [](const char c) {
+        return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+    };
+    std::string key;
+    key.reserve(input.size());
+    bool pendingSpace = false;
+    for (const char c : input) {
+        if (isspace(static_cast<unsigned char>(c))) {
+            pendingSpace = !key.empty() && isWord(key.back());
+            continue;
+        }
+        if (pendingSpace && isWord(c)) { key += ' '; }
+        pendingSpace = false;
+        key += c;
+    }
+    return key;
+}
+
+// Finds a compiled line and moves it to the front of the recency list
+const CompiledExpression* ExpressionCache::find(const std::string& key, const std::uint64_t constantsVersion) {
+    if (constantsVersion != version) {
+        // Folded constants are stale
+        clear();
+        version = constantsVersion;
+    }
+    auto it = index.find(key);
+    if (it == index.end()) {
+        ++missCount;
+        return nullptr;
+    }
+    ++hitCount;
+    entries.splice(entries.begin(), entries, it->second);
+    return &it->second->compiled;
+}
+
+// Adds a compiled line as the most recently used entry
+const CompiledExpression& ExpressionCache::insert(const std::string& key, CompiledExpression compiled) {
+    if (capacity == 0) {
+        // Nothing is kept, but the caller still needs the expression until the next insert
+        uncached = std::move(compiled);
+        return uncached;
+    }
+    if (auto it = index.find(key); it != index.end()) {
+        it->second->compiled = std::move(compiled);
+        entries.splice(entries.begin(), entries, it->second);
+        return entries.front().compiled;
+    }
+    entries.push_front({key, std::move(compiled)});
+    index.emplace(entries.front().key, entries.begin());
+    trim();
+    return entries.front().compiled;
+}
+
+void ExpressionCache::clear() {
+    index.clear();
+    entries.clear();
+}
+
+void ExpressionCache::setCapacity(const std::size_t newCapacity) {
+    capacity = newCapacity;
+    trim();
+}
+
+// Evicts from the back of the recency list
+void ExpressionCache::trim() {
+    while (entries.size() > capacity) {
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
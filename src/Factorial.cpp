@@ -0,0 +1,47 @@
+/**
+ * @file Factorial.cpp
+ * @brief Implementation of the factorial kernel
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * The table holds 0! to n! for the largest n whose factorial is finite in a long double:
+ * 1754 with the 80-bit x87 format, 170 where long double is the same as double. Each
+ * entry is the product of the previous entry and its index, exactly as the original
+ * multiplication loop computed it.
+ */
+
+#include "Factorial.h"
+
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace {
+
+// Number of factorials representable in a long double
+constexpr std::size_t TABLE_SIZE = LDBL_MAX_EXP >= 16384 ? 1755 : 171;
+
+// Builds the table at compile time
+constexpr std::array<long double, TABLE_SIZE> makeTable() {
+    std::array<long double, TABLE_SIZE> table{};
+    table[0] = 1;
+    for (std::size_t n = 1; n < TABLE_SIZE; ++n) {
+        table[n] = table[n - 1] * static_cast<long double>(n);
+    }
+    return table;
+}
+
+constexpr std::array<long double, TABLE_SIZE> FACTORIALS = makeTable();
+
+} // namespace
+
+// Table lookup for integers in range, infinity above it, gamma for everything else
+long double factorial(const long double x) {
+    if (x == std::floor(x)) {
+        if (x < static_cast<long double>(TABLE_SIZE)) { return FACTORIALS[static_cast<std::size_t>(x)]; }
+        return std::numeric_limits<long double>::infinity();
+    }
+    return std::tgamma(x + 1);
+}
@@ -0,0 +1,332 @@
+/**
+ * @file FlatTree.cpp
+ * @brief Implementation of the flat expression tree
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * Evaluation is one pass over the nodes in storage order with a switch per node. When
+ * that pass hits an error, a recursive walk that visits operands in the same order as
+ * the Node classes, second operand first for division and logarithms, finds the error
+ * they would have reported. Compilation follows the same recursive order, and so does
+ * differentiation, whose new nodes refer to the existing ones rather than copying them.
+ * A FAST_ opcode evaluates as the precise function it stands in for.
+ */
+
+#include "FlatTree.h"
+#include "Factorial.h"
+
+#include <cmath>
+#include <iterator>
+#include <string_view>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+std::uint32_t FlatTree::add(const OpCode op, const std::uint32_t a, const std::uint32_t b) {
+    nodes.push_back({op, a, b});
+    return static_cast<std::uint32_t>(nodes.size() - 1);
+}
+
+FlatTree::Handle FlatTree::number(const long double value) {
+    constants.push_back(value);
+    return add(OpCode::CONSTANT, static_cast<std::uint32_t>(constants.size() - 1), 0);
+}
+
+FlatTree::Handle FlatTree::variable(const std::string_view name) {
+    return add(OpCode::LOAD, SymbolTable::intern(name), 0);
+}
+
+void FlatTree::clear() {
+    nodes.clear();
+    constants.clear();
+    root = 0;
+}
+
+// Children are stored before their parents, so one pass in storage order computes every node
+long double FlatTree::evaluate(const SymbolTable& variables) const {
+    // Small trees use the stack, larger ones a buffer reused between calls, so evaluation does not allocate
+    long double local[32];
+    long double* v = local;
+    if (nodes.size() > std::size(local)) {
+        thread_local std::vector<long double> values;
+        if (values.size() < nodes.size()) { values.resize(nodes.size()); }
+        v = values.data();
+    }
+
+    bool failed = false;
+    for (std::size_t i = 0; i < nodes.size() && !failed; ++i) {
+        const FlatNode& node = nodes[i];
+        switch (node.op) {
+            case OpCode::CONSTANT: v[i] = constants[node.a]; break;
+            case OpCode::LOAD:
+                if (!variables.lookup(node.a, v[i])) { failed = true; }
+                break;
+            case OpCode::ADD: v[i] = v[node.a] + v[node.b]; break;
+            case OpCode::SUBTRACT: v[i] = v[node.a] - v[node.b]; break;
+            case OpCode::MULTIPLY: v[i] = v[node.a] * v[node.b]; break;
+            case OpCode::DIVIDE:
+                if (v[node.b] == 0) { failed = true; }
+                else { v[i] = v[node.a] / v[node.b]; }
+                break;
+            case OpCode::POWER:
+                if (v[node.a] < 0 && v[node.b] != std::floor(v[node.b])) { failed = true; }
+                else { v[i] = std::pow(v[node.a], v[node.b]); }
+                break;
+            case OpCode::NEGATE: v[i] = -v[node.a]; break;
+            case OpCode::ABS: v[i] = std::abs(v[node.a]); break;
+            case OpCode::FACTORIAL:
+                if (v[node.a] < 0) { failed = true; }
+                else { v[i] = factorial(v[node.a]); }
+                break;
+            case OpCode::SIN:
+            case OpCode::FAST_SIN: v[i] = std::sin(v[node.a]); break;
+            case OpCode::COS:
+            case OpCode::FAST_COS: v[i] = std::cos(v[node.a]); break;
+            case OpCode::TAN:
+            case OpCode::FAST_TAN: v[i] = std::tan(v[node.a]); break;
+            case OpCode::ASIN: v[i] = std::asin(v[node.a]); break;
+            case OpCode::ACOS: v[i] = std::acos(v[node.a]); break;
+            case OpCode::ATAN: v[i] = std::atan(v[node.a]); break;
+            case OpCode::EXP:
+            case OpCode::FAST_EXP: v[i] = std::exp(v[node.a]); break;
+            case OpCode::LN:
+            case OpCode::FAST_LN:
+                if (v[node.a] <= 0) { failed = true; }
+                else { v[i] = std::log(v[node.a]); }
+                break;
+            case OpCode::LOGTEN:
+            case OpCode::FAST_LOGTEN:
+                if (v[node.a] <= 0) { failed = true; }
+                else { v[i] = std::log10(v[node.a]); }
+                break;
+            case OpCode::LOG:
+            case OpCode::FAST_LOG:
+                if (v[node.b] == 1.0 || v[node.b] <= 0.0 || v[node.a] <= 0.0) { failed = true; }
+                else { v[i] = std::log(v[node.a]) / std::log(v[node.b]); }
+                break;
+            case OpCode::SQRT:
+                if (v[node.a] < 0) { failed = true; }
+                else { v[i] = std::sqrt(v[node.a]); }
+                break;
+            case OpCode::SOLVE:
+            case OpCode::INTEGRATE:
+            case OpCode::SUM: throw std::runtime_error("solve, integrate and sum cannot be built in a flat tree");
+        }
+    }
+    // On any error, the recursive walk finds the one the Node classes would have reported first
+    return failed ? evaluate(root, variables) : v[root];
+}
+
+// Mirrors the evaluate() of each Node class, including the order operands are visited in
+long double FlatTree::evaluate(const std::uint32_t index, const SymbolTable& variables) const {
+    const FlatNode& node = nodes[index];
+    const auto fail = [](const EvalStatus status) -> long double { throw std::runtime_error(statusMessage(status)); };
+    switch (node.op) {
+        case OpCode::CONSTANT: return constants[node.a];
+        case OpCode::LOAD: {
+            long double value;
+            if (variables.lookup(node.a, value)) { return value; }
+            throw std::runtime_error(SymbolTable::name(node.a) + " is not recognized as a variable, function, or operation");
+        }
+        case OpCode::ADD: return evaluate(node.a, variables) + evaluate(node.b, variables);
+        case OpCode::SUBTRACT: return evaluate(node.a, variables) - evaluate(node.b, variables);
+        case OpCode::MULTIPLY: return evaluate(node.a, variables) * evaluate(node.b, variables);
+        case OpCode::DIVIDE: {
+            const long double denominator = evaluate(node.b, variables);
+            if (denominator == 0) { return fail(EvalStatus::DIVISION_BY_ZERO); }
+            return evaluate(node.a, variables) / denominator;
+        }
+        case OpCode::POWER: {
+            const long double base = evaluate(node.a, variables);
+            const long double exponent = evaluate(node.b, variables);
+            if (base < 0 && exponent != std::floor(exponent)) { return fail(EvalStatus::NEGATIVE_BASE); }
+            return std::pow(base, exponent);
+        }
+        case OpCode::NEGATE: return -evaluate(node.a, variables);
+        case OpCode::ABS: return std::abs(evaluate(node.a, variables));
+        case OpCode::FACTORIAL: {
+            const long double value = evaluate(node.a, variables);
+            if (value < 0) { return fail(EvalStatus::NEGATIVE_FACTORIAL); }
+            return factorial(value);
+        }
+        case OpCode::SIN:
+        case OpCode::FAST_SIN: return std::sin(evaluate(node.a, variables));
+        case OpCode::COS:
+        case OpCode::FAST_COS: return std::cos(evaluate(node.a, variables));
+        case OpCode::TAN:
+        case OpCode::FAST_TAN: return std::tan(evaluate(node.a, variables));
+        case OpCode::ASIN: return std::asin(evaluate(node.a, variables));
+        case OpCode::ACOS: return std::acos(evaluate(node.a, variables));
+        case OpCode::ATAN: return std::atan(evaluate(node.a, variables));
+        case OpCode::EXP:
+        case OpCode::FAST_EXP: return std::exp(evaluate(node.a, variables));
+        case OpCode::LN:
+        case OpCode::FAST_LN: {
+            const long double value = evaluate(node.a, variables);
+            if (value <= 0) { return fail(EvalStatus::NON_POSITIVE_LOGARITHM); }
+            return std::log(value);
+        }
+        case OpCode::LOGTEN:
+        case OpCode::FAST_LOGTEN: {
+            const long double value = evaluate(node.a, variables);
+            if (value <= 0) { return fail(EvalStatus::NON_POSITIVE_LOGARITHM); }
+            return std::log10(value);
+        }
+        case OpCode::LOG:
+        case OpCode::FAST_LOG: {
+            const long double base = evaluate(node.b, variables);
+            if (base == 1.0) { return fail(EvalStatus::LOGARITHM_BASE_ONE); }
+            const long double value = evaluate(node.a, variables);
+            if (base <= 0.0 || value <= 0.0) { return fail(EvalStatus::NON_POSITIVE_LOGARITHM); }
+            return std::log(value) / std::log(base);
+        }
+        case OpCode::SQRT: {
+            const long double value = evaluate(node.a, variables);
+            if (value < 0) { return fail(EvalStatus::NEGATIVE_SQUARE_ROOT); }
+            return std::sqrt(value);
+        }
+        case OpCode::SOLVE:
+        case OpCode::INTEGRATE:
+        case OpCode::SUM: throw std::runtime_error("solve, integrate and sum cannot be built in a flat tree");
+    }
+    return 0;
+}
+
+// Mirrors the compile() of each Node class, so value numbering sees the same instruction stream
+std::uint32_t FlatTree::compile(const std::uint32_t index, Compiler& compiler) const {
+    const FlatNode& node = nodes[index];
+    switch (node.op) {
+        case OpCode::CONSTANT: return compiler.emitConstant(constants[node.a]);
+        case OpCode::LOAD: return compiler.emitLoad(node.a);
+        case OpCode::DIVIDE:
+        case OpCode::LOG:
+        case OpCode::FAST_LOG: {
+            const std::uint32_t second = compile(node.b, compiler);
+            const std::uint32_t first = compile(node.a, compiler);
+            return compiler.emit(node.op, first, second);
+        }
+        case OpCode::ADD:
+        case OpCode::SUBTRACT:
+        case OpCode::MULTIPLY:
+        case OpCode::POWER: {
+            const std::uint32_t first = compile(node.a, compiler);
+            const std::uint32_t second = compile(node.b, compiler);
+            return compiler.emit(node.op, first, second);
+        }
+        default: return compiler.emit(node.op, compile(node.a, compiler));
+    }
+}
+
+bool FlatTree::isZero(const std::uint32_t index) const {
+    return nodes[index].op == OpCode::CONSTANT && constants[nodes[index].a] == 0;
+}
+
+bool FlatTree::isOne(const std::uint32_t index) const {
+    return nodes[index].op == OpCode::CONSTANT && constants[nodes[index].a] == 1;
+}
+
+FlatTree::Handle FlatTree::sum(const Handle left, const Handle right) {
+    if (isZero(left)) { return right; }
+    if (isZero(right)) { return left; }
+    return add(OpCode::ADD, left, right);
+}
+
+FlatTree::Handle FlatTree::difference(const Handle left, const Handle right) {
+    if (isZero(right)) { return left; }
+    if (isZero(left)) { return add(OpCode::NEGATE, right, 0); }
+    return add(OpCode::SUBTRACT, left, right);
+}
+
+FlatTree::Handle FlatTree::product(const Handle left, const Handle right) {
+    if (isZero(left) || isZero(right)) { return number(0); }
+    if (isOne(left)) { return right; }
+    if (isOne(right)) { return left; }
+    return add(OpCode::MULTIPLY, left, right);
+}
+
+FlatTree::Handle FlatTree::quotient(const Handle numerator, const Handle denominator) {
+    if (isZero(numerator)) { return numerator; }
+    return add(OpCode::DIVIDE, numerator, denominator);
+}
+
+FlatTree::Handle FlatTree::negation(const Handle operand) {
+    if (isZero(operand)) { return operand; }
+    return add(OpCode::NEGATE, operand, 0);
+}
+
+FlatTree::Handle FlatTree::derivative(const Handle expression, const std::string_view variable) {
+    return differentiate(expression, SymbolTable::intern(variable));
+}
+
+FlatTree::Handle FlatTree::routine(const OpCode, Handle, std::string_view, Handle, Handle) {
+    throw std::runtime_error("solve, integrate and sum cannot be built in a flat tree");
+}
+
+// Mirrors the derivative() of each Node class, see Derivative.cpp for the rules
+FlatTree::Handle FlatTree::differentiate(const std::uint32_t index, const SymbolId variable) {
+    const FlatNode node = nodes[index]; // a copy, adding nodes may move the vector
+    switch (node.op) {
+        case OpCode::CONSTANT: return number(0);
+        case OpCode::LOAD: return number(node.a == variable ? 1 : 0);
+        case OpCode::ADD: return sum(differentiate(node.a, variable), differentiate(node.b, variable));
+        case OpCode::SUBTRACT: return difference(differentiate(node.a, variable), differentiate(node.b, variable));
+        case OpCode::MULTIPLY: {
+            const Handle left = product(differentiate(node.a, variable), node.b);
+            return sum(left, product(node.a, differentiate(node.b, variable)));
+        }
+        case OpCode::DIVIDE: {
+            const Handle top = differentiate(node.a, variable);
+            const Handle bottom = differentiate(node.b, variable);
+            if (isZero(bottom)) { return quotient(top, node.b); }
+            const Handle numerator = difference(product(top, node.b), product(node.a, bottom));
+            return quotient(numerator, add(OpCode::MULTIPLY, node.b, node.b));
+        }
+        case OpCode::POWER: {
+            const Handle baseDerivative = differentiate(node.a, variable);
+            const Handle exponentDerivative = differentiate(node.b, variable);
+            if (isZero(exponentDerivative)) {
+                if (isZero(baseDerivative)) { return baseDerivative; }
+                const Handle lowered = add(OpCode::POWER, node.a, difference(node.b, number(1)));
+                return product(product(node.b, lowered), baseDerivative);
+            }
+            const Handle logarithmic = product(exponentDerivative, add(OpCode::LN, node.a, 0));
+            const Handle polynomial = quotient(product(node.b, baseDerivative), node.a);
+            return product(index, sum(logarithmic, polynomial));
+        }
+        case OpCode::LOG: {
+            const Handle valueDerivative = differentiate(node.a, variable);
+            const Handle baseDerivative = differentiate(node.b, variable);
+            if (isZero(baseDerivative)) { return quotient(valueDerivative, product(node.a, add(OpCode::LN, node.b, 0))); }
+            const Handle baseLog = add(OpCode::LN, node.b, 0);
+            const Handle valueTerm = product(quotient(valueDerivative, node.a), baseLog);
+            const Handle baseTerm = product(add(OpCode::LN, node.a, 0), quotient(baseDerivative, node.b));
+            return quotient(difference(valueTerm, baseTerm), add(OpCode::MULTIPLY, baseLog, baseLog));
+        }
+        case OpCode::NEGATE: return negation(differentiate(node.a, variable));
+        case OpCode::LN: return quotient(differentiate(node.a, variable), node.a);
+        default: break;
+    }
+
+    // The single-argument functions all scale the operand's derivative, so a constant operand gives zero
+    const Handle inner = differentiate(node.a, variable);
+    if (isZero(inner)) { return inner; }
+    const auto square = [this](const Handle operand) { return add(OpCode::MULTIPLY, operand, operand); };
+    const auto unary = [this](const OpCode op, const Handle operand) { return add(op, operand, 0); };
+    switch (node.op) {
+        case OpCode::ABS: return product(quotient(node.a, unary(OpCode::ABS, node.a)), inner);
+        case OpCode::FACTORIAL: {
+            const Handle above = unary(OpCode::FACTORIAL, sum(node.a, number(FACTORIAL_STEP)));
+            const Handle below = unary(OpCode::FACTORIAL, difference(node.a, number(FACTORIAL_STEP)));
+            return product(quotient(difference(above, below), number(2 * FACTORIAL_STEP)), inner);
+        }
+        case OpCode::SIN: return product(unary(OpCode::COS, node.a), inner);
+        case OpCode::COS: return negation(product(unary(OpCode::SIN, node.a), inner));
+        case OpCode::TAN: return quotient(inner, square(unary(OpCode::COS, node.a)));
+        case OpCode::ASIN: return quotient(inner, unary(OpCode::SQRT, difference(number(1), square(node.a))));
+        case OpCode::ACOS: return negation(quotient(inner, unary(OpCode::SQRT, difference(number(1), square(node.a)))));
+        case OpCode::ATAN: return quotient(inner, sum(number(1), square(node.a)));
+        case OpCode::EXP: return product(unary(OpCode::EXP, node.a), inner);
+        case OpCode::LOGTEN: return quotient(inner, product(node.a, number(std::log(10.0L))));
+        default: return quotient(inner, product(number(2), unary(OpCode::SQRT, node.a))); // SQRT
+    }
+}
@@ -0,0 +1,450 @@
+/**
+ * @file Jit.cpp
+ * @brief Implementation of the x86-64 code generator and the tiering policy
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * The generated function has the signature EvalStatus(const Scalar* slots, Scalar* value)
+ * under the System V calling convention. rbx holds the slot array, r14 the result pointer
+ * and r15 the constant pool, which lives at the start of the same mapping as the code.
+ * Instruction i stores its result at [rsp + i * sizeof(Scalar)], and constant and load
+ * instructions emit nothing: later instructions read their operands where they already are.
+ * The code is written into a private mapping that is made executable, and no longer
+ * writable, before it is first run.
+ */
+
+#include "Jit.h"
+#include "Factorial.h"
+#include "FastMath.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef CALCULATOR_JIT_NATIVE
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef CALCULATOR_JIT_NATIVE
+
+// Largest native stack frame the generated code may use, in bytes; bigger programs stay in bytecode
+constexpr std::size_t MAX_FRAME = 1 << 16;
+
+// Register numbers in the x86-64 encoding
+constexpr std::uint8_t RDX = 2, RBX = 3, RSP = 4, RSI = 6, RDI = 7, R14 = 14, R15 = 15;
+
+// Signature of the functions the generated code calls for operations it does not emit inline
+template <typename Scalar>
+using Helper = EvalStatus (*)(Scalar*, const Scalar*, const Scalar*);
+
+// Runs one operation with the same domain checks as Program::interpret
+template <OpCode op, typename Scalar>
+EvalStatus callOperation(Scalar* out, const Scalar* a, const Scalar* b) {
+    const Scalar x = *a;
+    const Scalar y = *b;
+    if constexpr (op == OpCode::POWER) {
+        if (x < 0 && y != std::floor(y)) { return EvalStatus::NEGATIVE_BASE; }
+        *out = std::pow(x, y);
+    } else if constexpr (op == OpCode::FACTORIAL) {
+        if (x < 0) { return EvalStatus::NEGATIVE_FACTORIAL; }
+        *out = static_cast<Scalar>(factorial(x));
+    } else if constexpr (op == OpCode::SIN) {
+        *out = std::sin(x);
+    } else if constexpr (op == OpCode::COS) {
+        *out = std::cos(x);
+    } else if constexpr (op == OpCode::TAN) {
+        *out = std::tan(x);
+    } else if constexpr (op == OpCode::ASIN) {
+        *out = std::asin(x);
+    } else if constexpr (op == OpCode::ACOS) {
+        *out = std::acos(x);
+    } else if constexpr (op == OpCode::ATAN) {
+        *out = std::atan(x);
+    } else if constexpr (op == OpCode::EXP) {
+        *out = std::exp(x);
+    } else if constexpr (op == OpCode::LN) {
+        if (x <= 0.0) { return EvalStatus::NON_POSITIVE_LOGARITHM; }
+        *out = std::log(x);
+    } else if constexpr (op == OpCode::LOGTEN) {
+        if (x <= 0.0) { return EvalStatus::NON_POSITIVE_LOGARITHM; }
+        *out = std::log10(x);
+    } else if constexpr (op == OpCode::LOG) {
+        if (y == 1.0) { return EvalStatus::LOGARITHM_BASE_ONE; }
+        if (y <= 0.0 || x <= 0.0) { return EvalStatus::NON_POSITIVE_LOGARITHM; }
+        *out = std::log(x) / std::log(y);
+    } else if constexpr (op == OpCode::FAST_SIN) {
+        *out = fastmath::sin(x);
+    } else if constexpr (op == OpCode::FAST_COS) {
+        *out = fastmath::cos(x);
+    } else if constexpr (op == OpCode::FAST_TAN) {
+        *out = fastmath::tan(x);
+    } else if constexpr (op == OpCode::FAST_EXP) {
+        *out = fastmath::exp(x);
+    } else if constexpr (op == OpCode::FAST_LN) {
+        if (x <= 0.0) { return EvalStatus::NON_POSITIVE_LOGARITHM; }
+        *out = fastmath::ln(x);
+    } else if constexpr (op == OpCode::FAST_LOGTEN) {
+        if (x <= 0.0) { return EvalStatus::NON_POSITIVE_LOGARITHM; }
+        *out = fastmath::log10(x);
+    } else if constexpr (op == OpCode::FAST_LOG) {
+        if (y == 1.0) { return EvalStatus::LOGARITHM_BASE_ONE; }
+        if (y <= 0.0 || x <= 0.0) { return EvalStatus::NON_POSITIVE_LOGARITHM; }
+        *out = fastmath::ln(x) / fastmath::ln(y);
+    }
+    return EvalStatus::OK;
+}
+
+// The helper implementing an operation, or nullptr for the operations emitted inline
+template <typename Scalar>
+Helper<Scalar> helperFor(const OpCode op) {
+    switch (op) {
+        case OpCode::POWER: return callOperation<OpCode::POWER, Scalar>;
+        case OpCode::FACTORIAL: return callOperation<OpCode::FACTORIAL, Scalar>;
+        case OpCode::SIN: return callOperation<OpCode::SIN, Scalar>;
+        case OpCode::COS: return callOperation<OpCode::COS, Scalar>;
+        case OpCode::TAN: return callOperation<OpCode::TAN, Scalar>;
+        case OpCode::ASIN: return callOperation<OpCode::ASIN, Scalar>;
+        case OpCode::ACOS: return callOperation<OpCode::ACOS, Scalar>;
+        case OpCode::ATAN: return callOperation<OpCode::ATAN, Scalar>;
+        case OpCode::EXP: return callOperation<OpCode::EXP, Scalar>;
+        case OpCode::LN: return callOperation<OpCode::LN, Scalar>;
+        case OpCode::LOGTEN: return callOperation<OpCode::LOGTEN, Scalar>;
+        case OpCode::LOG: return callOperation<OpCode::LOG, Scalar>;
+        case OpCode::FAST_SIN: return callOperation<OpCode::FAST_SIN, Scalar>;
+        case OpCode::FAST_COS: return callOperation<OpCode::FAST_COS, Scalar>;
+        case OpCode::FAST_TAN: return callOperation<OpCode::FAST_TAN, Scalar>;
+        case OpCode::FAST_EXP: return callOperation<OpCode::FAST_EXP, Scalar>;
+        case OpCode::FAST_LN: return callOperation<OpCode::FAST_LN, Scalar>;
+        case OpCode::FAST_LOGTEN: return callOperation<OpCode::FAST_LOGTEN, Scalar>;
+        case OpCode::FAST_LOG: return callOperation<OpCode::FAST_LOG, Scalar>;
+        default: return nullptr;
+    }
+}
+
+/**
+ * @struct Memory
+ * @brief A [base + disp32] memory operand
+ */
+struct Memory {
+    std::uint8_t base;   ///< Base register
+    std::int32_t offset; ///< Displacement from the base
+};
+
+/**
+ * @class Assembler
+ * @brief Appends encoded x86-64 instructions to a byte buffer
+ *
+ * Only the handful of instruction forms the code generator needs are encoded. Jumps
+ * are always rel32 and are patched once their target is known.
+ */
+class Assembler {
+public:
+    std::vector<std::uint8_t> code; ///< Encoded instructions
+
+    void byte(const std::uint8_t value) { code.push_back(value); }
+
+    void bytes(std::initializer_list<std::uint8_t> values) { code.insert(code.end(), values); }
+
+    void dword(const std::uint32_t value) {
+        for (int shift = 0; shift < 32; shift += 8) { byte(static_cast<std::uint8_t>(value >> shift)); }
+    }
+
+    void qword(const std::uint64_t value) {
+        for (int shift = 0; shift < 64; shift += 8) { byte(static_cast<std::uint8_t>(value >> shift)); }
+    }
+
+    // REX prefix for a reg field and a base register, omitted when it would be empty
+    void rex(const bool wide, const std::uint8_t reg, const std::uint8_t base) {
+        const std::uint8_t prefix = 0x40 | (wide ? 8 : 0) | ((reg >> 3) << 2) | (base >> 3);
+        if (prefix != 0x40) { byte(prefix); }
+    }
+
+    // ModRM, SIB when the base needs one, and a 32-bit displacement
+    void operand(const std::uint8_t reg, const Memory m) {
+        byte(static_cast<std::uint8_t>(0x80 | ((reg & 7) << 3) | (m.base & 7)));
+        if ((m.base & 7) == RSP) { byte(0x24); }
+        dword(static_cast<std::uint32_t>(m.offset));
+    }
+
+    // An instruction whose only operands are a reg field and a memory operand
+    void memoryForm(const std::uint8_t prefix, std::initializer_list<std::uint8_t> opcode, const std::uint8_t reg,
+                    const Memory m, const bool wide = false) {
+        if (prefix) { byte(prefix); }
+        rex(wide, reg, m.base);
+        bytes(opcode);
+        operand(reg, m);
+    }
+
+    void lea(const std::uint8_t reg, const Memory m) { memoryForm(0, {0x8D}, reg, m, true); }
+
+    // Emits a jump or conditional jump with a placeholder target and returns the position to patch
+    std::size_t jump(std::initializer_list<std::uint8_t> opcode) {
+        bytes(opcode);
+        dword(0);
+        return code.size() - 4;
+    }
+
+    // Points a jump emitted by jump() at the current position
+    void bind(const std::size_t patch) { bind(patch, code.size()); }
+
+    void bind(const std::size_t patch, const std::size_t target) {
+        const auto delta = static_cast<std::uint32_t>(static_cast<std::int64_t>(target) - static_cast<std::int64_t>(patch + 4));
+        std::memcpy(code.data() + patch, &delta, 4);
+    }
+};
+
+/**
+ * @class Generator
+ * @brief Translates one program into machine code for one scalar type
+ */
+template <typename Scalar>
+class Generator {
+private:
+    static constexpr bool X87 = std::is_same_v<Scalar, long double>;  ///< Whether the type lives on the x87 stack
+    static constexpr std::uint8_t SSE = std::is_same_v<Scalar, double> ? 0xF2 : 0xF3; ///< sd or ss prefix
+    static constexpr auto SIZE = static_cast<std::int32_t>(sizeof(Scalar));     ///< Bytes per value
+
+    const std::vector<Instruction>& instructions; ///< Program being translated
+    Memory signMask;                              ///< Constant holding -0, for negation and absolute value in SSE
+    Assembler as;                                 ///< Output
+    std::vector<std::pair<std::size_t, EvalStatus>> failures; ///< Jumps taken on a domain error, with the status to return
+
+    // Where the value of register i lives
+    [[nodiscard]] Memory value(const std::uint32_t i) const {
+        const Instruction& ins = instructions[i];
+        if (ins.op == OpCode::CONSTANT) { return {R15, static_cast<std::int32_t>(ins.a) * SIZE}; }
+        if (ins.op == OpCode::LOAD) { return {RBX, static_cast<std::int32_t>(ins.a) * SIZE}; }
+        return {RSP, static_cast<std::int32_t>(i) * SIZE};
+    }
+
+    // Pushes a value onto the x87 stack, or loads it into an xmm register
+    void load(const Memory m, const std::uint8_t xmm = 0) {
+        if constexpr (X87) { as.memoryForm(0, {0xDB}, 5, m); }
+        else { as.memoryForm(SSE, {0x0F, 0x10}, xmm, m); }
+    }
+
+    // Pops the x87 stack, or stores an xmm register, into memory
+    void store(const Memory m, const std::uint8_t xmm = 0) {
+        if constexpr (X87) { as.memoryForm(0, {0xDB}, 7, m); }
+        else { as.memoryForm(SSE, {0x0F, 0x11}, xmm, m); }
+    }
+
+    // Compares zero with a value, leaving the flags as for ucomi(0, value) and the register state unchanged
+    void compareZero(const Memory m) {
+        if constexpr (X87) {
+            load(m);
+            as.bytes({0xD9, 0xEE});  // fldz
+            as.bytes({0xDF, 0xE9});  // fucomip st, st(1)
+            as.bytes({0xDD, 0xD8});  // fstp st(0)
+        } else {
+            load(m, 1);
+            as.bytes({0x0F, 0x57, 0xC0}); // xorps xmm0, xmm0
+            if constexpr (std::is_same_v<Scalar, double>) { as.byte(0x66); }
+            as.bytes({0x0F, 0x2E, 0xC1}); // ucomis xmm0, xmm1
+        }
+    }
+
+    // Returns status from the generated function if the condition holds
+    void failIf(const std::uint8_t condition, const EvalStatus status) {
+        failures.emplace_back(as.jump({0x0F, condition}), status);
+    }
+
+    void binary(const Instruction& ins, const std::uint8_t x87, const std::uint8_t sse, const Memory out) {
+        if constexpr (X87) {
+            load(value(ins.a));
+            load(value(ins.b));
+            as.bytes({0xDE, x87}); // fop st(1), st(0) and pop
+            store(out);
+        } else {
+            load(value(ins.a));
+            as.memoryForm(SSE, {0x0F, sse}, 0, value(ins.b));
+            store(out);
+        }
+    }
+
+    // Emits one instruction, writing its result to out
+    void emit(const Instruction& ins, const Memory out) {
+        switch (ins.op) {
+            case OpCode::CONSTANT:
+            case OpCode::LOAD:
+                break;
+            case OpCode::ADD: binary(ins, 0xC1, 0x58, out); break;
+            case OpCode::SUBTRACT: binary(ins, 0xE9, 0x5C, out); break;
+            case OpCode::MULTIPLY: binary(ins, 0xC9, 0x59, out); break;
+            case OpCode::DIVIDE: {
+                compareZero(value(ins.b));
+                const std::size_t ordered = as.jump({0x0F, 0x8A}); // jp: NaN is not zero
+                failIf(0x84, EvalStatus::DIVISION_BY_ZERO);         // je
+                as.bind(ordered);
+                binary(ins, 0xF9, 0x5E, out);
+                break;
+            }
+            case OpCode::NEGATE:
+            case OpCode::ABS:
+                load(value(ins.a));
+                if constexpr (X87) {
+                    as.bytes({0xD9, static_cast<std::uint8_t>(ins.op == OpCode::NEGATE ? 0xE0 : 0xE1)}); // fchs, fabs
+                    store(out);
+                } else {
+                    load(signMask, 1);
+                    if (ins.op == OpCode::NEGATE) {
+                        as.bytes({0x0F, 0x57, 0xC1}); // xorps xmm0, xmm1
+                        store(out);
+                    } else {
+                        as.bytes({0x0F, 0x55, 0xC8}); // andnps xmm1, xmm0
+                        store(out, 1);
+                    }
+                }
+                break;
+            case OpCode::SQRT:
+                compareZero(value(ins.a));
+                failIf(0x87, EvalStatus::NEGATIVE_SQUARE_ROOT); // ja: zero is above the value
+                load(value(ins.a));
+                if constexpr (X87) { as.bytes({0xD9, 0xFA}); } // fsqrt
+                else { as.bytes({SSE, 0x0F, 0x51, 0xC0}); }    // sqrts xmm0, xmm0
+                store(out);
+                break;
+            default: {
+                as.lea(RDI, out);
+                as.lea(RSI, value(ins.a));
+                as.lea(RDX, value(ins.op == OpCode::LOG || ins.op == OpCode::FAST_LOG || ins.op == OpCode::POWER ? ins.b : ins.a));
+                as.bytes({0x48, 0xB8}); // mov rax, imm64
+                as.qword(reinterpret_cast<std::uint64_t>(helperFor<Scalar>(ins.op)));
+                as.bytes({0xFF, 0xD0}); // call rax
+                as.bytes({0x85, 0xC0}); // test eax, eax
+                exits.push_back(as.jump({0x0F, 0x85})); // jnz: eax already holds the status
+                break;
+            }
+        }
+    }
+
+    std::vector<std::size_t> exits; ///< Jumps to the epilogue with the status already in eax
+
+public:
+
+    Generator(const std::vector<Instruction>& instructions, const Memory signMask)
+        : instructions(instructions), signMask(signMask) {}
+
+    // Generates the whole function, with the constant pool at the given address
+    std::vector<std::uint8_t> generate(const std::uint32_t result, const std::uintptr_t pool, const std::int32_t frame) {
+        as.byte(0x53);                         // push rbx
+        as.bytes({0x41, 0x56});                // push r14
+        as.bytes({0x41, 0x57});                // push r15
+        as.bytes({0x48, 0x81, 0xEC});          // sub rsp, frame
+        as.dword(static_cast<std::uint32_t>(frame));
+        as.bytes({0x48, 0x89, 0xFB});          // mov rbx, rdi
+        as.bytes({0x49, 0x89, 0xF6});          // mov r14, rsi
+        as.bytes({0x49, 0xBF});                // mov r15, pool
+        as.qword(pool);
+
+        for (std::uint32_t i = 0; i < instructions.size(); ++i) { emit(instructions[i], value(i)); }
+
+        load(value(result));
+        store({R14, 0});
+        as.bytes({0x31, 0xC0});                // xor eax, eax
+        const std::size_t epilogue = as.code.size();
+        as.bytes({0x48, 0x81, 0xC4});          // add rsp, frame
+        as.dword(static_cast<std::uint32_t>(frame));
+        as.bytes({0x41, 0x5F});                // pop r15
+        as.bytes({0x41, 0x5E});                // pop r14
+        as.byte(0x5B);                         // pop rbx
+        as.byte(0xC3);                         // ret
+
+        for (const std::size_t patch : exits) { as.bind(patch, epilogue); }
+        for (const auto& [patch, status] : failures) {
+            as.bind(patch);
+            as.byte(0xB8);                     // mov eax, status
+            as.dword(static_cast<std::uint32_t>(status));
+            as.bind(as.jump({0xE9}), epilogue); // jmp epilogue
+        }
+        return std::move(as.code);
+    }
+};
+
+#endif // CALCULATOR_JIT_NATIVE
+
+} // namespace
+
+NativeProgram::NativeProgram(void* memory, const std::size_t mappedSize, const void* entry, const Precision precision)
+    : memory(memory), mappedSize(mappedSize), entry(entry), precision(precision) {}
+
+NativeProgram::~NativeProgram() {
+#ifdef CALCULATOR_JIT_NATIVE
+    munmap(memory, mappedSize);
+#endif
+}
+
+// Lays out the narrowed constant pool and the code in one mapping, then makes it executable
+template <typename Scalar>
+std::unique_ptr<NativeProgram> NativeProgram::compile(const Program& program) {
+#ifdef CALCULATOR_JIT_NATIVE
+    if constexpr (std::is_same_v<Scalar, long double> && LDBL_MANT_DIG != 64) {
+        return nullptr; // long double is not the x87 extended type
+    } else {
+        const std::size_t frame = (program.instructions.size() * sizeof(Scalar) + 15) & ~std::size_t(15);
+        if (program.instructions.empty() || frame > MAX_FRAME || program.hasRoutines()) { return nullptr; }
+
+        // Constants first, then the sign mask, then the code on a 16-byte boundary
+        std::vector<Scalar> pool(program.constants.begin(), program.constants.end());
+        pool.push_back(-Scalar(0));
+        const std::size_t poolBytes = (pool.size() * sizeof(Scalar) + 15) & ~std::size_t(15);
+        const Memory signMask{R15, static_cast<std::int32_t>((pool.size() - 1) * sizeof(Scalar))};
+
+        // Code size depends only on the instructions, so generate once to measure and again at the final address
+        Generator<Scalar> sizing(program.instructions, signMask);
+        const std::size_t codeBytes = sizing.generate(program.result, 0, static_cast<std::int32_t>(frame)).size();
+        const auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        const std::size_t mappedSize = (poolBytes + codeBytes + page - 1) / page * page;
+
+        void* memory = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) { return nullptr; }
+        auto* bytes = static_cast<std::uint8_t*>(memory);
+        std::memcpy(bytes, pool.data(), pool.size() * sizeof(Scalar));
+
+        Generator<Scalar> generator(program.instructions, signMask);
+        const std::vector<std::uint8_t> code = generator.generate(program.result, reinterpret_cast<std::uintptr_t>(bytes),
+                                                                  static_cast<std::int32_t>(frame));
+        std::memcpy(bytes + poolBytes, code.data(), code.size());
+        if (mprotect(memory, mappedSize, PROT_READ | PROT_EXEC) != 0) {
+            munmap(memory, mappedSize);
+            return nullptr;
+        }
+
+        const Precision precision = std::is_same_v<Scalar, long double> ? Precision::LONG_DOUBLE
+                                    : std::is_same_v<Scalar, double>    ? Precision::DOUBLE
+                                                                        : Precision::FLOAT;
+        return std::unique_ptr<NativeProgram>(new NativeProgram(memory, mappedSize, bytes + poolBytes, precision));
+    }
+#else
+    (void)program;
+    return nullptr;
+#endif
+}
+
+// Translates at most once; a failed translation leaves the program in bytecode for good
+template <typename Scalar>
+void JitTier::tierUp(const Program& program) {
+    const std::size_t k = index<Scalar>();
+    std::lock_guard<std::mutex> lock(compiling);
+    if (attempted[k]) { return; }
+    attempted[k] = true;
+    owned[k] = NativeProgram::compile<Scalar>(program);
+    native[k].store(owned[k].get(), std::memory_order_release);
+}
+
+// The precisions native code can be generated for
+template std::unique_ptr<NativeProgram> NativeProgram::compile<long double>(const Program&);
+template std::unique_ptr<NativeProgram> NativeProgram::compile<double>(const Program&);
+template std::unique_ptr<NativeProgram> NativeProgram::compile<float>(const Program&);
+template void JitTier::tierUp<long double>(const Program&);
+template void JitTier::tierUp<double>(const Program&);
+template void JitTier::tierUp<float>(const Program&);
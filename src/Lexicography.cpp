@@ -4,88 +4,154 @@
  * @author Ethan Ye
  * @date 2025-8-18
  *
- * This file implements the Lexicography class which provides the functions to
- * tokenize input into a vector of tokens. It recognizes all the tokens in the
+ * This file implements the Lexer class, which reads one token per call, and the
+ * tokenize function built on it. It recognizes all the tokens in the
  * TokenType enum, including numbers, variables, functions, operators,
  * parentheses, and special commands like preserve and remove.
  *
  */
 
 #include "Lexicography.h"
+#include "NumberFormat.h"
 
 #include <cctype>
-#include <iostream>
+#include <istream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
-std::vector<Token> tokenize(const std::string& input) {
-    std::vector<Token> tokens;
-    for (size_t i = 0; i < input.size(); ++i) {
-        char c = input[i];
-        if (isspace(c)) { continue; }// skip whitespace
-        if (isdigit(c) || c == '.'){ // parse number, including . 
-            std::string num;
-            while (isdigit(c) || c == '.') {
-                num += c;
-                c = input[++i];
-            }
-            i--;
-            tokens.emplace_back(TokenType::NUMBER, num);
-        }
-
-        else if (isalpha(c)){ //parse variable or function
-            std::string word; // we don't know yet if it's a variable or a function so just name it word
-            while (isalpha(c) || isdigit(c) || c == '_') {
-                word += c;
-                c = input[++i];
+namespace {
+
+// Classifies a word as a function, command or variable by switching on its length and first letter,
+// so each word is compared against at most one keyword
+TokenType classifyWord(const std::string_view word) {
+    switch (word.size()) {
+        case 2:
+            if (word == "ln") { return TokenType::FUNCTION; }
+            break;
+        case 3:
+            switch (word[0]) {
+                case 's': if (word == "sin" || word == "sum") { return TokenType::FUNCTION; } break;
+                case 'c': if (word == "cos") { return TokenType::FUNCTION; } break;
+                case 't': if (word == "tan") { return TokenType::FUNCTION; } break;
+                case 'e': if (word == "exp") { return TokenType::FUNCTION; } break;
+                case 'l': if (word == "log") { return TokenType::FUNCTION; } break;
+                case 'a': if (word == "abs") { return TokenType::FUNCTION; } break;
+                case 'p': if (word == "pow") { return TokenType::FUNCTION; } break;
+                default: break;
             }
-            i--;
-
-            // if the word is a recognized function name then it's a function token
-            if (word == "sin" ||
-                word == "cos" ||
-                word == "tan" ||
-                word == "asin" ||
-                word == "acos" ||
-                word == "atan" ||
-                word == "exp" ||
-                word == "log" ||
-                word == "sqrt" ||
-                word == "logten" ||
-                word == "ln" ||
-                word == "abs" ||
-                word == "pow" ||
-                word == "fact"
-            ){
-                tokens.emplace_back(TokenType::FUNCTION, word);
+            break;
+        case 4:
+            switch (word[0]) {
+                case 'a': if (word == "asin" || word == "acos" || word == "atan") { return TokenType::FUNCTION; } break;
+                case 's': if (word == "sqrt") { return TokenType::FUNCTION; } break;
+                case 'f': if (word == "fact") { return TokenType::FUNCTION; } break;
+                case 'd': if (word == "diff") { return TokenType::FUNCTION; } break;
+                default: break;
             }
+            break;
+        case 5:
+            if (word == "solve" || word == "log10") { return TokenType::FUNCTION; }
+            break;
+        case 6:
+            if (word == "remove") { return TokenType::REMOVE; }
+            break;
+        case 8:
+            if (word == "preserve") { return TokenType::PRESERVE; }
+            break;
+        case 9:
+            if (word == "integrate") { return TokenType::FUNCTION; }
+            break;
+        default: break;
+    }
+    return TokenType::VARIABLE;
+}
 
-            // if the word is "preserve" or "remove" then it's a special command token
-            else if (word == "preserve") { tokens.emplace_back(TokenType::PRESERVE, word); }
-            else if (word == "remove") { tokens.emplace_back(TokenType::REMOVE, word); }
-
-            // otherwise it's a variable token
-            else { tokens.emplace_back(TokenType::VARIABLE, word); }
-        }
-        else { // parse operators and punctuation, and throw runtime error when not recognized, using switch case for easier editing, clarity, and adding new operators
-            switch (c) {
-                case '+': tokens.emplace_back(TokenType::PLUS, "+"); break;
-                case '-': tokens.emplace_back(TokenType::MINUS, "-"); break;
-                case '*': tokens.emplace_back(TokenType::MULTIPLY, "*"); break;
-                case '/': tokens.emplace_back(TokenType::DIVIDE, "/"); break;
-                case '^': tokens.emplace_back(TokenType::POWER, "^"); break;
-                case '(': tokens.emplace_back(TokenType::LEFTPAREN, "("); break;
-                case ')': tokens.emplace_back(TokenType::RIGHTPAREN, ")"); break;
-                case '=': tokens.emplace_back(TokenType::ASSIGN, "="); break;
-                case ',': tokens.emplace_back(TokenType::COMMA, ","); break;
-                case '|': tokens.emplace_back(TokenType::ABS, "|"); break;
-                case '!': tokens.emplace_back(TokenType::FACTORIAL, "!"); break;
-                default: throw std::runtime_error(std::string(1, c) + " is not recognized as a variable, function, or operation");
-            }
-        }
+} // namespace
+
+Lexer::Lexer(const std::string_view input) : text(input) {}
+
+Lexer::Lexer(std::istream& input, const std::size_t chunkSize) : stream(&input), chunkSize(chunkSize) {}
+
+bool Lexer::available() {
+    while (position >= text.size()) {
+        if (!refill()) { return false; }
+    }
+    return true;
+}
+
+// Keeps the token being read, so its text survives the move, and appends the next chunk after it
+bool Lexer::refill() {
+    if (!stream || !*stream) { return false; }
+    buffer.erase(0, tokenStart);
+    position -= tokenStart;
+    tokenStart = 0;
+
+    const std::size_t kept = buffer.size();
+    buffer.resize(kept + chunkSize);
+    stream->read(buffer.data() + kept, static_cast<std::streamsize>(chunkSize));
+    buffer.resize(kept + static_cast<std::size_t>(stream->gcount()));
+    text = buffer;
+    return buffer.size() > kept;
+}
+
+// Peeks one character past position, which available() may have to read first
+bool Lexer::rangeAhead() {
+    ++position;
+    const bool dot = available() && text[position] == '.';
+    --position;
+    return dot;
+}
+
+Token Lexer::next() {
+    while (available() && isspace(static_cast<unsigned char>(text[position]))) { ++position; } // skip whitespace
+    tokenStart = position;
+    if (!available()) { return Token(TokenType::END, " "); } // end token
+
+    const char c = text[position];
+    if (c == '.' && rangeAhead()) { // .. between the bounds of a sweep, as in 0..10
+        position += 2;
+        return Token(TokenType::RANGE, "..");
+    }
+    if (isdigit(c) || c == '.'){ // parse number, including ., but stop before a ..
+        while (available() && (isdigit(text[position]) || (text[position] == '.' && !rangeAhead()))) { ++position; }
+        const std::string_view num = text.substr(tokenStart, position - tokenStart);
+        return Token(TokenType::NUMBER, num, parseNumber(num));
+    }
+
+    if (isalpha(c)){ //parse variable or function
+        // we don't know yet if it's a variable, a function or a command so just name it word
+        while (available() && (isalpha(text[position]) || isdigit(text[position]) || text[position] == '_')) { ++position; }
+        const std::string_view word = text.substr(tokenStart, position - tokenStart);
+
+        // recognized function names become function tokens, "preserve" and "remove" become
+        // special command tokens, and anything else is a variable
+        return Token(classifyWord(word), word);
+    }
+
+    // parse operators and punctuation, and throw runtime error when not recognized, using switch case for easier editing, clarity, and adding new operators
+    ++position;
+    switch (c) {
+        case '+': return Token(TokenType::PLUS, "+");
+        case '-': return Token(TokenType::MINUS, "-");
+        case '*': return Token(TokenType::MULTIPLY, "*");
+        case '/': return Token(TokenType::DIVIDE, "/");
+        case '^': return Token(TokenType::POWER, "^");
+        case '(': return Token(TokenType::LEFTPAREN, "(");
+        case ')': return Token(TokenType::RIGHTPAREN, ")");
+        case '=': return Token(TokenType::ASSIGN, "=");
+        case ',': return Token(TokenType::COMMA, ",");
+        case '|': return Token(TokenType::ABS, "|");
+        case '!': return Token(TokenType::FACTORIAL, "!");
+        default: throw std::runtime_error(std::string(1, c) + " is not recognized as a variable, function, or operation");
     }
-    tokens.emplace_back(TokenType::END, " "); // end token
-    return tokens;
 }
 
+// Collects every token of the input, ending with the END token
+std::vector<Token> tokenize(const std::string_view input) {
+    Lexer lexer(input);
+    std::vector<Token> tokens;
+    do { tokens.push_back(lexer.next()); } while (tokens.back().type != TokenType::END);
+    return tokens;
+}
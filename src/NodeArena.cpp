@@ -0,0 +1,84 @@
+/**
+ * @file NodeArena.cpp
+ * @brief Implementation of the NodeArena bump allocator
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * Allocations are bumped out of the last chunk, and a new chunk is requested from the
+ * heap only when it runs out. Each node carries a one-word header, padded to the maximum
+ * alignment, that points back at its arena (or is null for heap nodes).
+ */
+
+#include "NodeArena.h"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+namespace {
+
+// Arena used for node allocations on this thread
+thread_local NodeArena* activeArena = nullptr;
+
+// Space reserved in front of every node to remember its arena
+constexpr std::size_t HEADER_SIZE = alignof(std::max_align_t);
+
+// Rounds bytes up to the maximum alignment
+constexpr std::size_t alignUp(const std::size_t bytes) {
+    return (bytes + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+}
+
+} // namespace
+
+NodeArena::NodeArena(const std::size_t blockSize) : blockSize(blockSize) {}
+
+// Bumps the last chunk, starting a new one when it is full
+void* NodeArena::allocate(std::size_t bytes) {
+    bytes = alignUp(bytes);
+    if (blocks.empty() || blocks.back().size - blocks.back().used < bytes) {
+        const std::size_t size = bytes > blockSize ? bytes : blockSize;
+        blocks.push_back({std::make_unique<std::byte[]>(size), size, 0});
+    }
+    Block& block = blocks.back();
+    void* pointer = block.data.get() + block.used;
+    block.used += bytes;
+    ++liveNodes;
+    return pointer;
+}
+
+// Drops every chunk but the first and rewinds it
+void NodeArena::reset() {
+    if (liveNodes != 0) {
+        throw std::logic_error("node arena reset while nodes are still alive");
+    }
+    if (blocks.size() > 1) { blocks.erase(blocks.begin() + 1, blocks.end()); }
+    if (!blocks.empty()) { blocks.front().used = 0; }
+}
+
+NodeArena* NodeArena::current() {
+    return activeArena;
+}
+
+// Places the node in the active arena if there is one, tagging it with its origin
+void* NodeArena::allocateNode(const std::size_t bytes) {
+    void* memory = activeArena ? activeArena->allocate(HEADER_SIZE + bytes) : ::operator new(HEADER_SIZE + bytes);
+    *static_cast<NodeArena**>(memory) = activeArena;
+    return static_cast<std::byte*>(memory) + HEADER_SIZE;
+}
+
+// Frees heap nodes; arena nodes are only counted and reclaimed on reset
+void NodeArena::deallocateNode(void* pointer) noexcept {
+    if (!pointer) { return; }
+    void* memory = static_cast<std::byte*>(pointer) - HEADER_SIZE;
+    if (NodeArena* arena = *static_cast<NodeArena**>(memory)) { arena->release(); }
+    else { ::operator delete(memory); }
+}
+
+NodeArena::Scope::Scope(NodeArena& arena) : previous(activeArena) {
+    activeArena = &arena;
+}
+
+NodeArena::Scope::~Scope() {
+    activeArena = previous;
+}
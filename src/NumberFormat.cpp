@@ -0,0 +1,190 @@
+/**
+ * @file NumberFormat.cpp
+ * @brief Implementation of the number parsing and formatting layer
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * Values are formatted into a stack buffer and appended in one go. Fixed notation of a
+ * huge long double can run to thousands of digits, so that case alone falls back to a
+ * buffer sized for the largest finite value.
+ */
+
+#include "NumberFormat.h"
+#include "Bytecode.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace {
+
+constexpr std::size_t LOCAL_BUFFER = 128;                    ///< Enough for every format but huge fixed values
+constexpr std::size_t FIXED_BUFFER = LDBL_MAX_10_EXP + 64;   ///< Enough for any long double in fixed notation
+
+// Units of the 17th significant digit within which a long double and its nearest double may round differently.
+// Their relative difference is below 2^-53, at most 11 units for a leading 9, and printing the double adds half a unit.
+constexpr std::int64_t ROUNDING_MARGIN = 16;
+
+// Decimal digits of a value, most significant first, with the exponent of the first one
+struct Digits {
+    char text[DBL_DECIMAL_DIG + 1];
+    int exponent = 0;
+    bool negative = false;
+};
+
+// Writes digits[0, count) in plain notation, without trailing zeros after the point
+char* writeFixed(char* out, const Digits& digits, int count) {
+    while (count > 1 && digits.text[count - 1] == '0') { --count; }
+    if (digits.negative) { *out++ = '-'; }
+    const char* text = digits.text;
+    if (digits.exponent < 0) {
+        *out++ = '0';
+        *out++ = '.';
+        out = std::fill_n(out, -digits.exponent - 1, '0');
+        return std::copy(text, text + count, out);
+    }
+    const int whole = digits.exponent + 1;
+    out = std::copy(text, text + std::min(count, whole), out);
+    if (count <= whole) { return std::fill_n(out, whole - count, '0'); }
+    *out++ = '.';
+    return std::copy(text + whole, text + count, out);
+}
+
+// Writes the %g form of digits[0, count)
+char* writeGeneral(char* out, const Digits& digits, int count, const int precision) {
+    if (digits.exponent >= -4 && digits.exponent < precision) { return writeFixed(out, digits, count); }
+    while (count > 1 && digits.text[count - 1] == '0') { --count; } // %g drops trailing zeros
+    if (digits.negative) { *out++ = '-'; }
+    *out++ = digits.text[0];
+    if (count > 1) {
+        *out++ = '.';
+        out = std::copy(digits.text + 1, digits.text + count, out);
+    }
+    *out++ = 'e';
+    *out++ = digits.exponent < 0 ? '-' : '+';
+    const int magnitude = digits.exponent < 0 ? -digits.exponent : digits.exponent;
+    if (magnitude < 10) { *out++ = '0'; }
+    return std::to_chars(out, out + 4, magnitude).ptr;
+}
+
+// The 17 significant digits of the double nearest to a long double, false when it is zero, subnormal or not finite
+bool nearestDigits(const long double value, Digits& digits) {
+    const double nearest = static_cast<double>(value);
+    if (!std::isnormal(nearest)) { return false; }
+    char text[32];
+    const char* end = std::to_chars(text, text + sizeof(text), std::fabs(nearest), std::chars_format::scientific, 16).ptr;
+    digits.text[0] = text[0];
+    std::copy(text + 2, text + 2 + (DBL_DECIMAL_DIG - 1), digits.text + 1);
+    const char* sign = text + 1 + DBL_DECIMAL_DIG + 1; // past "d.", the other 16 digits and "e"
+    std::from_chars(sign + 1, end, digits.exponent);
+    if (*sign == '-') { digits.exponent = -digits.exponent; }
+    digits.negative = std::signbit(nearest);
+    return true;
+}
+
+// Rounds the digits of the nearest double to a precision. Those 17 digits pin down the long
+// double's own rounding unless they lie next to a rounding boundary, where this gives up.
+bool roundDigits(Digits& digits, const int precision) {
+    if (precision < 1 || precision > DBL_DIG) { return false; }
+
+    // The dropped digits, compared with one half in units of the last of the 17 digits
+    std::int64_t dropped = 0;
+    for (int i = precision; i < DBL_DECIMAL_DIG; ++i) { dropped = dropped * 10 + (digits.text[i] - '0'); }
+    std::int64_t half = 5;
+    for (int i = precision + 1; i < DBL_DECIMAL_DIG; ++i) { half *= 10; }
+    if (dropped > half - ROUNDING_MARGIN && dropped < half + ROUNDING_MARGIN) { return false; }
+
+    if (dropped > half) {
+        int i = precision - 1;
+        while (i >= 0 && digits.text[i] == '9') { digits.text[i--] = '0'; }
+        if (i >= 0) { ++digits.text[i]; }
+        else {
+            digits.text[0] = '1'; // 9.99... rounded up to the next power of ten
+            ++digits.exponent;
+        }
+    }
+    return true;
+}
+
+// %g-style output for a digit count, the shortest round trip of the value's own type otherwise
+template <typename Scalar>
+void appendAs(std::string& out, const Scalar value, const int digits) {
+    char buffer[LOCAL_BUFFER];
+    const int clamped = std::min(digits, MAX_DIGITS);
+    if (clamped > 0) {
+        // Through the nearest double, which to_chars formats several times faster than a long double
+        Digits rounded;
+        if (nearestDigits(value, rounded) && roundDigits(rounded, clamped)) {
+            out.append(buffer, writeGeneral(buffer, rounded, clamped, clamped));
+            return;
+        }
+    }
+    const std::to_chars_result result = clamped > 0
+        ? std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, clamped)
+        : std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+} // namespace
+
+// Converts the text of a numeric literal once, at lexing time
+long double parseNumber(const std::string_view text) {
+    double value = 0;
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error == std::errc::invalid_argument) {
+        throw std::runtime_error(std::string(text) + " is not a valid number");
+    }
+    if (error == std::errc::result_out_of_range) {
+        throw std::runtime_error(std::string(text) + " is out of range");
+    }
+    return value;
+}
+
+void appendNumber(std::string& out, const long double value, const int digits) { appendAs(out, value, digits); }
+
+void appendNumber(std::string& out, const double value, const int digits) { appendAs(out, value, digits); }
+
+void appendNumber(std::string& out, const float value, const int digits) { appendAs(out, value, digits); }
+
+// Formats in the engine's type when the value narrows to it exactly, as every value the engine computed does.
+// A value stored before the precision changed may not, and keeps its long double text.
+void appendNumber(std::string& out, const long double value, const int digits, const Precision precision) {
+    if (precision == Precision::DOUBLE && static_cast<double>(value) == value) {
+        appendAs(out, static_cast<double>(value), digits);
+    }
+    else if (precision == Precision::FLOAT && static_cast<float>(value) == value) {
+        appendAs(out, static_cast<float>(value), digits);
+    }
+    else { appendAs(out, value, digits); }
+}
+
+// %Lf, then the zeros after the last significant decimal and a dangling point are dropped
+void appendTrimmed(std::string& out, const long double value) {
+    char buffer[LOCAL_BUFFER];
+    Digits rounded;
+    if (nearestDigits(value, rounded)) {
+        const int precision = rounded.exponent + 7; // digits down to the sixth decimal
+        if (roundDigits(rounded, precision)) {
+            out.append(buffer, writeFixed(buffer, rounded, precision));
+            return;
+        }
+    }
+    std::string large;
+    char* first = buffer;
+    std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, 6);
+    if (result.ec == std::errc::value_too_large) {
+        large.resize(FIXED_BUFFER);
+        first = large.data();
+        result = std::to_chars(first, first + large.size(), value, std::chars_format::fixed, 6);
+    }
+    std::string_view text(first, static_cast<std::size_t>(result.ptr - first));
+    text = text.substr(0, text.find_last_not_of('0') + 1);
+    if (!text.empty() && text.back() == '.') { text.remove_suffix(1); }
+    out += text;
+}
@@ -0,0 +1,205 @@
+/**
+ * @file Numeric.cpp
+ * @brief Implementation of the solve, integrate and sum routines
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * Solving runs Newton's method on the program that computes both the expression and its
+ * derivative. Integrals use tanh-sinh quadrature, whose points crowd towards the ends of
+ * the interval fast enough to integrate singularities there, such as 1/sqrt(x) from 0,
+ * to the same accuracy as smooth integrands. Each level halves the step, and only its
+ * new points are evaluated. Sums walk their range in blocks. In both, every point of a
+ * pass goes to the batch evaluator in one call. All arithmetic is done in the precision
+ * the enclosing program runs in, in buffers that the caller keeps from one run to the next.
+ */
+
+#include "Bytecode.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace {
+
+constexpr int MAX_STEPS = 100;          ///< Newton steps tried before solve gives up
+constexpr int MAX_LEVEL = 12;           ///< Halvings of the quadrature step before integrate gives up
+constexpr long double SPAN = 6.5L;      ///< Points of the quadrature are taken for t in [-SPAN, SPAN]
+constexpr long double HALF_PI = 1.5707963267948966192313216916397514L;
+constexpr std::size_t SUM_BLOCK = 4096; ///< Terms of a sum evaluated per batch
+
+// Tolerances in units of the precision's epsilon: a Newton step relative to the root, and the
+// change between integral estimates relative to the integral of the magnitude
+constexpr int SOLVE_TOLERANCE = 16;
+constexpr int INTEGRAL_TOLERANCE = 1000;
+
+// Neumaier's compensated sum, so long sums and fine quadratures keep the precision's accuracy
+template <typename Scalar>
+class Accumulator {
+private:
+    Scalar total = 0;
+    Scalar compensation = 0;
+
+public:
+    void add(const Scalar term) {
+        const Scalar next = total + term;
+        compensation += std::abs(total) >= std::abs(term) ? (total - next) + term : (term - next) + total;
+        total = next;
+    }
+
+    [[nodiscard]] Scalar value() const { return total + compensation; }
+};
+
+// The columns of a batch over the body: the variable's slot reads points, the others a single value
+template <typename Scalar>
+void broadcast(RoutineScratch<Scalar>& scratch, const std::size_t count) {
+    scratch.columns.resize(count);
+    for (std::size_t slot = 0; slot < count; ++slot) { scratch.columns[slot] = {scratch.slots.data() + slot, 0}; }
+}
+
+} // namespace
+
+template <typename Scalar>
+EvalStatus Routine::run(const OpCode op, RoutineScratch<Scalar>& scratch, const Scalar first, const Scalar second, Scalar& value) const {
+    switch (op) {
+        case OpCode::SOLVE: return solve(scratch, first, value);
+        case OpCode::INTEGRATE: return integrate(scratch, first, second, value);
+        default: return sum(scratch, first, second, value);
+    }
+}
+
+// Newton's method, with the value and the slope from one run of the body
+template <typename Scalar>
+EvalStatus Routine::solve(RoutineScratch<Scalar>& scratch, const Scalar guess, Scalar& root) const {
+    const Scalar tolerance = SOLVE_TOLERANCE * std::numeric_limits<Scalar>::epsilon();
+    Scalar* slots = scratch.slots.data();
+    std::vector<Scalar>& registers = scratch.registers;
+    if (registers.size() < body.size()) { registers.resize(body.size()); }
+    Scalar x = guess;
+    for (int step = 0; step < MAX_STEPS; ++step) {
+        if (variable != NO_SLOT) { slots[variable] = x; }
+        if (const EvalStatus status = body.execute(slots, registers.data()); status != EvalStatus::OK) { return status; }
+        const Scalar value = registers[body.result];
+        if (value == 0) {
+            root = x;
+            return EvalStatus::OK;
+        }
+        const Scalar delta = value / registers[slope];
+        if (!std::isfinite(delta)) { return EvalStatus::NO_ROOT; } // a flat spot, or the iteration ran away
+        x -= delta;
+        if (std::abs(delta) <= tolerance * std::max(std::abs(x), Scalar(1))) {
+            root = x;
+            return EvalStatus::OK;
+        }
+    }
+    return EvalStatus::NO_ROOT;
+}
+
+// Tanh-sinh quadrature: x = (a + b) / 2 + (b - a) / 2 tanh(pi/2 sinh t) turns the integral into one over t whose integrand
+// decays doubly exponentially, so the trapezoidal rule in t converges fast. Levels halve the step
+// until two successive estimates agree
+template <typename Scalar>
+EvalStatus Routine::integrate(RoutineScratch<Scalar>& scratch, const Scalar lower, const Scalar upper, Scalar& integral) const {
+    if (!std::isfinite(lower) || !std::isfinite(upper)) { return EvalStatus::NO_CONVERGENCE; }
+    if (lower == upper) {
+        integral = 0;
+        return EvalStatus::OK;
+    }
+    if (upper < lower) {
+        const EvalStatus status = integrate(scratch, upper, lower, integral);
+        integral = -integral;
+        return status;
+    }
+
+    const Scalar tolerance = INTEGRAL_TOLERANCE * std::numeric_limits<Scalar>::epsilon();
+    const Scalar radius = upper / 2 - lower / 2;
+    broadcast(scratch, body.slotCount());
+    std::vector<BasicSlotColumn<Scalar>>& columns = scratch.columns;
+    std::vector<Scalar>& points = scratch.points;
+    std::vector<Scalar>& weights = scratch.weights;
+    std::vector<Scalar>& values = scratch.values;
+    Accumulator<Scalar> total;     // sum of weight * value over every point so far
+    Accumulator<Scalar> magnitude; // and of weight * |value|
+    Scalar previous = 0;
+    for (int level = 0; level <= MAX_LEVEL; ++level) {
+        // The new points are the odd multiples of the step, or every multiple on the first level
+        const long double step = std::ldexp(1.0L, -level);
+        const long double stride = level == 0 ? step : 2 * step;
+        points.clear();
+        weights.clear();
+        for (long double t = level == 0 ? 0 : step; t <= SPAN; t += stride) {
+            // With e = exp(-2u), the distance of tanh(u) from 1 is 2e / (1 + e) and its derivative 4e / (1 + e)^2,
+            // both accurate far into the tails where 1 - tanh(u) would cancel to zero
+            const long double u = HALF_PI * std::sinh(t);
+            const long double e = std::exp(-2 * u);
+            const auto offset = static_cast<Scalar>(radius * (2 * e / (1 + e)));
+            const auto weight = static_cast<Scalar>(radius * (HALF_PI * std::cosh(t) * 4 * e / ((1 + e) * (1 + e))));
+            const Scalar left = lower + offset;
+            const Scalar right = upper - offset;
+            if ((left == lower && right == upper) || weight == 0) { break; } // the rest of both tails rounds onto the bounds
+            // A side is left out once its points round onto its bound, which happens sooner next to a bound of larger magnitude
+            if (right != upper) {
+                points.push_back(right);
+                weights.push_back(weight);
+            }
+            if (t != 0 && left != lower) {
+                points.push_back(left);
+                weights.push_back(weight);
+            }
+        }
+        values.resize(points.size());
+        if (variable != NO_SLOT) { columns[variable] = {points.data(), 1}; }
+        if (const EvalStatus status = body.runBatch(columns, points.size(), values.data()); status != EvalStatus::OK) { return status; }
+        for (std::size_t k = 0; k < points.size(); ++k) {
+            total.add(weights[k] * values[k]);
+            magnitude.add(weights[k] * std::abs(values[k]));
+        }
+
+        const Scalar current = total.value() * static_cast<Scalar>(step);
+        if (!std::isfinite(current)) { return EvalStatus::NO_CONVERGENCE; }
+        if (level > 2 && std::abs(current - previous) <= tolerance * magnitude.value() * static_cast<Scalar>(step)) {
+            integral = current;
+            return EvalStatus::OK;
+        }
+        previous = current;
+    }
+    return EvalStatus::NO_CONVERGENCE;
+}
+
+// Every integer from lower to upper inclusive, an empty sum when upper is below lower
+template <typename Scalar>
+EvalStatus Routine::sum(RoutineScratch<Scalar>& scratch, const Scalar lower, const Scalar upper, Scalar& total) const {
+    if (!std::isfinite(lower) || !std::isfinite(upper) || lower != std::floor(lower) || upper != std::floor(upper)) {
+        return EvalStatus::NON_INTEGER_BOUNDS;
+    }
+    if (upper < lower) {
+        total = 0;
+        return EvalStatus::OK;
+    }
+    const long double terms = static_cast<long double>(upper) - static_cast<long double>(lower) + 1;
+    if (terms > MAX_TERMS) { return EvalStatus::TOO_MANY_TERMS; }
+
+    const auto count = static_cast<std::size_t>(terms);
+    broadcast(scratch, body.slotCount());
+    std::vector<BasicSlotColumn<Scalar>>& columns = scratch.columns;
+    std::vector<Scalar>& points = scratch.points;
+    std::vector<Scalar>& values = scratch.values;
+    points.resize(std::min(count, SUM_BLOCK));
+    values.resize(points.size());
+    if (variable != NO_SLOT) { columns[variable] = {points.data(), 1}; }
+    Accumulator<Scalar> accumulated;
+    for (std::size_t start = 0; start < count; start += SUM_BLOCK) {
+        const std::size_t n = std::min(SUM_BLOCK, count - start);
+        for (std::size_t k = 0; k < n; ++k) { points[k] = lower + static_cast<Scalar>(start + k); }
+        if (const EvalStatus status = body.runBatch(columns, n, values.data()); status != EvalStatus::OK) { return status; }
+        for (std::size_t k = 0; k < n; ++k) { accumulated.add(values[k]); }
+    }
+    total = accumulated.value();
+    return EvalStatus::OK;
+}
+
+// The precisions programs run in
+template EvalStatus Routine::run(OpCode, RoutineScratch<long double>&, long double, long double, long double&) const;
+template EvalStatus Routine::run(OpCode, RoutineScratch<double>&, double, double, double&) const;
+template EvalStatus Routine::run(OpCode, RoutineScratch<float>&, float, float, float&) const;
@@ -0,0 +1,20 @@
+/**
+ * @file Optimizer.cpp
+ * @brief Implementation of the AST optimization entry point
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * The rewrite rules live with each node in its simplify() function; this file only
+ * drives them from the root so that the caller gets back the new root of the tree.
+ */
+
+#include "Optimizer.h"
+
+#include <memory>
+#include <string>
+
+// Simplifies the whole tree, replacing the root if it folds away
+std::unique_ptr<Node> optimize(std::unique_ptr<Node> expression, const SymbolTable& constants) {
+    simplifyChild(expression, constants);
+    return expression;
+}
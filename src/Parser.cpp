@@ -6,36 +6,39 @@
 */
 
 /*
-This file uses recursive descent parsing to implement a hierarchical parsing structure.
-It uses a top-down approach to parse dynamic arrays of tokens into an AST that will return the 
-final result of the expression. It uses a series of parsing functions, each calling one that 
-takes more priority over itself, enabling clean order of operations. 
+This file uses precedence climbing for the binary operators and recursive descent for everything
+below them to parse dynamic arrays of tokens into an AST that will return the final result of the
+expression. Every token is visited once, so parse time grows linearly with the length of the input,
+and the operator table in precedence() is the only place the order of operations is written down.
 
 Flow:
-1. Start assignment operators (if no assignment, then continue to step 2)
-    - if there is an assignment operator, parse the right-hand side expression (variable assignment happens in main loop)
-2. Parse addition/subtraction
-    - continue parsing the left side of the operator by parsing multiplication
-    - since later functions don't parse addition/subtraction, they will stop parsing at the + or - token and return a tree, which is when the right side starts
-    - then parse the right side
-    - if right side contains another addition/subtraction, the now parsed expression before the + or - token will be used as the left side
-3. Parse multiplication/division
-    - continue parsing the left side of the operator by parsing power
-    - like addition, parsing will stop at a * or / token and return a tree, which is when right side starts
-    - then parse the right side, and like addition/subtraction, the right and left side combined will serve as the left side if another * or / token is found
-4. Parse power
-    - this case is special. since power is right associative unlike addition/multiplication, we need to parse the right side first
-    - however, we will still continue to parse the left side, which might contain parenthesis, unary operators, or functions
-    - then we parse the right side as another power expression, for cases like 2^(3+1)^4. This ensures that (3+1)^4 is parsed first, then 2^[(3+1)^4].
-    - once no more ^ tokens are found, then continue parsing
-5. Parse unary
+0. Read tokens on demand
+    - the parser only ever holds the current token, pulled from a Lexer (or from a vector of tokens) by next()
+    - nothing is looked ahead or backtracked, so input can be parsed while it is still being read
+1. Detect assignment from the first two tokens
+    - an assignment is a variable followed by = at the very start of the line; the parser records the variable and starts after the =
+    (variable assignment happens in main loop)
+    - if the second token is not an =, the variable already read becomes the first operand of the expression
+    - an = anywhere else is a syntax error, reported by next() as soon as it is read
+2. Parse binary operators by precedence climbing
+    - each operator has a precedence: + and - are 1, * and / are 2, ^ is 3
+    - parseBinary(min) parses a unary operand, then keeps absorbing operators whose precedence is at least min
+    - for each operator it consumes, the right side is parsed by another parseBinary call that only accepts tighter operators,
+    so 1 + 2 * 3 gives the * to the right side while 1 * 2 + 3 stops the right side at the +
+    - +, -, * and / are left associative: the right side must bind strictly tighter, so 8 - 4 - 2 is (8 - 4) - 2
+    - ^ is right associative: the right side may contain another ^, so 2^3^2 is 2^(3^2)
+    - a sum of n terms is a loop, not n nested calls, so long generated expressions parse in linear time
+3. After the whole expression, the next token must be the end of the input, otherwise the line has unexpected trailing tokens
+    - the one exception is a sweep clause, "for x in a..b" with an optional "step s", which is parsed by parseSweep()
+    - for, in and step are plain variable tokens that are only treated as keywords in that position
+4. Parse unary
     - not except for factorial, just trying to find a - token before a number, variable, or parenthesis
     - if found, create a negate node with the parsed unary expression as its child
     - if not found, then continue parsing primary
     - after parsePrimary is called, check for factorials, which are postfix unary operators
         - if found, create a factorial node with the parsed primary expression as its child
         - continue checking for more factorials until none are found using while
-6. Parse primary
+5. Parse primary
 	- this is the case that takes the most hierarchy. It includes numbers, variables, functions, and grouping operators: (x) and |x|
     - it uses checkType() to determine what the current token is and parse accordingly
     - simplest case: number or variable
@@ -43,15 +46,18 @@ Flow:
         - if | not found then throw runtime error
     - if function token is found then expect a left parenthesis
         - if function is a log, parse expression then expect a comma, if not then throw runtime error
+        - if function is diff, parse expression, expect a comma and a variable, and return the derivative of the expression with respect to it
+        - solve, integrate and sum also take an expression and a variable, followed by a guess, or by the two bounds
         - if function is not a log, parse expression 
         - create a function node with the corresponding function name and the parsed expression as its child.
         - expect a right parenthesis to close the function call, if not then throw runtime error
     - if left parenthesis is found, parse the expression inside and expect a right parenthesis to close it, if not then throw runtime error
     - if none of the above cases are met, then throw runtime error
-7. Parse preserve variable and remove variable
+6. Parse preserve variable and remove variable
     - this is an oddball case. It is technically not part of the expression parsing, but it is easier to handle here because the lexer already tokenizes it
     and I don't want to handle tokens in main.
-    - it the first token is a PRESERVE or REMOVE token, then expect the second token to be a variable and nothing else
+    - if the first token is a PRESERVE or REMOVE token, then expect the second token to be a variable and nothing else
+    - a PRESERVE or REMOVE token anywhere else is reported by next() as soon as it is read
     - if the syntax is correct then return true indicating that the user input is a preserve/remove command
     - if syntax is incorrect then throw runtime error
 
@@ -84,6 +90,7 @@ the final result would be returned directly to the main function.
 #include "NumberNode.h"
 #include "BinaryOpNode.h"
 #include "FuncNode.h"
+#include "NumericNode.h"
 #include "UnaryOpNode.h"
 #include "VariableNode.h"
 #include "Lexicography.h"
@@ -93,28 +100,116 @@ the final result would be returned directly to the main function.
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace {
+
+// Builds the tree out of Node objects, one class per operation
+struct NodeBuilder {
+    using Handle = std::unique_ptr<Node>;
+
+    Handle number(const long double value) { return std::make_unique<NumberNode>(value); }
+
+    Handle variable(const std::string_view name) { return std::make_unique<VariableNode>(std::string(name)); }
+
+    Handle unary(const OpCode op, Handle operand) {
+        switch (op) {
+            case OpCode::NEGATE: return std::make_unique<NegateNode>(std::move(operand));
+            case OpCode::ABS: return std::make_unique<AbsNode>(std::move(operand));
+            case OpCode::FACTORIAL: return std::make_unique<FactorialNode>(std::move(operand));
+            case OpCode::SIN: return std::make_unique<SinNode>(std::move(operand));
+            case OpCode::COS: return std::make_unique<CosNode>(std::move(operand));
+            case OpCode::TAN: return std::make_unique<TanNode>(std::move(operand));
+            case OpCode::ASIN: return std::make_unique<ArcSinNode>(std::move(operand));
+            case OpCode::ACOS: return std::make_unique<ArcCosNode>(std::move(operand));
+            case OpCode::ATAN: return std::make_unique<ArcTanNode>(std::move(operand));
+            case OpCode::EXP: return std::make_unique<ExpNode>(std::move(operand));
+            case OpCode::LN: return std::make_unique<LnNode>(std::move(operand));
+            case OpCode::LOGTEN: return std::make_unique<LogTenNode>(std::move(operand));
+            default: return std::make_unique<SqrtNode>(std::move(operand));
+        }
+    }
 
+    Handle binary(const OpCode op, Handle left, Handle right) {
+        switch (op) {
+            case OpCode::ADD: return std::make_unique<AddNode>(std::move(left), std::move(right));
+            case OpCode::SUBTRACT: return std::make_unique<SubtractNode>(std::move(left), std::move(right));
+            case OpCode::MULTIPLY: return std::make_unique<MultiplyNode>(std::move(left), std::move(right));
+            case OpCode::DIVIDE: return std::make_unique<DivideNode>(std::move(left), std::move(right));
+            case OpCode::LOG: return std::make_unique<LogNode>(std::move(left), std::move(right));
+            default: return std::make_unique<PowerNode>(std::move(left), std::move(right));
+        }
+    }
 
-// Constructor, initializes tokens and current index to 0
-Parser::Parser(std::vector<Token> tokens) : tokens(std::move(tokens)), currIndex(0) {}
+    Handle derivative(const Handle expression, const std::string_view variable) {
+        return expression->derivative(SymbolTable::intern(variable));
+    }
 
-// Helper functions to navigate tokens
+    Handle routine(const OpCode op, Handle body, const std::string_view name, Handle from, Handle to) {
+        const SymbolId variable = SymbolTable::intern(name);
+        switch (op) {
+            case OpCode::SOLVE: return std::make_unique<SolveNode>(std::move(body), variable, std::move(from));
+            case OpCode::INTEGRATE: return std::make_unique<IntegrateNode>(std::move(body), variable, std::move(from), std::move(to));
+            default: return std::make_unique<SumNode>(std::move(body), variable, std::move(from), std::move(to));
+        }
+    }
+};
+
+// Maps the name of a single-argument function to its operation
+bool functionOpCode(const std::string& name, OpCode& op) {
+    if (name == "sin") { op = OpCode::SIN; }
+    else if (name == "cos") { op = OpCode::COS; }
+    else if (name == "tan") { op = OpCode::TAN; }
+    else if (name == "asin") { op = OpCode::ASIN; }
+    else if (name == "acos") { op = OpCode::ACOS; }
+    else if (name == "atan") { op = OpCode::ATAN; }
+    else if (name == "exp") { op = OpCode::EXP; }
+    else if (name == "ln") { op = OpCode::LN; }
+    else if (name == "log10") { op = OpCode::LOGTEN; }
+    else if (name == "sqrt") { op = OpCode::SQRT; }
+    else if (name == "abs") { op = OpCode::ABS; }
+    else if (name == "fact") { op = OpCode::FACTORIAL; }
+    else { return false; }
+    return true;
+}
 
-// Increments to previous token if possible and return it, otherwise return current token
-Token& Parser::prev() {
-    if (currIndex > 0) { return tokens[--currIndex]; }
-    return tokens[currIndex];
+} // namespace
+
+
+// Constructor, initializes tokens, current index to 0 and the arena nodes are allocated from
+Parser::Parser(std::vector<Token> tokens, NodeArena* arena)
+    : tokens(std::move(tokens)), currIndex(0), current(TokenType::END, " "), arena(arena) {
+    if (!this->tokens.empty()) { current = this->tokens.front(); }
 }
 
+// Constructor for streaming input, reads only the first token
+Parser::Parser(Lexer& lexer, NodeArena* arena)
+    : currIndex(0), lexer(&lexer), current(lexer.next()), arena(arena) {}
+
+// Helper functions to navigate tokens
+
 // Returns current token
 Token& Parser::curr() {
-    return tokens[currIndex];
+    return current;
 }
 
-// Increments to next token if possible and return it, otherwise return current token
+// Moves to the next token if there is one and returns it, rejecting tokens that can only start a line
 Token& Parser::next() {
-    if (currIndex < tokens.size()-1) { return tokens[++currIndex]; }
-    return tokens[currIndex];
+    if (lexer) { current = lexer->next(); }
+    else if (currIndex + 1 < tokens.size()) { current = tokens[++currIndex]; }
+
+    if (current.type == TokenType::ASSIGN && !assignmentAllowed) {
+        throw std::runtime_error("use [variable] = [expression] for assignment"); // invalid assignment syntax
+    }
+    if (current.type == TokenType::PRESERVE) {
+        throw std::runtime_error("invalid preserve variable syntax! Use preserve [variable] to add a variable to preserved variables");
+    }
+    if (current.type == TokenType::REMOVE) {
+        throw std::runtime_error("invalid remove variable syntax! Use remove [variable] to remove a variable from preserved variables");
+    }
+    return current;
 }
 
 // Checks if current token matches given type
@@ -124,127 +219,182 @@ bool Parser::checkType(const TokenType type) {
 
 // Public parse function, serves as entry point for main
 std::unique_ptr<Node> Parser::parse(){
-    return parseExpression();
+    NodeBuilder tree;
+    if (arena) {
+        // Every node made while the scope is alive lands in the arena
+        NodeArena::Scope scope(*arena);
+        return parseStatement(tree);
+    }
+    return parseStatement(tree);
+}
+
+// Same grammar, appending to a flat tree instead of allocating nodes
+void Parser::parse(FlatTree& tree) {
+    tree.clear();
+    tree.setRoot(parseStatement(tree));
 }
 
 // Begin private parsing functions
 
-// Entry point for parsing expressions
-std::unique_ptr<Node> Parser::parseExpression(){
-    return parseAssignment();
-}
+// Detects an assignment from the first two tokens, then parses the expression and checks nothing is left over
+template <typename Tree>
+typename Tree::Handle Parser::parseStatement(Tree& tree) {
+    if (checkType(TokenType::ASSIGN)) { throw std::runtime_error("use [variable] = [expression] for assignment"); }
 
-// Parses assignment expressions of the form variable = expression
-std::unique_ptr<Node> Parser::parseAssignment() {
-    if (Parser::isAssignment()) { 
-        if (currIndex + 1 < tokens.size() &&                   // Ensure that input follows correct assignment syntax
-            tokens[currIndex].type == TokenType::VARIABLE &&
-            tokens[currIndex + 1].type == TokenType::ASSIGN) { 
-            assignmentVar = tokens[currIndex].value;
-            currIndex += 2;
-            return parseAddition(); // Parse the expression on the right side of the assignment, which can include all other types of expressions
+    typename Tree::Handle root;
+    if (checkType(TokenType::VARIABLE)) {
+        // The variable's text may not outlive the next token, so keep a copy
+        std::string name(curr().value);
+        assignmentAllowed = true;
+        next();
+        assignmentAllowed = false;
+        if (checkType(TokenType::ASSIGN)) {
+            containsNewVar = true;
+            assignmentVar = std::move(name);
+            next();
+            root = parseExpression(tree); // Parse the expression on the right side of the assignment
+        }
+        else {
+            // Not an assignment after all: the variable is the first operand of the expression
+            root = parseBinary(tree, 1, parsePostfix(tree, tree.variable(name)));
         }
-        else { throw std::runtime_error("use [variable] = [expression] for assignment"); } // invalid assignment syntax
     }
-    return parseAddition(); // if there is no assignment, then continue parsing.
-}
+    else { root = parseExpression(tree); }
 
-std::unique_ptr<Node> Parser::parseAddition() { 
-    std::unique_ptr<Node> left = parseMultiplication(); // continue parsing left side
-    while (checkType(TokenType::PLUS) || checkType(TokenType::MINUS)) { // if there is a minus or a plus
-		const TokenType op = curr().type; // plus/minus operator
-        next(); // std::move to next token
-        std::unique_ptr<Node> right = parseMultiplication(); // parse right side
+    if (checkType(TokenType::VARIABLE) && curr().value == "for") {
+        if (containsNewVar) { throw std::runtime_error("a sweep cannot be assigned to a variable"); }
+        parseSweep();
+    }
 
-        // left = (op == TokenType::PLUS) ? 
-        //     std::make_unique<AddNode>(std::move(left), std::move(right)) : 
-        //     std::make_unique<SubtractNode>(std::move(left), std::move(right));
-        if (op == TokenType::PLUS) { left = std::make_unique<AddNode>(std::move(left), std::move(right)); } // make addition node from the left and right sides of the operator
-        else { left = std::make_unique<SubtractNode>(std::move(left), std::move(right)); } // make subtraction node from the left and right sides of the operator
+    if (!checkType(TokenType::END)) { throw std::runtime_error("unexpected element in expression"); }
+    return root;
+}
 
+// Reads "for VARIABLE in FROM..TO", then an optional "step STEP", building the bounds as nodes
+void Parser::parseSweep() {
+    const char* const usage = "invalid sweep syntax! Use [expression] for [variable] in [from]..[to] step [step]";
+    if (next().type != TokenType::VARIABLE) { throw std::runtime_error(usage); }
+    sweep.variable = curr().value;
+    if (next().type != TokenType::VARIABLE || curr().value != "in") { throw std::runtime_error(usage); }
+    next();
+
+    NodeBuilder bounds;
+    sweep.from = parseExpression(bounds);
+    if (!checkType(TokenType::RANGE)) { throw std::runtime_error(usage); }
+    next();
+    sweep.to = parseExpression(bounds);
+    if (checkType(TokenType::VARIABLE) && curr().value == "step") {
+        next();
+        sweep.step = parseExpression(bounds);
     }
-    return left; // return the left side which now contains the rest of the expression tree
+    containsSweep = true;
 }
 
-std::unique_ptr<Node> Parser::parseMultiplication() {
-    std::unique_ptr<Node> left = parsePower(); // continue parsing left side
-	while (checkType(TokenType::MULTIPLY) || checkType(TokenType::DIVIDE)) { // if there is a multiply or divide
-		const TokenType op = curr().type; // multiply/divide operator
-		next(); // std::move to next token
-        std::unique_ptr<Node> right = parsePower(); // continue parse right side
-
-        // left = (op == TokenType::MULTIPLY) ? 
-        //     std::make_unique<MultiplyNode>(std::move(left), std::move(right)) : 
-        //     std::make_unique<DivideNode>(std::move(left), std::move(right));
+// The clause on its own, with nothing before its "for" and nothing after it
+Sweep& Parser::parseSweepClause() {
+    if (!checkType(TokenType::VARIABLE) || curr().value != "for") {
+        throw std::runtime_error("expected a sweep clause, for [variable] in [from]..[to]");
+    }
+    parseSweep();
+    if (!checkType(TokenType::END)) { throw std::runtime_error("unexpected element after sweep clause"); }
+    return sweep;
+}
 
-		if (op == TokenType::MULTIPLY) { left = std::make_unique<MultiplyNode>(std::move(left), std::move(right)); } // make multiplication node from the left and right sides of the operator
-		else { left = std::make_unique<DivideNode>(std::move(left), std::move(right)); } // make division node from the left and right sides of the operator
+// Entry point for parsing expressions
+template <typename Tree>
+typename Tree::Handle Parser::parseExpression(Tree& tree) {
+    return parseBinary(tree, 1);
+}
 
+// Precedence of a binary operator token, or 0 if the token does not continue an expression
+int Parser::precedence(const TokenType type) {
+    switch (type) {
+        case TokenType::PLUS:
+        case TokenType::MINUS: return 1;
+        case TokenType::MULTIPLY:
+        case TokenType::DIVIDE: return 2;
+        case TokenType::POWER: return 3;
+        default: return 0;
     }
-    return left;
 }
 
-std::unique_ptr<Node> Parser::parsePower() { // right associative
-	std::unique_ptr<Node> left = parseUnary(); // continue parsing left side 
-    if (checkType(TokenType::POWER)) { 
-        next();
-        std::unique_ptr<Node> right = parseUnary(); // parse right side (right-associative)
+// Parses a unary operand, then every following operator that binds at least as tightly as minPrecedence
+template <typename Tree>
+typename Tree::Handle Parser::parseBinary(Tree& tree, const int minPrecedence) {
+    return parseBinary(tree, minPrecedence, parseUnary(tree));
+}
 
-        return std::make_unique<PowerNode>(std::move(left), std::move(right)); // make power node from left and right sides
+// Extends an operand already parsed with every following operator that binds at least as tightly as minPrecedence
+template <typename Tree>
+typename Tree::Handle Parser::parseBinary(Tree& tree, const int minPrecedence, typename Tree::Handle left) {
+    for (int level = precedence(curr().type); level >= minPrecedence; level = precedence(curr().type)) {
+        const TokenType op = curr().type;
+        next();
+        // Only ^ lets an operator of the same precedence into its right side, which makes it right associative
+        typename Tree::Handle right = parseBinary(tree, op == TokenType::POWER ? level : level + 1);
+        switch (op) {
+            case TokenType::PLUS: left = tree.binary(OpCode::ADD, std::move(left), std::move(right)); break;
+            case TokenType::MINUS: left = tree.binary(OpCode::SUBTRACT, std::move(left), std::move(right)); break;
+            case TokenType::MULTIPLY: left = tree.binary(OpCode::MULTIPLY, std::move(left), std::move(right)); break;
+            case TokenType::DIVIDE: left = tree.binary(OpCode::DIVIDE, std::move(left), std::move(right)); break;
+            default: left = tree.binary(OpCode::POWER, std::move(left), std::move(right)); break;
+        }
     }
     return left;
 }
 
-std::unique_ptr<Node> Parser::parseUnary() {
-    std::unique_ptr<Node> node;
-    if (checkType(TokenType::MINUS)) { 
+template <typename Tree>
+typename Tree::Handle Parser::parseUnary(Tree& tree) {
+    if (checkType(TokenType::MINUS)) {
         next();
-		node = std::make_unique<NegateNode>(parseUnary()); // make negate node with the expression after as its child; call parseUnary again to handle cases like --sin(x)
+        return tree.unary(OpCode::NEGATE, parseUnary(tree)); // make negate node with the expression after as its child; call parseUnary again to handle cases like --sin(x)
     }
-    else { node = parsePrimary(); } // continue parsing the rest of the expression
+    return parsePostfix(tree, parsePrimary(tree)); // continue parsing the rest of the expression
+}
 
-    // after parsePrimary is called check for factorials, which are postfix unary operators
+// after parsePrimary is called check for factorials, which are postfix unary operators
+template <typename Tree>
+typename Tree::Handle Parser::parsePostfix(Tree& tree, typename Tree::Handle operand) {
     while (checkType(TokenType::FACTORIAL)) {
         next();
-        node = std::make_unique<FactorialNode>(std::move(node));
+        operand = tree.unary(OpCode::FACTORIAL, std::move(operand));
     }
-
-    return node;
-
+    return operand;
 }
 
-std::unique_ptr<Node> Parser::parsePrimary() {
+template <typename Tree>
+typename Tree::Handle Parser::parsePrimary(Tree& tree) {
     // Numbers
     if (checkType(TokenType::NUMBER)) {
-        long double value = stod(curr().value);
+        const long double value = curr().number;
         next();
-        return std::make_unique<NumberNode>(value);
+        return tree.number(value);
     }
 
     // Vars
 
     if (checkType(TokenType::VARIABLE)) {
-        std::string name = curr().value;
+        std::string name(curr().value);
         next();
-        return std::make_unique<VariableNode>(name);
+        return tree.variable(name);
     }
 
     // Absolute value
 
     if (checkType(TokenType::ABS)) {
         next();
-        std::unique_ptr<Node> expr = parseExpression();
+        typename Tree::Handle expr = parseExpression(tree);
         if (!checkType(TokenType::ABS)) {
             throw std::runtime_error("expected closing | for absolute value expression");
         }
         next();
-        return std::make_unique<AbsNode>(std::move(expr));
+        return tree.unary(OpCode::ABS, std::move(expr));
     }
 
     // Functions 
 
     if (checkType(TokenType::FUNCTION)) {
-        const std::string funcName = curr().value;
+        const std::string funcName(curr().value);
         next();
 
         if (!checkType(TokenType::LEFTPAREN)) {
@@ -252,41 +402,66 @@ std::unique_ptr<Node> Parser::parsePrimary() {
             }
         next();
         if (funcName == "log" || funcName == "pow") {
-            std::unique_ptr<Node> arg1 = parseExpression();
+            typename Tree::Handle arg1 = parseExpression(tree);
             if (!checkType(TokenType::COMMA)) {
                 throw std::runtime_error("expected ',' between log arguments");
             }
             next();
-            std::unique_ptr<Node> arg2 = parseExpression();
+            typename Tree::Handle arg2 = parseExpression(tree);
 
             if (!checkType(TokenType::RIGHTPAREN)) {
                 throw std::runtime_error("expected ')' after function arguments");
             }
             next();
             
-            if (funcName == "log") { return std::make_unique<LogNode>(std::move(arg1), std::move(arg2)); }
-            if (funcName == "pow") { return std::make_unique<PowerNode>(std::move(arg1), std::move(arg2)); }
+            return tree.binary(funcName == "log" ? OpCode::LOG : OpCode::POWER, std::move(arg1), std::move(arg2));
         }
 
-        std::unique_ptr<Node> argument = parseExpression();
+        // The expression is differentiated as soon as it is parsed and only its derivative kept
+        if (funcName == "diff") {
+            typename Tree::Handle expr = parseExpression(tree);
+            const std::string variable = parseBoundVariable(funcName);
+            if (!checkType(TokenType::RIGHTPAREN)) {
+                throw std::runtime_error("expected ')' after function arguments");
+            }
+            next();
+            return tree.derivative(std::move(expr), variable);
+        }
+
+        // solve(expression, variable, guess), integrate and sum(expression, variable, from, to)
+        if (funcName == "solve" || funcName == "integrate" || funcName == "sum") {
+            typename Tree::Handle body = parseExpression(tree);
+            const std::string variable = parseBoundVariable(funcName);
+            if (!checkType(TokenType::COMMA)) {
+                throw std::runtime_error("expected ',' between " + funcName + " arguments");
+            }
+            next();
+            typename Tree::Handle from = parseExpression(tree);
+            typename Tree::Handle to{};
+            if (funcName != "solve") {
+                if (!checkType(TokenType::COMMA)) {
+                    throw std::runtime_error("expected ',' between " + funcName + " arguments");
+                }
+                next();
+                to = parseExpression(tree);
+            }
+            if (!checkType(TokenType::RIGHTPAREN)) {
+                throw std::runtime_error("expected ')' after function arguments");
+            }
+            next();
+            const OpCode op = funcName == "solve" ? OpCode::SOLVE : funcName == "integrate" ? OpCode::INTEGRATE : OpCode::SUM;
+            return tree.routine(op, std::move(body), variable, std::move(from), std::move(to));
+        }
+
+        typename Tree::Handle argument = parseExpression(tree);
 
         if (!checkType(TokenType::RIGHTPAREN)) {
             throw std::runtime_error("expected ')' after function argument");
         }
         next();
 
-        if (funcName == "sin") { return std::make_unique<SinNode>(std::move(argument)); }
-        if (funcName == "cos") { return std::make_unique<CosNode>(std::move(argument)); }
-        if (funcName == "tan") { return std::make_unique<TanNode>(std::move(argument)); }
-        if (funcName == "asin") { return std::make_unique<ArcSinNode>(std::move(argument)); }
-        if (funcName == "acos") { return std::make_unique<ArcCosNode>(std::move(argument)); }
-        if (funcName == "atan") { return std::make_unique<ArcTanNode>(std::move(argument)); }
-        if (funcName == "exp") { return std::make_unique<ExpNode>(std::move(argument)); }
-        if (funcName == "ln") { return std::make_unique<LnNode>(std::move(argument)); }
-        if (funcName == "log10") { return std::make_unique<LogTenNode>(std::move(argument)); }
-        if (funcName == "sqrt") { return std::make_unique<SqrtNode>(std::move(argument)); }
-        if (funcName == "abs") { return std::make_unique<AbsNode>(std::move(argument)); }
-        if (funcName == "fact") { return std::make_unique<FactorialNode>(std::move(argument)); }
+        OpCode function;
+        if (functionOpCode(funcName, function)) { return tree.unary(function, std::move(argument)); }
 
         throw std::runtime_error(funcName + " is not recognized as a variable, function, or operation");
 
@@ -294,7 +469,7 @@ std::unique_ptr<Node> Parser::parsePrimary() {
 
     if (checkType(TokenType::LEFTPAREN)) {
         next();
-        std::unique_ptr<Node> expr = parseExpression();
+        typename Tree::Handle expr = parseExpression(tree);
         if (!checkType(TokenType::RIGHTPAREN)) {
             throw std::runtime_error("expected ')' after expression");
         }
@@ -306,24 +481,33 @@ std::unique_ptr<Node> Parser::parsePrimary() {
 
 }
 
-bool Parser::parsePreserve() {
-    if (tokens.size() == 3 && tokens[0].type == TokenType::PRESERVE && tokens[1].type == TokenType::VARIABLE) {
-		assignmentVar = tokens[1].value;
-        return true;
+// Expects ", VARIABLE" and leaves the token after the variable current
+std::string Parser::parseBoundVariable(const std::string& function) {
+    if (!checkType(TokenType::COMMA)) {
+        throw std::runtime_error("expected ',' between " + function + " arguments");
     }
-    if (std::any_of(tokens.begin(), tokens.end(), [](const Token& t) { return t.type == TokenType::PRESERVE; })) {
-        throw std::runtime_error("invalid preserve variable syntax! Use preserve [variable] to add a variable to preserved variables");
+    if (next().type != TokenType::VARIABLE) {
+        throw std::runtime_error("expected a variable as the second argument of " + function);
     }
-    return false;
+    std::string variable(curr().value);
+    next();
+    return variable;
 }
 
-bool Parser::parseRemove() {
-    if (tokens.size() == 3 && tokens[0].type == TokenType::REMOVE && tokens[1].type == TokenType::VARIABLE) {
-		assignmentVar = tokens[1].value;
-        return true;
+bool Parser::parsePreserve() {
+    if (!checkType(TokenType::PRESERVE)) { return false; }
+    if (next().type == TokenType::VARIABLE) {
+        assignmentVar = curr().value;
+        if (next().type == TokenType::END) { return true; }
     }
-    if (std::any_of(tokens.begin(), tokens.end(), [](const Token& t) { return t.type == TokenType::REMOVE; })) {
-        throw std::runtime_error("invalid remove variable syntax! Use remove [variable] to remove a variable from preserved variables");
+    throw std::runtime_error("invalid preserve variable syntax! Use preserve [variable] to add a variable to preserved variables");
+}
+
+bool Parser::parseRemove() {
+    if (!checkType(TokenType::REMOVE)) { return false; }
+    if (next().type == TokenType::VARIABLE) {
+        assignmentVar = curr().value;
+        if (next().type == TokenType::END) { return true; }
     }
-    return false;
-}
\ No newline at end of file
+    throw std::runtime_error("invalid remove variable syntax! Use remove [variable] to remove a variable from preserved variables");
+}
@@ -0,0 +1,236 @@
+/**
+ * @file Polynomial.cpp
+ * @brief Polynomial forms of the node classes and the Horner rewrite
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * Each node that can appear in a polynomial reads itself into coefficient form from its
+ * operands' forms, so the rules need the node classes and the Polynomial arithmetic at
+ * once and live here. The optimizer splits every sum and difference into the terms of its
+ * chain after simplifying its operands and gathers those that are powers of one variable,
+ * so the start of a chain is already in Horner form when the sum around it is read; a
+ * product of a polynomial and a power of the variable is a single term product, so that
+ * form reads back exactly and the group grows by one term per level. Terms are only
+ * gathered while that keeps IEEE results: x * 0 and x^3 - x^3 are NaN for an infinite x,
+ * so such terms, and terms of one power with opposite signs, stay as written. The powers in the rebuilt tree are compiled to multiplications,
+ * see Compiler::emit.
+ */
+
+#include "Polynomial.h"
+#include "BinaryOpNode.h"
+#include "NumberNode.h"
+#include "Optimizer.h"
+#include "UnaryOpNode.h"
+#include "VariableNode.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace {
+
+using NodePtr = std::unique_ptr<Node>;
+
+NodePtr number(const long double value) { return std::make_unique<NumberNode>(value); }
+
+} // namespace
+
+std::size_t Polynomial::nonzero() const {
+    return static_cast<std::size_t>(std::count_if(coefficients.begin(), coefficients.end(), [](long double c) { return c != 0; }));
+}
+
+std::size_t Polynomial::terms() const { return nonzero() - (coefficients[0] != 0 ? 1 : 0); }
+
+// A constant combines with a polynomial in any variable
+bool Polynomial::unify(const Polynomial& other) {
+    if (other.name.empty()) { return true; }
+    if (name.empty()) {
+        name = other.name;
+        variable = other.variable;
+        return true;
+    }
+    return variable == other.variable;
+}
+
+bool Polynomial::add(const Polynomial& other, const long double sign) {
+    if (!unify(other)) { return false; }
+    coefficients.resize(std::max(coefficients.size(), other.coefficients.size()), 0);
+    for (std::size_t k = 0; k < other.coefficients.size(); ++k) {
+        const long double term = sign * other.coefficients[k];
+        if ((coefficients[k] < 0 && term > 0) || (coefficients[k] > 0 && term < 0)) { folded = true; }
+        coefficients[k] += term;
+    }
+    folded = folded || other.folded;
+    return true;
+}
+
+// Finite constants combine under any x, so only the powers of the variable and infinite constants count
+bool Polynomial::opposes(const Polynomial& other) const {
+    if (!std::isfinite(coefficients[0]) || !std::isfinite(other.coefficients[0])) {
+        if ((coefficients[0] < 0 && other.coefficients[0] > 0) || (coefficients[0] > 0 && other.coefficients[0] < 0)) { return true; }
+    }
+    for (std::size_t k = 1; k < std::min(coefficients.size(), other.coefficients.size()); ++k) {
+        if ((coefficients[k] < 0 && other.coefficients[k] > 0) || (coefficients[k] > 0 && other.coefficients[k] < 0)) { return true; }
+    }
+    return false;
+}
+
+// With a single term on one side, every coefficient of the product is one product of coefficients
+bool Polynomial::multiply(const Polynomial& other) {
+    if (!unify(other) || (nonzero() > 1 && other.nonzero() > 1)) { return false; }
+    const std::size_t degree = coefficients.size() + other.coefficients.size() - 2;
+    if (degree > MAX_DEGREE) { return false; }
+    // A zero factor drops the other side's powers of the variable, and so does a product that underflows
+    if ((nonzero() == 0 && other.terms() > 0) || (other.nonzero() == 0 && terms() > 0)) { folded = true; }
+    std::vector<long double> product(degree + 1, 0);
+    for (std::size_t i = 0; i < coefficients.size(); ++i) {
+        if (coefficients[i] == 0) { continue; }
+        for (std::size_t j = 0; j < other.coefficients.size(); ++j) {
+            const long double term = coefficients[i] * other.coefficients[j];
+            if (other.coefficients[j] != 0 && term == 0) { folded = true; }
+            product[i + j] += term;
+        }
+    }
+    coefficients = std::move(product);
+    folded = folded || other.folded;
+    return true;
+}
+
+// (c x^k)^n = c^n x^(kn), and anything to the power 0 is 1, as std::pow has it
+bool Polynomial::raise(const long double exponent) {
+    if (exponent < 0 || exponent > MAX_DEGREE || exponent != std::floor(exponent) || nonzero() > 1) { return false; }
+    const auto n = static_cast<std::size_t>(exponent);
+    const auto term = std::find_if(coefficients.begin(), coefficients.end(), [](long double c) { return c != 0; });
+    const std::size_t power = term == coefficients.end() ? 0 : static_cast<std::size_t>(term - coefficients.begin());
+    if (power * n > MAX_DEGREE) { return false; }
+    const long double coefficient = term == coefficients.end() ? 0 : *term;
+    coefficients.assign(power * n + 1, 0);
+    coefficients[power * n] = std::pow(coefficient, exponent);
+    if (coefficient != 0 && coefficients[power * n] == 0) { folded = true; }
+    return true;
+}
+
+void Polynomial::negate() {
+    for (long double& c : coefficients) { c = -c; }
+}
+
+// Walks the nonzero coefficients from the highest power down, multiplying by the power of x that spans each gap
+std::unique_ptr<Node> Polynomial::horner() const {
+    std::size_t top = coefficients.size() - 1;
+    while (top > 0 && coefficients[top] == 0) { --top; }
+    if (top == 0) { return number(coefficients[0]); }
+
+    // p x^gap, without multiplying by 1 or -1
+    const auto times = [this](NodePtr p, const std::size_t gap) -> NodePtr {
+        NodePtr power = std::make_unique<VariableNode>(name, variable);
+        if (gap > 1) { power = std::make_unique<PowerNode>(std::move(power), number(static_cast<long double>(gap))); }
+        if (isNumber(*p, 1)) { return power; }
+        if (isNumber(*p, -1)) { return std::make_unique<NegateNode>(std::move(power)); }
+        return std::make_unique<MultiplyNode>(std::move(p), std::move(power));
+    };
+
+    NodePtr p = number(coefficients[top]);
+    std::size_t previous = top;
+    for (std::size_t k = top; k-- > 0;) {
+        const long double c = coefficients[k];
+        if (c == 0) { continue; }
+        p = times(std::move(p), previous - k);
+        p = c < 0 ? NodePtr(std::make_unique<SubtractNode>(std::move(p), number(-c)))
+                  : NodePtr(std::make_unique<AddNode>(std::move(p), number(c)));
+        previous = k;
+    }
+    if (previous == 0) { return p; }
+    // Adding zero turns a -0 from multiplying a negative p by x = 0 into the +0 that the sum of the terms gives
+    return std::make_unique<AddNode>(times(std::move(p), previous), number(0));
+}
+
+std::unique_ptr<Node> hornerForm(const Node& node) {
+    std::vector<SumTerm> terms;
+    node.sumTerms(terms);
+
+    // The terms that read as polynomials without folding anything, in the variable of the first one that has it
+    std::vector<Polynomial> forms(terms.size());
+    std::vector<std::size_t> candidates;
+    Polynomial first;
+    for (std::size_t k = 0; k < terms.size(); ++k) {
+        if (!terms[k].node->polynomial(forms[k]) || forms[k].foldsTerms() || !first.unify(forms[k])) { continue; }
+        if (terms[k].subtracted) { forms[k].negate(); }
+        candidates.push_back(k);
+    }
+
+    // A term with the opposite sign of another in some power stays as written, since x^3 - x^3 is not 0 for an infinite x
+    std::vector<std::size_t> group;
+    Polynomial form;
+    for (const std::size_t k : candidates) {
+        const auto opposed = [&](const std::size_t other) { return other != k && forms[k].opposes(forms[other]); };
+        if (std::any_of(candidates.begin(), candidates.end(), opposed)) { continue; }
+        form.add(forms[k]);
+        group.push_back(k);
+    }
+    if (group.size() < 2 || form.terms() < 2) { return nullptr; }
+    if (group.size() == terms.size()) { return form.horner(); }
+
+    // The other terms keep their order and signs, with the Horner form where the first gathered term was
+    NodePtr sum;
+    std::size_t next = 0;
+    for (std::size_t k = 0; k < terms.size(); ++k) {
+        const bool gathered = next < group.size() && group[next] == k;
+        if (gathered && next++ > 0) { continue; }
+        NodePtr term = gathered ? form.horner() : NodePtr(terms[k].node->clone());
+        const bool subtracted = !gathered && terms[k].subtracted;
+        if (!sum) { sum = subtracted ? NodePtr(std::make_unique<NegateNode>(std::move(term))) : std::move(term); }
+        else if (subtracted) { sum = std::make_unique<SubtractNode>(std::move(sum), std::move(term)); }
+        else { sum = std::make_unique<AddNode>(std::move(sum), std::move(term)); }
+    }
+    return sum;
+}
+
+void Node::sumTerms(std::vector<SumTerm>& terms) const { terms.push_back({this, false}); }
+
+void AddNode::sumTerms(std::vector<SumTerm>& terms) const {
+    child1->sumTerms(terms);
+    terms.push_back({child2.get(), false});
+}
+
+void SubtractNode::sumTerms(std::vector<SumTerm>& terms) const {
+    child1->sumTerms(terms);
+    terms.push_back({child2.get(), true});
+}
+
+bool NumberNode::polynomial(Polynomial& out) const {
+    out = Polynomial(value);
+    return true;
+}
+
+bool VariableNode::polynomial(Polynomial& out) const {
+    out = Polynomial(name, id);
+    return true;
+}
+
+// The right operand first, which in a long chain of additions is the short side
+bool AddNode::polynomial(Polynomial& out) const {
+    Polynomial right;
+    return child2->polynomial(right) && child1->polynomial(out) && out.add(right);
+}
+
+bool SubtractNode::polynomial(Polynomial& out) const {
+    Polynomial right;
+    return child2->polynomial(right) && child1->polynomial(out) && out.add(right, -1);
+}
+
+bool MultiplyNode::polynomial(Polynomial& out) const {
+    Polynomial right;
+    return child2->polynomial(right) && child1->polynomial(out) && out.multiply(right);
+}
+
+bool PowerNode::polynomial(Polynomial& out) const {
+    long double power;
+    return exponent->isConstant(power) && base->polynomial(out) && out.raise(power);
+}
+
+bool NegateNode::polynomial(Polynomial& out) const {
+    if (!child->polynomial(out)) { return false; }
+    out.negate();
+    return true;
+}
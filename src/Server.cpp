@@ -0,0 +1,274 @@
+/**
+ * @file Server.cpp
+ * @brief Implementation of the socket server
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * One poll() loop owns the listening socket and every connection, all non-blocking.
+ * Readable connections are drained, their complete lines run through the connection's
+ * session straight away, and the responses written back as far as the socket accepts;
+ * whatever is left is sent when poll() reports the socket writable again. Responses are
+ * produced in the order the lines arrived, so pipelined clients can match them up.
+ */
+
+#include "Server.h"
+
+#include <algorithm>
+#include <csignal>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Bytes requested from a connection per read
+constexpr std::size_t READ_CHUNK = 1 << 16;
+
+// A connection is not read while this much of its output is unsent
+constexpr std::size_t OUTPUT_LIMIT = 1 << 20;
+
+// Longest line accepted before the connection is dropped
+constexpr std::size_t MAX_LINE = 1 << 24;
+
+// Pending connections the kernel queues before accept()
+constexpr int BACKLOG = 128;
+
+// Set by SIGINT and SIGTERM
+volatile std::sig_atomic_t stopRequested = 0;
+
+void requestStop(int) { stopRequested = 1; }
+
+// A client, its session, and the bytes in flight either way. The session interns its names into the
+// connection's own registry, declared first so that it outlives the session
+struct Connection {
+    int fd;
+    std::unique_ptr<SymbolRegistry> symbols;
+    std::unique_ptr<Session> session;
+    std::string input;        ///< Received bytes not yet run, starting with a partial line
+    std::size_t scanned = 0;  ///< Bytes at the start of input already known to hold no newline
+    std::string output;       ///< Responses not yet written
+    std::size_t sent = 0;     ///< Bytes of output already written
+    bool closing = false;     ///< No more input will be run, close once output is written
+
+    explicit Connection(const int fd) : fd(fd), symbols(std::make_unique<SymbolRegistry>()) {}
+};
+
+// Throws with the description of errno
+[[noreturn]] void fail(const std::string& what) {
+    throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+void setNonBlocking(const int fd) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) { fail("cannot make socket non-blocking"); }
+}
+
+// Opens a listening socket on a Unix path or a TCP host and port
+int listenOn(const std::string& address, const bool local) {
+    int fd = -1;
+    if (local) {
+        sockaddr_un name{};
+        if (address.size() >= sizeof(name.sun_path)) { throw std::runtime_error("socket path " + address + " is too long"); }
+        name.sun_family = AF_UNIX;
+        std::memcpy(name.sun_path, address.c_str(), address.size() + 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) { fail("cannot create socket"); }
+        if (bind(fd, reinterpret_cast<const sockaddr*>(&name), sizeof(name)) < 0) {
+            close(fd);
+            fail("cannot listen on " + address);
+        }
+    }
+    else {
+        const std::size_t colon = address.rfind(':');
+        std::string host = colon == std::string::npos ? "127.0.0.1" : address.substr(0, colon);
+        if (host.size() > 2 && host.front() == '[' && host.back() == ']') { host = host.substr(1, host.size() - 2); } // [::1]:port
+        const std::string port = colon == std::string::npos ? address : address.substr(colon + 1);
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        addrinfo* found = nullptr;
+        if (const int error = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &found); error != 0) {
+            throw std::runtime_error("cannot resolve " + address + ": " + gai_strerror(error));
+        }
+        for (const addrinfo* candidate = found; candidate && fd < 0; candidate = candidate->ai_next) {
+            fd = socket(candidate->ai_family, candidate->ai_socktype, candidate->ai_protocol);
+            if (fd < 0) { continue; }
+            const int reuse = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            if (bind(fd, candidate->ai_addr, candidate->ai_addrlen) < 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(found);
+        if (fd < 0) { fail("cannot listen on " + address); }
+    }
+    if (listen(fd, BACKLOG) < 0) {
+        close(fd);
+        fail("cannot listen on " + address);
+    }
+    setNonBlocking(fd);
+    return fd;
+}
+
+// Runs every complete line of the connection's input, and the final partial one once the client is done.
+// The search resumes where the previous call stopped, so a long line is scanned once as it arrives
+void runLines(Connection& connection, const bool endOfInput) {
+    const SymbolRegistry::Scope scope(*connection.symbols);
+    const std::string_view input = connection.input;
+    std::size_t start = 0;
+    while (!connection.closing) {
+        const std::size_t end = input.find('\n', std::max(start, connection.scanned));
+        if (end == std::string_view::npos) { break; }
+        std::string_view line = input.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r') { line.remove_suffix(1); } // tolerate CRLF input
+        connection.closing = !connection.session->execute(line, connection.output);
+        start = end + 1;
+    }
+    if (endOfInput && !connection.closing && start < input.size()) {
+        connection.session->execute(input.substr(start), connection.output);
+        start = input.size();
+    }
+    connection.input.erase(0, start);
+    if (connection.closing || endOfInput) {
+        connection.closing = true;
+        connection.input.clear();
+    }
+    connection.scanned = connection.input.size();
+}
+
+// Writes as much pending output as the socket takes, false if the connection broke
+bool flush(Connection& connection) {
+    while (connection.sent < connection.output.size()) {
+        const ssize_t written = send(connection.fd, connection.output.data() + connection.sent,
+                                     connection.output.size() - connection.sent, 0);
+        if (written < 0) {
+            if (errno == EINTR) { continue; }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        connection.sent += static_cast<std::size_t>(written);
+    }
+    connection.output.clear();
+    connection.sent = 0;
+    return true;
+}
+
+// Reads what has arrived and runs it, false if the connection broke
+bool receive(Connection& connection) {
+    char chunk[READ_CHUNK];
+    while (!connection.closing && connection.output.size() - connection.sent < OUTPUT_LIMIT) {
+        const ssize_t count = recv(connection.fd, chunk, sizeof(chunk), 0);
+        if (count < 0) {
+            if (errno == EINTR) { continue; }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        if (count == 0) {
+            runLines(connection, true);
+            break;
+        }
+        connection.input.append(chunk, static_cast<std::size_t>(count));
+        runLines(connection, false);
+        if (connection.input.size() > MAX_LINE) {
+            connection.output += "Error: line too long\n";
+            connection.closing = true;
+            connection.input.clear();
+            connection.scanned = 0;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// Polls the listener and every connection, reading only from those whose output has drained enough
+void runServer(const std::string& address, const std::function<void(Session&)>& setup, const std::size_t cacheCapacity) {
+    const bool local = address.find('/') != std::string::npos;
+    const int listener = listenOn(address, local);
+
+    // Interrupting poll() without restarting it lets the loop notice the request
+    struct sigaction stop{};
+    stop.sa_handler = requestStop;
+    sigemptyset(&stop.sa_mask);
+    sigaction(SIGINT, &stop, nullptr);
+    sigaction(SIGTERM, &stop, nullptr);
+    std::signal(SIGPIPE, SIG_IGN); // a client that disconnects early is an EPIPE, not a crash
+
+    std::vector<Connection> connections;
+    std::vector<pollfd> polled;
+    while (!stopRequested) {
+        polled.clear();
+        polled.push_back({listener, POLLIN, 0});
+        for (const Connection& connection : connections) {
+            short events = 0;
+            if (!connection.closing && connection.output.size() - connection.sent < OUTPUT_LIMIT) { events |= POLLIN; }
+            if (connection.sent < connection.output.size()) { events |= POLLOUT; }
+            polled.push_back({connection.fd, events, 0});
+        }
+        if (poll(polled.data(), static_cast<nfds_t>(polled.size()), -1) < 0) {
+            if (errno == EINTR) { continue; }
+            fail("poll failed");
+        }
+
+        // Service the existing connections first, then drop the finished ones
+        for (std::size_t i = 0; i < connections.size(); ++i) {
+            Connection& connection = connections[i];
+            const short events = polled[i + 1].revents;
+            bool alive = !(events & POLLNVAL);
+            if (alive && (events & (POLLIN | POLLHUP | POLLERR))) { alive = receive(connection); }
+            if (alive) { alive = flush(connection); }
+            if (!alive || (connection.closing && connection.output.empty())) {
+                close(connection.fd);
+                connection.fd = -1;
+            }
+        }
+        connections.erase(std::remove_if(connections.begin(), connections.end(),
+                                         [](const Connection& connection) { return connection.fd < 0; }),
+                          connections.end());
+
+        if (polled[0].revents & POLLIN) {
+            while (true) {
+                const int fd = accept(listener, nullptr, nullptr);
+                if (fd < 0) { break; } // EAGAIN once the queue is empty, or a client that gave up
+                setNonBlocking(fd);
+                Connection connection(fd);
+                {
+                    const SymbolRegistry::Scope scope(*connection.symbols);
+                    connection.session = std::make_unique<Session>(cacheCapacity);
+                    // Clients may be remote, so their sessions cannot touch the server's files
+                    connection.session->setFileAccess(false);
+                    setup(*connection.session);
+                }
+                connections.push_back(std::move(connection));
+            }
+        }
+    }
+
+    for (const Connection& connection : connections) { close(connection.fd); }
+    close(listener);
+    if (local) { unlink(address.c_str()); }
+}
+
+#else
+
+void runServer(const std::string& address, const std::function<void(Session&)>&, std::size_t) {
+    throw std::runtime_error("cannot listen on " + address + ": server mode needs POSIX sockets");
+}
+
+#endif
@@ -0,0 +1,710 @@
+/**
+ * @file Session.cpp
+ * @brief Implementation of the Session line processor
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This file contains the per-line logic that used to live in the main loop: special
+ * commands, the preserve and remove commands, and the lexer, parser, optimizer and
+ * compiler pipeline behind the expression cache, and fused blocks, whose lines are
+ * compiled into one program. Every response is appended to the caller's buffer, and
+ * errors are caught and reported per line, or per block.
+ */
+
+#include "Session.h"
+#include "Bytecode.h"
+#include "Lexicography.h"
+#include "NumberFormat.h"
+#include "Optimizer.h"
+#include "Parser.h"
+#include "Snapshot.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Help message, courtesy of ChatGPT
+const std::string HELP_MESSAGE =
+    "=== Calculator Help ===\n"
+    "\n"
+    "BASIC OPERATIONS:\n"
+    "  +, -, *, /          Basic arithmetic\n"
+    "  ^                   Exponentiation (2^3 = 8)\n"
+    "  ( )                 Parentheses for grouping\n"
+    "  | |                 Absolute value\n"
+    "\n"
+    "VARIABLES:\n"
+    "  x = 5               Assign value to variable\n"
+    "  y = x * 2 + 3       Use variables in expressions\n"
+    "  vars                Show all variables\n"
+    "\n"
+    "SWEEPS:\n"
+    "  sin(x) for x in 0..1 step 0.25   Evaluate for every x from 0 to 1, step 1 unless given\n"
+    "\n"
+    "FUSED BLOCKS:\n"
+    "  fuse for x in 0..1  Collect the lines up to end, then evaluate them together for every x\n"
+    "  fuse                The same, evaluated once and storing the assignments\n"
+    "  end                 Close the block and evaluate it\n"
+    "\n"
+    "FUNCTIONS:\n"
+    "  sin(x), cos(x), tan(x)     Trigonometric functions\n"
+    "  asin(x), acos(x), atan(x)  Inverse trig functions\n"
+    "  exp(x)              e^x\n"
+    "  ln(x)               Natural logarithm\n"
+    "  log10(x)            Base-10 logarithm\n"
+    "  log(x,y)            Logarithm base y of x\n"
+    "  sqrt(x)             Square root\n"
+    "  abs(x)              Absolute value\n"
+    "  diff(f, x)          Derivative of f with respect to x\n"
+    "  solve(f, x, g)      Root of f in x, searched for from x = g\n"
+    "  integrate(f, x, a, b)  Integral of f over x from a to b\n"
+    "  sum(f, i, a, b)     Sum of f for every integer i from a to b\n"
+    "\n"
+    "EXAMPLES:\n"
+    "  > 2 + 3 * 4\n"
+    "  2 + 3 * 4 = 14\n"
+    "  > x = 5\n"
+    "  x = 5\n"
+    "  > sin(3.14159/2)\n"
+    "  sin(3.14159/2) = 1\n"
+    "  > area = 3.14159 * 5^2\n"
+    "  area = 78.5398\n"
+    "  > x^2 for x in 1..3\n"
+    "  x = 1, x^2 = 1\n"
+    "  x = 2, x^2 = 4\n"
+    "  x = 3, x^2 = 9\n"
+    "\n"
+    "COMMANDS:\n"
+    "  help                Show this help message\n"
+    "  vars                Display all variables\n"
+    "  clear               Clear all variables\n"
+    "  cache               Show expression cache statistics\n"
+    "  stats [reset]       Show or reset timings and node counts (builds with CALCULATOR_STATS)\n"
+    "  reactive on|off     Keep assignments as live formulas that update with their inputs\n"
+    "  precision [type]    Show or set the evaluation precision: long, double or float\n"
+    "  fastmath on|off     Use faster sin, cos, tan, exp and logarithms, accurate to about 1e-8\n"
+    "  digits [n]          Show or set the significant digits of results, 0 for the shortest exact form\n"
+    "  save [file]         Save all variables and live formulas to a snapshot file\n"
+    "  load [file]         Restore the variables saved in a snapshot file\n"
+	"  preserve [var]     Preserve variable when clearing (e.g. preserve x)\n"
+	"  remove [var]       Remove variable from preserved list (e.g. remove x)\n"
+    "  exit                Quit calculator\n"
+    "\n"
+    "PREDEFINED VARIABLES: \n"
+    "  pi                   The ratio of circumference to diameter\n"
+    "  e                    The base of natural logarithms\n"
+    "  deg2rad              Degrees to radians conversion factor\n"
+    "  rad2deg              Radians to degrees conversion factor\n"
+    "NOTE: Angles for trig functions are in radians.\n"
+    "      Use deg2rad to convert degrees to radians.";
+
+// Points evaluated per call to the batch evaluator
+constexpr std::size_t SWEEP_BLOCK = 1024;
+
+// Relative slack that keeps an end point the steps should land on from being lost to rounding
+constexpr long double SWEEP_TOLERANCE = 1e-9L;
+
+// Index of the "for" starting a sweep clause, or the number of tokens if there is none
+std::size_t sweepStart(const std::vector<Token>& tokens) {
+    for (std::size_t i = 1; i + 2 < tokens.size(); ++i) {
+        if (tokens[i].type == TokenType::VARIABLE && tokens[i].value == "for" && tokens[i + 1].type == TokenType::VARIABLE &&
+            tokens[i + 2].type == TokenType::VARIABLE && tokens[i + 2].value == "in") {
+            return i;
+        }
+    }
+    return tokens.size();
+}
+
+// Compiles the bounds and step of a sweep clause into the line's programs, folding preserved values into them
+void compileClause(Sweep& clause, const SymbolTable& constants, CompiledExpression& compiled) {
+    compiled.sweepSymbol = SymbolTable::intern(clause.variable);
+    compiled.sweepFrom = Compiler::compile(*optimize(std::move(clause.from), constants));
+    compiled.sweepTo = Compiler::compile(*optimize(std::move(clause.to), constants));
+    if (clause.step) { compiled.sweepStep = Compiler::compile(*optimize(std::move(clause.step), constants)); }
+}
+
+// Works out the first point and step of a sweep, and how many points it has
+std::size_t sweepPoints(const CompiledExpression& compiled, const Calculator& variables, long double& from, long double& step) {
+    from = variables.evaluate(compiled.sweepFrom);
+    const long double to = variables.evaluate(compiled.sweepTo);
+    step = compiled.sweepStep.size() == 0 ? 1 : variables.evaluate(compiled.sweepStep);
+    if (!std::isfinite(from) || !std::isfinite(to) || !std::isfinite(step)) {
+        throw std::runtime_error("sweep bounds and step must be finite");
+    }
+    if (step == 0) { throw std::runtime_error("sweep step cannot be zero"); }
+    const long double span = (to - from) / step;
+    if (span < 0) { throw std::runtime_error("sweep step points away from the end of the range"); }
+    const long double steps = std::floor(span + SWEEP_TOLERANCE * std::max(1.0L, span));
+    if (steps >= Session::MAX_SWEEP_POINTS) {
+        throw std::runtime_error("sweep has more than " + std::to_string(Session::MAX_SWEEP_POINTS) + " points");
+    }
+    return static_cast<std::size_t>(steps) + 1;
+}
+
+// Gives the swept variable's slot the column of points and broadcasts every other variable's value from fixed,
+// returning the swept slot, or the slot count if the program does not read the variable
+template <typename Scalar>
+std::size_t bindSweep(const Program& program, const SymbolId sweepSymbol, const SymbolTable& symbols, const Scalar* inputs,
+                      std::vector<Scalar>& fixed, std::vector<BasicSlotColumn<Scalar>>& columns) {
+    fixed.assign(program.slotCount(), 0);
+    columns.assign(program.slotCount(), {nullptr, 0});
+    std::size_t swept = program.slotCount();
+    for (std::size_t slot = 0; slot < program.slotCount(); ++slot) {
+        long double value;
+        if (program.slotSymbol(slot) == sweepSymbol) {
+            swept = slot;
+            columns[slot] = {inputs, 1};
+        }
+        else if (symbols.lookup(program.slotSymbol(slot), value)) {
+            fixed[slot] = static_cast<Scalar>(value);
+            columns[slot] = {&fixed[slot], 0};
+        }
+        else {
+            throw std::runtime_error(program.slotName(slot) + " is not recognized as a variable, function, or operation");
+        }
+    }
+    return swept;
+}
+
+// Runs the points of a sweep through the batch evaluator in one precision
+template <typename Scalar>
+void runSweep(const CompiledExpression& compiled, const SymbolTable& symbols, const long double from, const long double step,
+              const std::size_t points, const int digits, std::string& out, const std::function<void(std::string&)>& sink) {
+    const Program& program = compiled.program;
+
+    // Every other variable is broadcast; fixed also serves as the slot array of points evaluated one at a time
+    std::vector<Scalar> inputs(SWEEP_BLOCK);
+    std::vector<Scalar> results(SWEEP_BLOCK);
+    std::vector<Scalar> fixed;
+    std::vector<BasicSlotColumn<Scalar>> columns;
+    const std::size_t swept = bindSweep(program, compiled.sweepSymbol, symbols, inputs.data(), fixed, columns);
+
+    const std::string& name = SymbolTable::name(compiled.sweepSymbol);
+    for (std::size_t start = 0; start < points; start += SWEEP_BLOCK) {
+        const std::size_t n = std::min(SWEEP_BLOCK, points - start);
+        for (std::size_t k = 0; k < n; ++k) {
+            inputs[k] = static_cast<Scalar>(from + static_cast<long double>(start + k) * step); // no accumulated rounding error
+        }
+
+        // A domain error anywhere in the block sends it back through point by point, so only the failing points report it
+        const bool failed = program.runBatch(columns, n, results.data()) != EvalStatus::OK;
+        for (std::size_t k = 0; k < n; ++k) {
+            EvalStatus status = EvalStatus::OK;
+            if (failed) {
+                if (swept < fixed.size()) { fixed[swept] = inputs[k]; }
+                status = program.interpret(fixed.data(), results[k]);
+            }
+            out += name;
+            out += " = ";
+            appendNumber(out, inputs[k], digits);
+            if (status == EvalStatus::OK) {
+                out += ", ";
+                out += compiled.display;
+                out += "= ";
+                appendNumber(out, results[k], digits);
+            }
+            else {
+                out += ", Error: ";
+                out += statusMessage(status);
+            }
+            out += '\n';
+        }
+        if (sink && out.size() >= Session::SINK_THRESHOLD) { sink(out); }
+    }
+}
+
+// Evaluates every line of a fused block once, in one precision
+template <typename Scalar>
+EvalStatus runFusedOnce(const Program& program, const std::vector<long double>& slots, std::vector<long double>& values) {
+    const std::vector<Scalar> narrowed(slots.begin(), slots.end());
+    std::vector<BasicSlotColumn<Scalar>> columns(program.slotCount());
+    for (std::size_t slot = 0; slot < columns.size(); ++slot) { columns[slot] = {&narrowed[slot], 0}; }
+    std::vector<Scalar> results(program.outputCount());
+    std::vector<Scalar*> outputs(results.size());
+    for (std::size_t j = 0; j < results.size(); ++j) { outputs[j] = &results[j]; }
+    const EvalStatus status = program.runFused(columns, 1, outputs.data());
+    values.assign(results.begin(), results.end());
+    return status;
+}
+
+// Runs the points of a fused sweep a block at a time, every line of the block in the same pass over the points
+template <typename Scalar>
+void runFusedSweep(const Program& program, const std::vector<std::string>& labels, const SymbolId sweepSymbol,
+                   const SymbolTable& symbols, const long double from, const long double step, const std::size_t points,
+                   const int digits, std::string& out, const std::function<void(std::string&)>& sink) {
+    std::vector<Scalar> inputs(SWEEP_BLOCK);
+    std::vector<Scalar> fixed;
+    std::vector<BasicSlotColumn<Scalar>> columns;
+    const std::size_t swept = bindSweep(program, sweepSymbol, symbols, inputs.data(), fixed, columns);
+
+    // A column per line, and a one-row view of them for points that go through again on their own
+    std::vector<Scalar> results(labels.size() * SWEEP_BLOCK);
+    std::vector<Scalar*> outputs(labels.size());
+    std::vector<Scalar*> rowOutputs(labels.size());
+    std::vector<BasicSlotColumn<Scalar>> row(program.slotCount());
+    for (std::size_t slot = 0; slot < row.size(); ++slot) { row[slot] = {&fixed[slot], 0}; }
+    for (std::size_t j = 0; j < labels.size(); ++j) { outputs[j] = results.data() + j * SWEEP_BLOCK; }
+
+    const std::string& name = SymbolTable::name(sweepSymbol);
+    for (std::size_t start = 0; start < points; start += SWEEP_BLOCK) {
+        const std::size_t n = std::min(SWEEP_BLOCK, points - start);
+        for (std::size_t k = 0; k < n; ++k) { inputs[k] = static_cast<Scalar>(from + static_cast<long double>(start + k) * step); }
+
+        // As in a sweep of one line, a failing block is rerun point by point and only the failing rows report the error
+        const bool failed = program.runFused(columns, n, outputs.data()) != EvalStatus::OK;
+        for (std::size_t k = 0; k < n; ++k) {
+            EvalStatus status = EvalStatus::OK;
+            if (failed) {
+                if (swept < fixed.size()) { fixed[swept] = inputs[k]; }
+                for (std::size_t j = 0; j < labels.size(); ++j) { rowOutputs[j] = outputs[j] + k; }
+                status = program.runFused(row, 1, rowOutputs.data());
+            }
+            out += name;
+            out += " = ";
+            appendNumber(out, inputs[k], digits);
+            if (status == EvalStatus::OK) {
+                for (std::size_t j = 0; j < labels.size(); ++j) {
+                    out += ", ";
+                    out += labels[j];
+                    appendNumber(out, outputs[j][k], digits);
+                }
+            }
+            else {
+                out += ", Error: ";
+                out += statusMessage(status);
+            }
+            out += '\n';
+        }
+        if (sink && out.size() >= Session::SINK_THRESHOLD) { sink(out); }
+    }
+}
+
+} // namespace
+
+Session::Session(const std::size_t cacheCapacity) : cache(cacheCapacity) {}
+
+// Matches operator<< on a long double with default stream settings, which is %Lg
+std::string Session::formatResult(const long double value) {
+    std::string text;
+    appendNumber(text, value);
+    return text;
+}
+
+// Handles commands directly and hands everything else to the compile and evaluate pipeline
+bool Session::execute(const std::string_view line, std::string& out) {
+    if (line.empty()) { return true; } // Skip empty input
+    CALCULATOR_IF_STATS(const Stats::LineTimer timer(stats);)
+
+    // Handle special commands
+    if (line == "exit" || line == "quit") { return false; }
+    if (fusing) {
+        if (line != "end") {
+            fusedLines.emplace_back(line);
+            return true;
+        }
+        try { fuse(out); }
+        catch (const std::exception& e) {
+            out += "Error: ";
+            out += e.what();
+            out += '\n';
+        }
+        return true;
+    }
+    if (line == "help") { out += HELP_MESSAGE; out += '\n'; return true; }
+    if (line == "vars") {
+        std::ostringstream vars;
+        calc.printVars(vars, digits, precision);
+        out += vars.str();
+        return true;
+    }
+    if (line == "clear") { calc.clear(); out += "Variables cleared.\n"; return true; }
+    if (line == "cache") {
+        out += "Cached expressions: " + std::to_string(cache.size()) + "/" + std::to_string(cache.getCapacity()) +
+               ", hits: " + std::to_string(cache.hits()) + ", misses: " + std::to_string(cache.misses()) + "\n";
+        return true;
+    }
+    if (line == "stats" || line == "stats reset") {
+        if (!Stats::ENABLED) { out += "Error: statistics are not recorded, configure with -DCALCULATOR_STATS=ON\n"; }
+        else if (line == "stats") { out += stats.report(); }
+        else { stats.reset(); out += "Statistics reset.\n"; }
+        return true;
+    }
+    if (line == "reactive on" || line == "reactive off") {
+        setReactive(line == "reactive on");
+        out += reactive ? "Assignments are live formulas.\n" : "Assignments store values.\n";
+        return true;
+    }
+    if (line == "precision") {
+        out += std::string("Evaluating in ") + precisionName(precision) + " precision.\n";
+        return true;
+    }
+    if (line.substr(0, 10) == "precision ") {
+        const std::string name(line.substr(10));
+        if (parsePrecision(name, precision)) { out += std::string("Now evaluating in ") + precisionName(precision) + " precision.\n"; }
+        else { out += "Error: unknown precision " + name + ", expected long, double or float\n"; }
+        return true;
+    }
+    if (line == "fastmath on" || line == "fastmath off") {
+        setFastMath(line == "fastmath on");
+        out += fastMath ? "Using the fast math kernels.\n" : "Using the precise math functions.\n";
+        return true;
+    }
+    if (line == "fastmath") {
+        out += fastMath ? "Fast math is on.\n" : "Fast math is off.\n";
+        return true;
+    }
+    if (line == "digits") {
+        out += digits == SHORTEST_DIGITS ? std::string("Printing the shortest exact form of results.\n")
+                                         : "Printing results with " + std::to_string(digits) + " significant digits.\n";
+        return true;
+    }
+    if (line.substr(0, 7) == "digits ") {
+        const std::string count(line.substr(7));
+        char* end = nullptr;
+        const long parsed = std::strtol(count.c_str(), &end, 10);
+        if (count.empty() || *end != '\0' || parsed < 0 || parsed > MAX_DIGITS) {
+            out += "Error: expected a digit count from 1 to " + std::to_string(MAX_DIGITS) + ", or 0 for the shortest exact form\n";
+        } else {
+            digits = static_cast<int>(parsed);
+            out += "Now printing " + (digits == SHORTEST_DIGITS ? std::string("the shortest exact form of results")
+                                                                : "results with " + count + " significant digits") + ".\n";
+        }
+        return true;
+    }
+    if (line == "reactive") {
+        out += reactive ? "Reactive mode is on.\n" : "Reactive mode is off.\n";
+        return true;
+    }
+    if (line.substr(0, 5) == "save " || line.substr(0, 5) == "load ") {
+        if (!fileAccess) {
+            out += "Error: save and load are not available in this session\n";
+            return true;
+        }
+        const std::string path(line.substr(5));
+        try {
+            if (line[0] == 's') {
+                Snapshot::save(calc, path);
+                out += "Session saved to " + path + ".\n";
+            } else {
+                const std::size_t restored = Snapshot::load(calc, path);
+                out += "Restored " + std::to_string(restored) + " variables from " + path + ".\n";
+            }
+        } catch (const std::runtime_error& e) {
+            out += "Error: ";
+            out += e.what();
+            out += '\n';
+        }
+        return true;
+    }
+
+    if (line == "fuse" || line.substr(0, 5) == "fuse ") {
+        // The clause is compiled now, so a malformed one is reported before the block's lines are read
+        try {
+            fusedClause = CompiledExpression();
+            if (line.size() > 5) {
+                Parser parser(tokenize(line.substr(5)));
+                compileClause(parser.parseSweepClause(), calc.getConstants(), fusedClause);
+                fusedClause.kind = LineKind::SWEEP;
+            }
+            fusing = true;
+        } catch (const std::runtime_error& e) {
+            out += "Error: ";
+            out += e.what();
+            out += '\n';
+        }
+        return true;
+    }
+    if (line == "end") { out += "Error: end without a fuse line to close\n"; return true; }
+
+    // Process input
+    try {
+        const CompiledExpression& compiled = compileLine(line, calc);
+        switch (compiled.kind) {
+            case LineKind::PRESERVE:
+                calc.addPreservedValue(compiled.assignVar);
+                out += "Variable " + compiled.assignVar + " has been preserved.\n";
+                break;
+            case LineKind::REMOVE:
+                calc.removePreservedValue(compiled.assignVar);
+                out += "Variable " + compiled.assignVar + " has been removed from preserved variables.\n";
+                break;
+            case LineKind::ASSIGNMENT: {
+                long double value;
+                if (reactive) { value = calc.define(compiled.assignSymbol, compiled.formula, precision); }
+                else {
+                    CALCULATOR_IF_STATS(Stats::Stopwatch watch(stats); stats.addEvaluation(compiled.program);)
+                    value = calc.evaluate(compiled.program, precision);
+                    CALCULATOR_IF_STATS(watch.lap(Stage::EVALUATE);)
+                    calc.assign(compiled.assignSymbol, value, precision);
+                }
+                out += compiled.assignVar;
+                out += " = ";
+                appendNumber(out, value, digits, precision);
+                out += '\n';
+                reportRecomputed(out);
+                break;
+            }
+            case LineKind::EXPRESSION:
+                report(compiled, calc, out);
+                break;
+            case LineKind::SWEEP:
+                sweep(compiled, calc, out);
+                break;
+        }
+    } catch (const std::exception& e) {
+        out += "Error: ";
+        out += e.what();
+        out += '\n';
+    }
+    return true;
+}
+
+// Evaluates against a shared calculator, leaving it untouched
+void Session::evaluateShared(const std::string_view line, const Calculator& shared, std::string& out) {
+    if (line.empty()) { return; }
+    CALCULATOR_IF_STATS(const Stats::LineTimer timer(stats);)
+    try {
+        const CompiledExpression& compiled = compileLine(line, shared);
+        if (compiled.kind == LineKind::SWEEP) { sweep(compiled, shared, out); }
+        else if (compiled.kind == LineKind::EXPRESSION) { report(compiled, shared, out); }
+        else { throw std::logic_error("only expressions can be evaluated against a shared calculator"); }
+    } catch (const std::runtime_error& e) {
+        out += "Error: ";
+        out += e.what();
+        out += '\n';
+    }
+}
+
+// Rejects the command words, preserve and remove, and anything that may be an assignment
+bool Session::isReadOnly(const std::string_view line) {
+    if (line.empty() || line.find('=') != std::string_view::npos) { return false; }
+    if (line == "exit" || line == "quit" || line == "help" || line == "vars" || line == "clear" || line == "cache" ||
+        line == "stats" || line == "end") {
+        return false;
+    }
+    const std::size_t start = line.find_first_not_of(" \t");
+    if (start == std::string_view::npos) { return true; }
+    const std::string_view word = line.substr(start, line.find_first_of(" \t(", start) - start);
+    return word != "preserve" && word != "remove" && word != "reactive" && word != "precision" && word != "digits" &&
+           word != "save" && word != "load" && word != "stats" && word != "fuse" && word != "fastmath";
+}
+
+// Lists each downstream variable with its new value, indented under the assignment
+void Session::reportRecomputed(std::string& out) const {
+    for (const Recomputation& update : calc.recomputed()) {
+        out += "  ";
+        out += SymbolTable::name(update.symbol);
+        if (update.status == EvalStatus::OK) {
+            out += " = ";
+            appendNumber(out, update.value, digits, precision);
+            out += '\n';
+        }
+        else { out += std::string(": ") + statusMessage(update.status) + ", keeping the previous value\n"; }
+    }
+}
+
+// Assignments cached in the other mode lack or carry a formula they should not, so they are dropped
+void Session::setReactive(const bool enabled) {
+    if (enabled != reactive) { cache.clear(); }
+    reactive = enabled;
+}
+
+// Programs already in the cache keep the functions they were compiled with, so they are dropped
+void Session::setFastMath(const bool enabled) {
+    if (enabled != fastMath) { cache.clear(); }
+    fastMath = enabled;
+}
+
+// Echoes the expression before its result
+long double Session::report(const CompiledExpression& compiled, const Calculator& variables, std::string& out) {
+    CALCULATOR_IF_STATS(Stats::Stopwatch watch(stats); stats.addEvaluation(compiled.program);)
+    const long double result = variables.evaluate(compiled.program, precision);
+    CALCULATOR_IF_STATS(watch.lap(Stage::EVALUATE);)
+    out += compiled.display;
+    out += "= ";
+    appendNumber(out, result, digits, precision);
+    out += '\n';
+    return result;
+}
+
+// Works out the points of the range, then evaluates them in the session's precision
+void Session::sweep(const CompiledExpression& compiled, const Calculator& variables, std::string& out) {
+    long double from;
+    long double step;
+    const std::size_t points = sweepPoints(compiled, variables, from, step);
+
+    CALCULATOR_IF_STATS(Stats::Stopwatch watch(stats); stats.addEvaluation(compiled.program, points);)
+    const SymbolTable& symbols = variables.getConstants();
+    switch (precision) {
+        case Precision::LONG_DOUBLE: runSweep<long double>(compiled, symbols, from, step, points, digits, out, sink); break;
+        case Precision::DOUBLE: runSweep<double>(compiled, symbols, from, step, points, digits, out, sink); break;
+        case Precision::FLOAT: runSweep<float>(compiled, symbols, from, step, points, digits, out, sink); break;
+    }
+    CALCULATOR_IF_STATS(watch.lap(Stage::EVALUATE);)
+}
+
+// Parses every line of the block into one arena, compiles them into one program and evaluates it
+void Session::fuse(std::string& out) {
+    fusing = false;
+    const std::vector<std::string> lines = std::move(fusedLines);
+    fusedLines.clear();
+    if (lines.empty()) { throw std::runtime_error("a fused block needs at least one line"); }
+    const bool sweeping = fusedClause.kind == LineKind::SWEEP;
+    CALCULATOR_IF_STATS(Stats::Stopwatch watch(stats);)
+
+    arena.reset();
+    std::vector<std::unique_ptr<Node>> trees;
+    std::vector<FusedLine> parts;
+    std::vector<std::string> labels; // what each result is printed after
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        try {
+            std::vector<Token> tokens = tokenize(lines[i]);
+            std::string display = Calculator::printTokens(tokens);
+            Parser parser(std::move(tokens), &arena);
+            trees.push_back(parser.parse());
+            if (parser.isSweep()) { throw std::runtime_error("put the sweep clause after fuse, it applies to the whole block"); }
+            FusedLine part;
+            part.defines = parser.isAssignment();
+            if (part.defines) {
+                part.variable = SymbolTable::intern(parser.getAssignVar());
+                labels.push_back(parser.getAssignVar() + " = ");
+            }
+            else { labels.push_back(std::move(display) + "= "); }
+            parts.push_back(part);
+        } catch (const std::runtime_error& e) {
+            throw std::runtime_error("line " + std::to_string(i + 1) + " of the fused block: " + e.what());
+        }
+    }
+    CALCULATOR_IF_STATS(watch.lap(Stage::PARSE);)
+
+    // Preserved values are folded in, except for the names the block defines or sweeps, which it gives values of its own
+    SymbolTable constants = calc.getConstants();
+    for (const FusedLine& part : parts) {
+        if (part.defines) { constants.setPreserved(part.variable, false); }
+    }
+    if (sweeping) { constants.setPreserved(fusedClause.sweepSymbol, false); }
+    for (std::size_t i = 0; i < trees.size(); ++i) {
+        trees[i] = optimize(std::move(trees[i]), constants);
+        parts[i].expression = trees[i].get();
+    }
+    CALCULATOR_IF_STATS(watch.lap(Stage::OPTIMIZE);)
+    Program program = Compiler::compile(parts);
+    if (fastMath) { program.useFastMath(); }
+    CALCULATOR_IF_STATS(watch.lap(Stage::COMPILE);)
+
+    if (sweeping) {
+        long double from;
+        long double step;
+        const std::size_t points = sweepPoints(fusedClause, calc, from, step);
+        CALCULATOR_IF_STATS(stats.addEvaluation(program, points);)
+        const SymbolTable& symbols = calc.getConstants();
+        const SymbolId swept = fusedClause.sweepSymbol;
+        switch (precision) {
+            case Precision::LONG_DOUBLE: runFusedSweep<long double>(program, labels, swept, symbols, from, step, points, digits, out, sink); break;
+            case Precision::DOUBLE: runFusedSweep<double>(program, labels, swept, symbols, from, step, points, digits, out, sink); break;
+            case Precision::FLOAT: runFusedSweep<float>(program, labels, swept, symbols, from, step, points, digits, out, sink); break;
+        }
+        CALCULATOR_IF_STATS(watch.lap(Stage::EVALUATE);)
+        return;
+    }
+
+    // One row: nothing is stored unless every line evaluates
+    CALCULATOR_IF_STATS(stats.addEvaluation(program);)
+    const std::vector<long double> slots = program.bind(calc.getConstants());
+    std::vector<long double> values;
+    EvalStatus status = EvalStatus::OK;
+    switch (precision) {
+        case Precision::LONG_DOUBLE: status = runFusedOnce<long double>(program, slots, values); break;
+        case Precision::DOUBLE: status = runFusedOnce<double>(program, slots, values); break;
+        case Precision::FLOAT: status = runFusedOnce<float>(program, slots, values); break;
+    }
+    CALCULATOR_IF_STATS(watch.lap(Stage::EVALUATE);)
+    if (status != EvalStatus::OK) { throw std::runtime_error(statusMessage(status)); }
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        out += labels[i];
+        appendNumber(out, values[i], digits, precision);
+        out += '\n';
+        if (parts[i].defines) {
+            calc.assign(parts[i].variable, values[i], precision);
+            reportRecomputed(out);
+        }
+    }
+}
+
+// Looks the line up in the cache, and only lexes, parses and compiles it on a miss
+const CompiledExpression& Session::compileLine(const std::string_view line, const Calculator& constants) {
+    // Repeated lines skip lexing, parsing and compiling entirely
+    const std::string key = ExpressionCache::normalize(line);
+    if (const CompiledExpression* cached = cache.find(key, constants.getConstantsVersion())) {
+        CALCULATOR_IF_STATS(stats.addCacheLookup(true);)
+        return *cached;
+    }
+    CALCULATOR_IF_STATS(stats.addCacheLookup(false); Stats::Stopwatch watch(stats);)
+
+    arena.reset(); // the previous line's tree has been destroyed by now
+
+    // Tokenize input, and format it for display before the parser takes the tokens
+    std::vector<Token> tokens = tokenize(line);
+    CompiledExpression fresh;
+    if (const std::size_t clause = sweepStart(tokens); clause < tokens.size()) {
+        // Each point is reported against the expression alone
+        std::vector<Token> expressionTokens(tokens.begin(), tokens.begin() + static_cast<std::ptrdiff_t>(clause));
+        expressionTokens.emplace_back(TokenType::END, " ");
+        fresh.display = Calculator::printTokens(expressionTokens);
+    }
+    else { fresh.display = Calculator::printTokens(tokens); }
+    CALCULATOR_IF_STATS(watch.lap(Stage::LEX);)
+
+    // Initialize parser with the tokens
+    Parser parser(std::move(tokens), &arena);
+
+    // Handle preserve and remove commands
+    if (parser.parsePreserve()) {
+        fresh.kind = LineKind::PRESERVE;
+        fresh.assignVar = parser.getAssignVar();
+        return cache.insert(key, std::move(fresh));
+    }
+
+    if (parser.parseRemove()) {
+        fresh.kind = LineKind::REMOVE;
+        fresh.assignVar = parser.getAssignVar();
+        return cache.insert(key, std::move(fresh));
+    }
+
+    // Parse the expression into the tree
+    std::unique_ptr<Node> expression = parser.parse();
+    CALCULATOR_IF_STATS(watch.lap(Stage::PARSE);)
+
+    // A live formula must not capture the current values of preserved variables, so it is compiled from an unfolded copy
+    if (reactive && parser.isAssignment() && !parser.isSweep()) {
+        fresh.formula = Compiler::compile(*optimize(std::unique_ptr<Node>(expression->clone()), SymbolTable()));
+        if (fastMath) { fresh.formula.useFastMath(); }
+    }
+
+    // Fold constant subtrees and preserved values before compiling, except into a sweep, which may run over a preserved variable
+    expression = optimize(std::move(expression), parser.isSweep() ? SymbolTable() : constants.getConstants());
+    CALCULATOR_IF_STATS(watch.lap(Stage::OPTIMIZE);)
+
+    // Lower the tree into bytecode with variables resolved to slots, and remember it
+    fresh.program = Compiler::compile(*expression);
+    if (fastMath) { fresh.program.useFastMath(); }
+    CALCULATOR_IF_STATS(watch.lap(Stage::COMPILE);)
+    fresh.kind = parser.isAssignment() ? LineKind::ASSIGNMENT : LineKind::EXPRESSION;
+    if (parser.isSweep()) {
+        fresh.kind = LineKind::SWEEP;
+        compileClause(parser.getSweep(), constants.getConstants(), fresh);
+    }
+    fresh.assignVar = parser.getAssignVar();
+    if (fresh.kind == LineKind::ASSIGNMENT) { fresh.assignSymbol = SymbolTable::intern(fresh.assignVar); }
+    return cache.insert(key, std::move(fresh));
+}
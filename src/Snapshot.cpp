@@ -0,0 +1,268 @@
+/**
+ * @file Snapshot.cpp
+ * @brief Implementation of the snapshot reader and writer
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * Snapshots are written in the byte order and long double layout of the machine, which
+ * the header records so other machines refuse the file instead of misreading it. The
+ * whole file is read in one call and decoded into temporaries, and names are only interned,
+ * and the calculator only updated, once every record has been validated.
+ */
+
+#include "Snapshot.h"
+#include "Jit.h"
+#include "Lexicography.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr char MAGIC[8] = {'C', 'A', 'L', 'C', 'S', 'N', 'A', 'P'}; ///< First bytes of every snapshot
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304; ///< Reads back differently on a machine of the other endianness
+constexpr std::uint8_t DEFINED = 1;              ///< Flag for variables that hold a value
+constexpr std::uint8_t PRESERVED = 2;            ///< Flag for preserved variables
+
+// Appends fixed-size fields to the file contents
+class Writer {
+private:
+    std::string bytes;
+
+public:
+    template <typename T>
+    void put(const T& value) { bytes.append(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+    void putText(const std::string& text) {
+        put(static_cast<std::uint32_t>(text.size()));
+        bytes += text;
+    }
+
+    [[nodiscard]] const std::string& contents() const { return bytes; }
+};
+
+// Reads fixed-size fields back, rejecting any read past the end of the file
+class Reader {
+private:
+    std::string_view bytes;
+    std::size_t offset = 0;
+
+public:
+    explicit Reader(const std::string_view bytes) : bytes(bytes) {}
+
+    template <typename T>
+    T get() {
+        if (bytes.size() - offset < sizeof(T)) { throw std::runtime_error("snapshot is truncated"); }
+        T value;
+        std::memcpy(&value, bytes.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    std::string_view getText() {
+        const std::uint32_t length = get<std::uint32_t>();
+        if (bytes.size() - offset < length) { throw std::runtime_error("snapshot is truncated"); }
+        const std::string_view text = bytes.substr(offset, length);
+        offset += length;
+        return text;
+    }
+
+    // Reads a count of records, each at least minimumSize bytes, so a damaged count cannot trigger a huge allocation
+    std::uint32_t getCount(const std::size_t minimumSize) {
+        const std::uint32_t count = get<std::uint32_t>();
+        if (count > (bytes.size() - offset) / minimumSize) { throw std::runtime_error("snapshot is truncated"); }
+        return count;
+    }
+
+    [[nodiscard]] bool atEnd() const { return offset == bytes.size(); }
+};
+
+// Operations that read two registers
+bool isBinary(const OpCode op) {
+    return op == OpCode::ADD || op == OpCode::SUBTRACT || op == OpCode::MULTIPLY || op == OpCode::DIVIDE ||
+           op == OpCode::POWER || op == OpCode::LOG || op == OpCode::FAST_LOG;
+}
+
+// Whether the lexer reads the whole name back as one variable, so the session could have assigned it
+bool isVariableName(const std::string_view name) {
+    try {
+        const std::vector<Token> tokens = tokenize(name);
+        return tokens.size() == 2 && tokens[0].type == TokenType::VARIABLE && tokens[0].value.size() == name.size();
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+// A variable as stored in the file
+struct Entry {
+    std::string_view name;
+    SymbolId id;
+    std::uint8_t flags;
+    long double value;
+};
+
+} // namespace
+
+// Numbers every variable and formula input, then writes the table followed by the formulas
+void Snapshot::save(const Calculator& calc, const std::string& path) {
+    std::vector<SymbolId> table;
+    std::unordered_map<SymbolId, std::uint32_t> indices;
+    const auto number = [&](const SymbolId id) {
+        const auto [it, added] = indices.emplace(id, static_cast<std::uint32_t>(table.size()));
+        if (added) { table.push_back(id); }
+        return it->second;
+    };
+    for (const SymbolId id : calc.symbols.symbols()) { number(id); }
+    for (const auto& [id, formula] : calc.formulas) {
+        for (const SymbolId input : formula.slotSymbols) { number(input); }
+    }
+
+    Writer out;
+    for (const char c : MAGIC) { out.put(c); }
+    out.put(VERSION);
+    out.put(BYTE_ORDER_MARK);
+    out.put(static_cast<std::uint8_t>(sizeof(long double)));
+    out.put(static_cast<std::uint8_t>(LDBL_MANT_DIG));
+
+    out.put(static_cast<std::uint32_t>(table.size()));
+    for (const SymbolId id : table) {
+        long double value = 0;
+        std::uint8_t flags = 0;
+        if (calc.symbols.lookup(id, value)) { flags |= DEFINED; }
+        if (calc.symbols.isPreserved(id)) { flags |= PRESERVED; }
+        out.putText(SymbolTable::name(id));
+        out.put(flags);
+        out.put(value);
+    }
+
+    const auto saved = static_cast<std::uint32_t>(std::count_if(calc.formulas.begin(), calc.formulas.end(),
+                                                                 [](const auto& entry) { return !entry.second.hasRoutines(); }));
+    out.put(saved);
+    for (const auto& [id, formula] : calc.formulas) {
+        if (formula.hasRoutines()) { continue; }
+        out.put(indices.at(id));
+        out.put(formula.result);
+        out.put(static_cast<std::uint32_t>(formula.instructions.size()));
+        for (const Instruction& ins : formula.instructions) {
+            out.put(static_cast<std::uint8_t>(ins.op));
+            out.put(ins.a);
+            out.put(ins.b);
+        }
+        out.put(static_cast<std::uint32_t>(formula.constants.size()));
+        for (const long double constant : formula.constants) { out.put(constant); }
+        out.put(static_cast<std::uint32_t>(formula.slotSymbols.size()));
+        for (const SymbolId input : formula.slotSymbols) { out.put(indices.at(input)); }
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(out.contents().data(), static_cast<std::streamsize>(out.contents().size()));
+    if (!file) { throw std::runtime_error("cannot write snapshot " + path); }
+}
+
+// Decodes and validates the whole file before changing anything, then applies it like a replay would
+std::size_t Snapshot::load(Calculator& calc, const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) { throw std::runtime_error("cannot open snapshot " + path); }
+    const std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (file.bad()) { throw std::runtime_error("cannot read snapshot " + path); }
+
+    Reader in(contents);
+    for (const char c : MAGIC) {
+        if (in.get<char>() != c) { throw std::runtime_error(path + " is not a calculator snapshot"); }
+    }
+    if (in.get<std::uint32_t>() != VERSION) { throw std::runtime_error("snapshot " + path + " has an unsupported version"); }
+    if (in.get<std::uint32_t>() != BYTE_ORDER_MARK || in.get<std::uint8_t>() != sizeof(long double) ||
+        in.get<std::uint8_t>() != LDBL_MANT_DIG) {
+        throw std::runtime_error("snapshot " + path + " was written on an incompatible machine");
+    }
+
+    std::vector<Entry> entries(in.getCount(sizeof(std::uint32_t) + sizeof(std::uint8_t) + sizeof(long double)));
+    std::unordered_set<std::string_view> names;
+    for (Entry& entry : entries) {
+        entry.name = in.getText();
+        entry.flags = in.get<std::uint8_t>();
+        entry.value = in.get<long double>();
+        if (!isVariableName(entry.name)) { throw std::runtime_error("snapshot " + path + " has an invalid variable name"); }
+        if (!names.insert(entry.name).second) { throw std::runtime_error("snapshot " + path + " lists a variable twice"); }
+    }
+    const auto checkIndex = [&](const std::uint32_t index) {
+        if (index >= entries.size()) { throw std::runtime_error("snapshot refers to a missing variable"); }
+        return index;
+    };
+
+    // Targets and slots hold table indices until the names are interned below
+    std::vector<std::pair<SymbolId, Program>> formulas(in.getCount(5 * sizeof(std::uint32_t)));
+    std::vector<bool> hasFormula(entries.size());
+    for (auto& [target, formula] : formulas) {
+        target = checkIndex(in.get<std::uint32_t>());
+        if (!(entries[target].flags & DEFINED)) { throw std::runtime_error("snapshot has a formula for an undefined variable"); }
+        if (hasFormula[target]) { throw std::runtime_error("snapshot " + path + " has two formulas for one variable"); }
+        hasFormula[target] = true;
+        formula.result = in.get<std::uint32_t>();
+
+        formula.instructions.resize(in.getCount(sizeof(std::uint8_t) + 2 * sizeof(std::uint32_t)));
+        for (Instruction& ins : formula.instructions) {
+            ins.op = static_cast<OpCode>(in.get<std::uint8_t>());
+            ins.a = in.get<std::uint32_t>();
+            ins.b = in.get<std::uint32_t>();
+        }
+        formula.constants.resize(in.getCount(sizeof(long double)));
+        for (long double& constant : formula.constants) { constant = in.get<long double>(); }
+        formula.slotSymbols.resize(in.getCount(sizeof(std::uint32_t)));
+        for (SymbolId& input : formula.slotSymbols) { input = checkIndex(in.get<std::uint32_t>()); }
+
+        // Every operand must name the pool, a slot or an earlier register, as in a compiled program
+        const std::size_t count = formula.instructions.size();
+        bool valid = formula.result < count;
+        for (std::size_t i = 0; i < count && valid; ++i) {
+            const Instruction& ins = formula.instructions[i];
+            if (ins.op == OpCode::CONSTANT) { valid = ins.a < formula.constants.size(); }
+            else if (ins.op == OpCode::LOAD) { valid = ins.a < formula.slotSymbols.size(); }
+            else if (ins.op > OpCode::FAST_LOG) { valid = false; }
+            else if (ins.op >= OpCode::SOLVE && ins.op <= OpCode::SUM) { valid = false; } // routines are never saved
+            else { valid = ins.a < i && (!isBinary(ins.op) || ins.b < i); }
+        }
+        if (!valid) { throw std::runtime_error("snapshot " + path + " has a corrupt formula"); }
+#ifdef CALCULATOR_JIT_NATIVE
+        formula.tier = std::make_shared<JitTier>();
+#endif
+    }
+    if (!in.atEnd()) { throw std::runtime_error("snapshot " + path + " has trailing data"); }
+
+    for (Entry& entry : entries) { entry.id = SymbolTable::intern(entry.name); }
+    for (auto& [id, formula] : formulas) {
+        id = entries[id].id;
+        for (SymbolId& input : formula.slotSymbols) { input = entries[input].id; }
+    }
+
+    // Values first, so every formula's inputs exist by the time its edges are added
+    std::size_t restored = 0;
+    for (const Entry& entry : entries) {
+        if (!(entry.flags & DEFINED)) { continue; }
+        calc.unlink(entry.id);
+        calc.symbols.set(entry.id, entry.value);
+        calc.symbols.setPreserved(entry.id, entry.flags & PRESERVED);
+        ++restored;
+    }
+    for (auto& [id, formula] : formulas) {
+        // A formula closing a cycle with the calculator's own formulas stays a plain value, as define() would refuse it
+        bool circular = false;
+        for (const SymbolId input : formula.slotSymbols) { circular = circular || input == id || calc.reaches(id, input); }
+        if (circular) { continue; }
+        for (const SymbolId input : formula.slotSymbols) { calc.dependents[input].push_back(id); }
+        calc.formulas.insert_or_assign(id, std::move(formula));
+    }
+    calc.recomputations.clear();
+    ++calc.constantsVersion;
+    return restored;
+}
@@ -0,0 +1,167 @@
+/**
+ * @file Stats.cpp
+ * @brief Implementation of the session statistics
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * Recording is a handful of additions into fixed arrays, so an instrumented build stays
+ * close to the speed of a regular one. Reports name nodes after the Node classes they
+ * come from and print durations in microseconds; the JSON form keeps raw nanoseconds.
+ */
+
+#include "Stats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+// Names of the stages, indexed by Stage
+constexpr const char* STAGE_NAMES[Stats::STAGES] = {"lex", "parse", "optimize", "compile", "evaluate"};
+
+// The Node class behind each opcode, without the Node suffix, and prefixed with Fast for the fast kernels
+constexpr const char* NODE_NAMES[Stats::NODE_TYPES] = {
+    "Number", "Variable", "Add", "Subtract", "Multiply", "Divide", "Power", "Negate", "Abs", "Factorial",
+    "Sin", "Cos", "Tan", "ArcSin", "ArcCos", "ArcTan", "Exp", "Ln", "LogTen", "Log", "Sqrt",
+    "Solve", "Integrate", "Sum", "FastSin", "FastCos", "FastTan", "FastExp", "FastLn", "FastLogTen", "FastLog"};
+
+static_assert(static_cast<std::size_t>(OpCode::FAST_LOG) + 1 == Stats::NODE_TYPES, "every opcode needs a node name");
+
+// Nanoseconds as microseconds with two decimals
+std::string micros(const double nanoseconds) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.2f us", nanoseconds / 1000);
+    return text;
+}
+
+} // namespace
+
+void Stats::Stopwatch::lap(const Stage stage) {
+    const Clock::time_point now = Clock::now();
+    stats.addStage(stage, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count()));
+    last = now;
+}
+
+Stats::LineTimer::~LineTimer() {
+    stats.addLine(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started).count()));
+}
+
+void Stats::addStage(const Stage stage, const std::uint64_t nanoseconds) {
+    ++stageCalls[static_cast<std::size_t>(stage)];
+    stageNanos[static_cast<std::size_t>(stage)] += nanoseconds;
+}
+
+// Files the line under the highest set bit of its duration
+void Stats::addLine(const std::uint64_t nanoseconds) {
+    std::size_t bucket = 0;
+    while (bucket + 1 < LATENCY_BUCKETS && (nanoseconds >> (bucket + 1)) != 0) { ++bucket; }
+    ++latencies[bucket];
+    ++lineCount;
+    lineNanos += nanoseconds;
+    slowestLine = std::max(slowestLine, nanoseconds);
+}
+
+// Programs are straight-line code, so every instruction runs once per evaluation
+void Stats::addEvaluation(const Program& program, const std::uint64_t runs) {
+    for (const Instruction& ins : program.instructions) { nodeCounts[static_cast<std::size_t>(ins.op)] += runs; }
+}
+
+void Stats::merge(const Stats& other) {
+    for (std::size_t i = 0; i < STAGES; ++i) {
+        stageCalls[i] += other.stageCalls[i];
+        stageNanos[i] += other.stageNanos[i];
+    }
+    for (std::size_t i = 0; i < LATENCY_BUCKETS; ++i) { latencies[i] += other.latencies[i]; }
+    for (std::size_t i = 0; i < NODE_TYPES; ++i) { nodeCounts[i] += other.nodeCounts[i]; }
+    lineCount += other.lineCount;
+    lineNanos += other.lineNanos;
+    slowestLine = std::max(slowestLine, other.slowestLine);
+    cacheHits += other.cacheHits;
+    cacheMisses += other.cacheMisses;
+}
+
+std::uint64_t Stats::percentile(const double fraction) const {
+    const double wanted = fraction * static_cast<double>(lineCount);
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < LATENCY_BUCKETS; ++bucket) {
+        seen += latencies[bucket];
+        if (seen > 0 && static_cast<double>(seen) >= wanted) { return std::min(slowestLine, (std::uint64_t{2} << bucket) - 1); }
+    }
+    return slowestLine;
+}
+
+std::string Stats::report() const {
+    if (lineCount == 0) { return "No lines processed yet.\n"; }
+    std::string out = "Lines: " + std::to_string(lineCount) + ", mean " + micros(static_cast<double>(lineNanos) / lineCount) +
+                      ", p50 " + micros(percentile(0.5)) + ", p99 " + micros(percentile(0.99)) +
+                      ", max " + micros(slowestLine) + "\n";
+
+    const std::uint64_t lookups = cacheHits + cacheMisses;
+    out += "Expression cache: " + std::to_string(cacheHits) + " hits, " + std::to_string(cacheMisses) + " misses";
+    if (lookups != 0) { out += " (" + std::to_string(cacheHits * 100 / lookups) + "% hit rate)"; }
+    out += '\n';
+
+    out += "Stages:\n";
+    for (std::size_t i = 0; i < STAGES; ++i) {
+        if (stageCalls[i] == 0) { continue; }
+        char row[96];
+        std::snprintf(row, sizeof(row), "  %-10s %10llu calls  %14s total  %12s mean\n", STAGE_NAMES[i],
+                      static_cast<unsigned long long>(stageCalls[i]), micros(static_cast<double>(stageNanos[i])).c_str(),
+                      micros(static_cast<double>(stageNanos[i]) / stageCalls[i]).c_str());
+        out += row;
+    }
+
+    out += "Nodes evaluated:\n";
+    for (std::size_t i = 0; i < NODE_TYPES; ++i) {
+        if (nodeCounts[i] == 0) { continue; }
+        char row[64];
+        std::snprintf(row, sizeof(row), "  %-10s %12llu\n", NODE_NAMES[i], static_cast<unsigned long long>(nodeCounts[i]));
+        out += row;
+    }
+
+    out += "Line latency:\n";
+    for (std::size_t bucket = 0; bucket < LATENCY_BUCKETS; ++bucket) {
+        if (latencies[bucket] == 0) { continue; }
+        char row[64];
+        std::snprintf(row, sizeof(row), "  < %-14s %12llu\n", micros(static_cast<double>(std::uint64_t{2} << bucket)).c_str(),
+                      static_cast<unsigned long long>(latencies[bucket]));
+        out += row;
+    }
+    return out;
+}
+
+std::string Stats::json() const {
+    std::string out = "{\"lines\":" + std::to_string(lineCount) + ",\"line_ns\":" + std::to_string(lineNanos) +
+                      ",\"max_line_ns\":" + std::to_string(slowestLine) + ",\"p50_ns\":" + std::to_string(percentile(0.5)) +
+                      ",\"p99_ns\":" + std::to_string(percentile(0.99));
+    out += ",\"cache\":{\"hits\":" + std::to_string(cacheHits) + ",\"misses\":" + std::to_string(cacheMisses) + "}";
+
+    out += ",\"stages\":{";
+    for (std::size_t i = 0; i < STAGES; ++i) {
+        if (i != 0) { out += ','; }
+        out += std::string("\"") + STAGE_NAMES[i] + "\":{\"calls\":" + std::to_string(stageCalls[i]) +
+               ",\"ns\":" + std::to_string(stageNanos[i]) + "}";
+    }
+
+    out += "},\"nodes\":{";
+    bool first = true;
+    for (std::size_t i = 0; i < NODE_TYPES; ++i) {
+        if (nodeCounts[i] == 0) { continue; }
+        if (!first) { out += ','; }
+        out += std::string("\"") + NODE_NAMES[i] + "\":" + std::to_string(nodeCounts[i]);
+        first = false;
+    }
+
+    // Each bucket is keyed by its exclusive upper bound
+    out += "},\"latency_histogram_ns\":{";
+    first = true;
+    for (std::size_t bucket = 0; bucket < LATENCY_BUCKETS; ++bucket) {
+        if (latencies[bucket] == 0) { continue; }
+        if (!first) { out += ','; }
+        out += "\"" + std::to_string(std::uint64_t{2} << bucket) + "\":" + std::to_string(latencies[bucket]);
+        first = false;
+    }
+    out += "}}\n";
+    return out;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file SymbolTable.cpp
+ * @brief Implementation of the symbol registry and table
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * Names are interned into a deque so that references handed out by name() stay valid
+ * as the registry grows. The registry is guarded by a mutex since parallel batch
+ * sessions parse on several threads; interning only happens while parsing, never
+ * while evaluating. Names are only released with their registry, so each is capped.
+ */
+
+#include "SymbolTable.h"
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace {
+
+// Registry made current on this thread by a scope, if any
+thread_local SymbolRegistry* activeRegistry = nullptr;
+
+// The scoped registry, or the process-wide one
+SymbolRegistry& registry() {
+    static SymbolRegistry global;
+    return activeRegistry ? *activeRegistry : global;
+}
+
+} // namespace
+
+SymbolRegistry::Scope::Scope(SymbolRegistry& registry) : previous(activeRegistry) { activeRegistry = &registry; }
+
+SymbolRegistry::Scope::~Scope() { activeRegistry = previous; }
+
+SymbolId SymbolTable::intern(const std::string_view name) {
+    SymbolRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if (auto it = r.ids.find(name); it != r.ids.end()) { return it->second; }
+    if (r.names.size() >= MAX_SYMBOLS || r.text + name.size() > MAX_SYMBOL_TEXT) {
+        throw std::runtime_error("too many distinct variable names");
+    }
+    r.text += name.size();
+    const auto id = static_cast<SymbolId>(r.names.size());
+    r.names.emplace_back(name);
+    r.ids.emplace(r.names.back(), id);
+    return id;
+}
+
+const std::string& SymbolTable::name(const SymbolId id) {
+    SymbolRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    return r.names[id];
+}
+
+// Grows the columns to cover the id, with some slack so consecutive new symbols do not reallocate
+void SymbolTable::reserve(const SymbolId id) {
+    const std::size_t size = std::max<std::size_t>(id + 1, 2 * flags.size());
+    values.resize(size);
+    flags.resize(size);
+}
+
+void SymbolTable::setPreserved(const SymbolId id, const bool preserved) {
+    if (id >= flags.size()) { reserve(id); }
+    if (preserved) { flags[id] |= PRESERVED; }
+    else { flags[id] &= static_cast<std::uint8_t>(~PRESERVED); }
+}
+
+// Keeps preserved symbols in their original order and drops the DEFINED bit of the rest
+void SymbolTable::clear() {
+    std::size_t kept = 0;
+    for (const SymbolId id : definedIds) {
+        if (flags[id] & PRESERVED) { definedIds[kept++] = id; }
+        else { flags[id] &= static_cast<std::uint8_t>(~DEFINED); }
+    }
+    definedIds.resize(kept);
+}
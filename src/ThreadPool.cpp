@@ -0,0 +1,117 @@
+/**
+ * @file ThreadPool.cpp
+ * @brief Implementation of the work-stealing thread pool
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * Workers sleep on a condition variable between jobs. A job deals contiguous blocks of
+ * task indices to the per-worker queues, wakes every worker and has the caller drain
+ * its own queue as worker 0; whoever runs dry steals from the others.
+ */
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+ThreadPool::ThreadPool(std::size_t size) {
+    if (size == 0) { size = std::max(1u, std::thread::hardware_concurrency()); }
+    for (std::size_t i = 0; i < size; ++i) { queues.push_back(std::make_unique<Queue>()); }
+    for (std::size_t i = 1; i < size; ++i) { threads.emplace_back(&ThreadPool::workerLoop, this, i); }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) { thread.join(); }
+}
+
+// Deals the range out in contiguous blocks, runs worker 0 on this thread and waits for the rest
+void ThreadPool::parallelFor(const std::size_t count, const std::function<void(std::size_t, std::size_t)>& task) {
+    if (count == 0) { return; }
+    const std::size_t workers = queues.size();
+    for (std::size_t w = 0; w < workers; ++w) {
+        std::lock_guard<std::mutex> lock(queues[w]->mutex);
+        for (std::size_t i = count * w / workers; i < count * (w + 1) / workers; ++i) {
+            queues[w]->tasks.push_back(i);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &task;
+        failure = nullptr;
+        active = threads.size();
+        ++generation;
+    }
+    wake.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return active == 0; });
+    job = nullptr;
+    if (failure) { std::rethrow_exception(failure); }
+}
+
+// Waits for each new job and helps drain it
+void ThreadPool::workerLoop(const std::size_t worker) {
+    std::size_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) { return; }
+            seen = generation;
+        }
+        drain(worker);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--active == 0) { finished.notify_one(); }
+        }
+    }
+}
+
+// Runs tasks until none are left anywhere, recording the first failure
+void ThreadPool::drain(const std::size_t worker) {
+    std::size_t task;
+    while (take(worker, task)) {
+        try {
+            (*job)(task, worker);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failure) { failure = std::current_exception(); }
+        }
+    }
+}
+
+// Pops from the worker's own queue first, then steals from the back of the others
+bool ThreadPool::take(const std::size_t worker, std::size_t& task) {
+    {
+        Queue& own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    for (std::size_t offset = 1; offset < queues.size(); ++offset) {
+        Queue& victim = *queues[(worker + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
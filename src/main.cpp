@@ -5,82 +5,158 @@
  * @date 2025-8-18
  *
  * This file contains the main loop for the calculator application.
- * It handles user input, and calls on the lexer, parser, and evaluator to process expressions.
- * It also provides a help message and handles special commands like "vars" and "clear".
- * Using a try-catch block, it handles errors and provides error info to the user.
+ * It reads user input and hands each line to a Session, which calls on the lexer, parser,
+ * and evaluator to process expressions and handles special commands like "vars" and "clear".
+ * With --batch or a file argument it instead processes all input non-interactively, without
+ * a prompt and with buffered output, optionally spreading independent expressions over
+ * several threads with --threads. --load restores a saved snapshot before any input is read,
+ * and --stats writes the session's statistics as JSON once batch input is done. --fast-math
+ * switches the transcendental functions to their fast kernels. --listen serves
+ * a separate session to every client of a socket instead of reading standard input.
  *
  */
-#include "Calculator.h"
-#include "Lexicography.h"
-#include "Parser.h"
+#include "Batch.h"
+#include "Server.h"
+#include "Session.h"
+#include "Snapshot.h"
 
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
-#include <vector>
+#include <stdexcept>
 #include <string>
-#include <memory>
-
-// Help message, courtesy of ChatGPT
-const std::string HELP_MESSAGE =
-    "=== Calculator Help ===\n"
-    "\n"
-    "BASIC OPERATIONS:\n"
-    "  +, -, *, /          Basic arithmetic\n"
-    "  ^                   Exponentiation (2^3 = 8)\n"
-    "  ( )                 Parentheses for grouping\n"
-    "  | |                 Absolute value\n"
-    "\n"
-    "VARIABLES:\n"
-    "  x = 5               Assign value to variable\n"
-    "  y = x * 2 + 3       Use variables in expressions\n"
-    "  vars                Show all variables\n"
-    "\n"
-    "FUNCTIONS:\n"
-    "  sin(x), cos(x), tan(x)     Trigonometric functions\n"
-    "  asin(x), acos(x), atan(x)  Inverse trig functions\n"
-    "  exp(x)              e^x\n"
-    "  ln(x)               Natural logarithm\n"
-    "  log10(x)            Base-10 logarithm\n"
-    "  log(x,y)            Logarithm base y of x\n"
-    "  sqrt(x)             Square root\n"
-    "  abs(x)              Absolute value\n"
-    "\n"
-    "EXAMPLES:\n"
-    "  > 2 + 3 * 4\n"
-    "  2 + 3 * 4 = 14\n"
-    "  > x = 5\n"
-    "  x = 5\n"
-    "  > sin(3.14159/2)\n"
-    "  sin(3.14159/2) = 1\n"
-    "  > area = 3.14159 * 5^2\n"
-    "  area = 78.5398\n"
-    "\n"
-    "COMMANDS:\n"
-    "  help                Show this help message\n"
-    "  vars                Display all variables\n"
-    "  clear               Clear all variables\n"
-	"  preserve [var]     Preserve variable when clearing (e.g. preserve x)\n"
-	"  remove [var]       Remove variable from preserved list (e.g. remove x)\n"
-    "  exit                Quit calculator\n"
-    "\n"
-    "PREDEFINED VARIABLES: \n"
-    "  pi                   The ratio of circumference to diameter\n"
-    "  e                    The base of natural logarithms\n"
-    "  deg2rad              Degrees to radians conversion factor\n"
-    "  rad2deg              Radians to degrees conversion factor\n"
-    "NOTE: Angles for trig functions are in radians.\n"
-    "      Use deg2rad to convert degrees to radians.";
-
-int main() {
+#include <string_view>
+
+// Number of compiled lines kept for reuse
+constexpr std::size_t CACHE_CAPACITY = 1024;
+
+// Command line usage
+const std::string USAGE =
+    "Usage: calculator [--batch] [--threads N] [--precision P] [--fast-math] [--digits D] [--load S] [--stats F] [--listen A] [file]\n"
+    "  (no arguments)      Interactive mode\n"
+    "  --batch, -b         Read expressions from standard input without a prompt\n"
+    "  --threads N, -j N   Evaluate batch input on N threads (0 = one per core, default 1)\n"
+    "  --precision P, -p P Evaluate in long (default), double or float precision\n"
+    "  --fast-math         Use faster sin, cos, tan, exp and logarithms, accurate to about 1e-8\n"
+    "  --digits D, -d D    Print results with D significant digits (default 6, 0 = shortest exact form)\n"
+    "  --load S, -l S      Restore the variables of snapshot S before reading input\n"
+    "  --stats F           Write timings and node counts to F as JSON after batch input (builds with CALCULATOR_STATS)\n"
+    "  --listen A          Serve a session per client on A: PORT or HOST:PORT for TCP, a path with '/' for a Unix socket\n"
+    "  file                Read expressions from file without a prompt";
+
+int main(int argc, char* argv[]) {
 
     using std::cout;
     using std::cin;
     using std::endl;
     using std::string;
-    using std::vector;
 
-    // Initialize calculator and input string
-    Calculator calc;
+    // Parse command line options
+    bool batch = false;
+    const char* path = nullptr;
+    std::size_t threads = 1;
+    Precision precision = DEFAULT_PRECISION;
+    bool fastMath = false;
+    int digits = DEFAULT_DIGITS;
+    const char* snapshot = nullptr;
+    const char* statsPath = nullptr;
+    const char* listenAddress = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--batch" || arg == "-b") { batch = true; }
+        else if (arg == "--help" || arg == "-h") { cout << USAGE << endl; return 0; }
+        else if (arg == "--threads" || arg == "-j") {
+            char* end = nullptr;
+            if (i + 1 < argc) { threads = std::strtoul(argv[++i], &end, 10); }
+            if (!end || end == argv[i] || *end != '\0') {
+                std::cerr << "Option " << arg << " expects a thread count\n" << USAGE << endl;
+                return 1;
+            }
+            batch = true;
+        }
+        else if (arg == "--precision" || arg == "-p") {
+            if (i + 1 == argc || !parsePrecision(argv[++i], precision)) {
+                std::cerr << "Option " << arg << " expects long, double or float\n" << USAGE << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--fast-math") { fastMath = true; }
+        else if (arg == "--digits" || arg == "-d") {
+            char* end = nullptr;
+            long parsed = -1;
+            if (i + 1 < argc) { parsed = std::strtol(argv[++i], &end, 10); }
+            if (!end || end == argv[i] || *end != '\0' || parsed < 0 || parsed > MAX_DIGITS) {
+                std::cerr << "Option " << arg << " expects a digit count from 0 to " << MAX_DIGITS << "\n" << USAGE << endl;
+                return 1;
+            }
+            digits = static_cast<int>(parsed);
+        }
+        else if (arg == "--load" || arg == "-l") {
+            if (i + 1 == argc) { std::cerr << "Option " << arg << " expects a snapshot file\n" << USAGE << endl; return 1; }
+            snapshot = argv[++i];
+        }
+        else if (arg == "--stats") {
+            if (i + 1 == argc) { std::cerr << "Option " << arg << " expects a file name\n" << USAGE << endl; return 1; }
+            if (!Stats::ENABLED) { std::cerr << "Option " << arg << " needs a build configured with -DCALCULATOR_STATS=ON" << endl; return 1; }
+            statsPath = argv[++i];
+            batch = true;
+        }
+        else if (arg == "--listen") {
+            if (i + 1 == argc) { std::cerr << "Option " << arg << " expects an address\n" << USAGE << endl; return 1; }
+            listenAddress = argv[++i];
+        }
+        else if (!arg.empty() && arg[0] == '-') { std::cerr << "Unknown option " << arg << "\n" << USAGE << endl; return 1; }
+        else { path = argv[i]; batch = true; }
+    }
+
+    // Initialize the session, which owns the calculator
+    Session session(CACHE_CAPACITY);
+    session.setPrecision(precision);
+    session.setFastMath(fastMath);
+    session.setDigits(digits);
+    if (snapshot) {
+        try { Snapshot::load(session.calculator(), snapshot); }
+        catch (const std::runtime_error& e) { std::cerr << "Error: " << e.what() << endl; return 1; }
+    }
+
+    // Server mode: every client gets a session configured like this one
+    if (listenAddress) {
+        const auto setup = [&](Session& client) {
+            client.setPrecision(precision);
+            client.setFastMath(fastMath);
+            client.setDigits(digits);
+            if (snapshot) {
+                try { Snapshot::load(client.calculator(), snapshot); }
+                catch (const std::runtime_error& e) { std::cerr << "Error: " << e.what() << endl; }
+            }
+        };
+        try { runServer(listenAddress, setup, CACHE_CAPACITY); }
+        catch (const std::runtime_error& e) { std::cerr << "Error: " << e.what() << endl; return 1; }
+        return 0;
+    }
+
+    // Batch mode: no prompt, no banner, buffered output
+    if (batch) {
+        std::ios::sync_with_stdio(false);
+        std::ifstream file;
+        if (path) {
+            file.open(path, std::ios::binary);
+            if (!file) { std::cerr << "Error: cannot open " << path << endl; return 1; }
+        }
+        std::istream& source = path ? static_cast<std::istream&>(file) : cin;
+        if (threads == 1) { runBatch(session, source, cout); }
+        else { runParallelBatch(session, source, cout, threads); }
+        if (statsPath) {
+            std::ofstream stats(statsPath, std::ios::trunc);
+            stats << session.statistics().json();
+            if (!stats) { std::cerr << "Error: cannot write " << statsPath << endl; return 1; }
+        }
+        return 0;
+    }
+
     string input;
+    string output;
+    session.setSink([](string& buffer) { cout << buffer; buffer.clear(); }); // long sweeps print as they go
 
     cout << "Calculator (in development)" << endl;
     cout << "Type 'help' for assistance." << endl;
@@ -88,67 +164,13 @@ int main() {
     // Main loop
     while (true) {
         cout << "> ";
-        getline(cin, input);
-        if (input.empty()) continue; // Skip empty input
-
-        // Handle special commands
-        if (input == "exit" || input == "quit") break; // Exit loop
-        if (input == "help") { cout << HELP_MESSAGE << endl; continue; } // Print help message
-        if (input == "vars") { calc.printVars(); continue; } // Print variables
-        if (input == "clear") { calc.clear(); cout << "Variables cleared." << endl; continue; } // Clear variables
-
-        // Process input
-        try {
-
-            // Tokenize input
-            const vector<Token> tokens = tokenize(input);
-            //cout << "Tokens: ";
-            //for (const auto& token : tokens) {
-            //    cout << "[" << static_cast<int>(token.type) << ", " << token.value << "], ";
-            //}
-            //cout << endl;
-
-            // Initialize parser with the tokens
-            Parser parser(tokens);
-
-            // Handle preserve and remove commands
-            if (parser.parsePreserve()) {
-				calc.addPreservedValue(parser.getAssignVar());
-				cout << "Variable " << parser.getAssignVar() << " has been preserved." << endl;
-                continue;
-            }
-
-            if (parser.parseRemove()) {
-				calc.removePreservedValue(parser.getAssignVar());
-				cout << "Variable " << parser.getAssignVar() << " has been removed from preserved variables." << endl;
-                continue;
-            }
-
-            // Parse the expression into the tree
-            std::unique_ptr<Node> expression = parser.parse();
-
-            // If the input was an assigment then assign the variable
-            if (parser.isAssignment()) {
-                //cout << "variable" << endl;
-                string varName = parser.getAssignVar();
-                const long double result = calc.evaluate(std::move(expression));
-                calc.assign(varName, result);
+        if (!getline(cin, input)) break; // End of input
 
-				//cout << "varName: " << varName << endl;
-				//cout << "result: " << result << endl;
-                cout << varName << " = " << result << endl;
-            }
-
-            // Otherwise evaluate the expression and print the result
-            else {
-				//cout << "expression" << endl;
-                const long double result = calc.evaluate(std::move(expression));
-                cout << calc.printTokens(tokens) << "= " << result << endl;
-            }
-        // error handling
-        } catch (const std::exception& e) {
-            cout << "Error: " << e.what() << endl; // print error message
-        }
+        // Hand the line to the session, exit if it asks to
+        const bool running = session.execute(input, output);
+        cout << output << std::flush;
+        output.clear();
+        if (!running) break;
     }
 
     return 0;
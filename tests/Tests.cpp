@@ -0,0 +1,193 @@
+/**
+ * @file Tests.cpp
+ * @brief Regression checks for the calculator core
+ * @author Ethan Ye
+ * @date 2026-10-14
+ *
+ * This file builds the calculator_tests executable. Each check drives the public entry
+ * points the way the front ends do and throws on the first wrong result. CTest runs every
+ * check by name; run the executable without arguments to run them all.
+ */
+
+#include "Expression.h"
+#include "Session.h"
+#include "Snapshot.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+struct Check {
+    std::string name;
+    std::function<void()> body;
+};
+
+void expect(const bool condition, const std::string& message) {
+    if (!condition) { throw std::runtime_error(message); }
+}
+
+// Runs the lines through a fresh session and returns everything it printed
+std::string transcript(Session& session, const std::vector<std::string_view>& lines) {
+    std::string out;
+    for (const std::string_view line : lines) { session.execute(line, out); }
+    return out;
+}
+
+// A live formula evaluates in the session's precision, so it prints what a plain assignment does
+void reactiveFloat() {
+    Session plain;
+    const std::string fixed = transcript(plain, {"precision float", "digits 12", "x = 0.1", "y = x*3"});
+    Session live;
+    const std::string formula = transcript(live, {"precision float", "digits 12", "reactive on", "x = 0.1", "y = x*3", "x = 0.2"});
+    expect(fixed.find("y = 0.300000011921\n") != std::string::npos, "plain float assignment printed:\n" + fixed);
+    expect(formula.find("y = 0.300000011921\n") != std::string::npos, "live float formula printed:\n" + formula);
+    expect(formula.find("y = 0.600000023842\n") != std::string::npos, "float recomputation printed:\n" + formula);
+}
+
+// Sessions without file access refuse save and load instead of touching the path
+void noFileAccess() {
+    Session session;
+    session.setFileAccess(false);
+    const std::string out = transcript(session, {"x = 1", "save /tmp/calculator_tests_refused.snap", "load /etc/passwd"});
+    expect(out.find("Session saved") == std::string::npos && out.find("Restored") == std::string::npos, "file command ran:\n" + out);
+    std::FILE* file = std::fopen("/tmp/calculator_tests_refused.snap", "rb");
+    if (file) { std::fclose(file); }
+    expect(file == nullptr, "save wrote the snapshot");
+}
+
+// Filling one registry to its cap leaves other registries, and the sessions built under them, working
+void registryIsolation() {
+    SymbolRegistry flooded;
+    {
+        const SymbolRegistry::Scope scope(flooded);
+        for (std::size_t k = 0; k < SymbolTable::MAX_SYMBOLS; ++k) { SymbolTable::intern("v" + std::to_string(k)); }
+        bool refused = false;
+        try { SymbolTable::intern("one_more"); } catch (const std::runtime_error&) { refused = true; }
+        expect(refused, "a full registry took another name");
+    }
+    SymbolRegistry other;
+    const SymbolRegistry::Scope scope(other);
+    Session session;
+    const std::string out = transcript(session, {"fresh = 2", "fresh * 3"});
+    expect(out.find("fresh * 3 = 6\n") != std::string::npos, "session beside a full registry printed:\n" + out);
+    expect(SymbolTable::intern("fresh") < 16, "ids of a new registry do not start from 0");
+}
+
+// Expression::compile refuses input it cannot represent instead of compiling part of it
+void expressionRejectsSweep() {
+    for (const std::string_view text : {"x = 2", "x^2 for x in 0..1 step 0.1"}) {
+        bool refused = false;
+        try { Expression::compile(text); } catch (const std::runtime_error&) { refused = true; }
+        expect(refused, "Expression::compile accepted: " + std::string(text));
+    }
+    Expression plain = Expression::compile("x^2 + 1");
+    long double result = 0;
+    expect(plain.set("x", 3) && plain.evaluate(result) == EvalStatus::OK && result == 10, "x^2 + 1 at 3 is not 10");
+}
+
+// evaluateBatch() broadcasts bound values into the slots the caller leaves without a column
+void expressionBatch() {
+    Expression f = Expression::compile("x * 10 + y");
+    const std::size_t x = f.slotOf("x");
+    const long double xs[] = {1, 2, 3};
+    std::vector<SlotColumn> columns(x + 1, SlotColumn{nullptr, 0});
+    columns[x] = {xs, 1};
+    long double out[3] = {};
+    expect(f.evaluateBatch(columns, 3, out) == EvalStatus::UNBOUND_VARIABLE, "y was used before it was bound");
+    f.set("y", 0.5);
+    for (int pass = 0; pass < 2; ++pass) {
+        expect(f.evaluateBatch(columns, 3, out) == EvalStatus::OK, "batch over x failed");
+        expect(out[0] == 10.5 && out[1] == 20.5 && out[2] == 30.5, "batch over x gave the wrong rows");
+    }
+}
+
+// Saves x and y, renames y in the file and expects loading the result to fail without changing x
+void expectRefusedRename(const std::string& renamed) {
+    const std::string path = "/tmp/calculator_tests_renamed.snap";
+    Calculator saved;
+    saved.assign("x", 1);
+    saved.assign("y", 2);
+    Snapshot::save(saved, path);
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    const std::uint32_t length = 1;
+    std::string field(sizeof(length), '\0');
+    std::memcpy(field.data(), &length, sizeof(length));
+    const std::size_t at = bytes.find(field + "y");
+    expect(at != std::string::npos, "snapshot does not hold the name y");
+    bytes.replace(at + field.size(), 1, renamed);
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+
+    Calculator target;
+    target.assign("x", 5);
+    bool refused = false;
+    try { Snapshot::load(target, path); } catch (const std::runtime_error&) { refused = true; }
+    std::remove(path.c_str());
+    long double x = 0;
+    expect(refused, "snapshot with y renamed to " + renamed + " was loaded");
+    expect(target.lookup("x", x) && x == 5, "refused snapshot changed x");
+}
+
+// A snapshot is checked for names the lexer could not have produced, and for repeats, before any is used
+void snapshotNames() {
+    expectRefusedRename("x");
+    expectRefusedRename("9");
+    expectRefusedRename("*");
+}
+
+// With digits 0 a result prints the shortest text that reads back in the engine that computed it
+void shortestPerEngine() {
+    std::string text;
+    appendNumber(text, 0.1f, SHORTEST_DIGITS);
+    expect(text == "0.1", "shortest 0.1f printed " + text);
+    Session single;
+    const std::string fromFloat = transcript(single, {"precision float", "digits 0", "y = 0.1*3", "y*2 for y in 0..0.1 step 0.1"});
+    expect(fromFloat.find("y = 0.3\n") != std::string::npos, "float assignment printed:\n" + fromFloat);
+    expect(fromFloat.find("y = 0.1, y * 2 = 0.2\n") != std::string::npos, "float sweep printed:\n" + fromFloat);
+    Session twice;
+    const std::string fromDouble = transcript(twice, {"precision double", "digits 0", "y = 0.1*3"});
+    expect(fromDouble.find("y = 0.30000000000000004\n") != std::string::npos, "double assignment printed:\n" + fromDouble);
+}
+
+const std::vector<Check>& checks() {
+    static const std::vector<Check> list = {
+        {"reactive_float", reactiveFloat},
+        {"no_file_access", noFileAccess},
+        {"registry_isolation", registryIsolation},
+        {"expression_rejects_sweep", expressionRejectsSweep},
+        {"expression_batch", expressionBatch},
+        {"snapshot_names", snapshotNames},
+        {"shortest_per_engine", shortestPerEngine},
+    };
+    return list;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const std::string_view filter = argc > 1 ? argv[1] : "";
+    int failures = 0;
+    for (const Check& check : checks()) {
+        if (!filter.empty() && check.name != filter) { continue; }
+        try {
+            check.body();
+            std::printf("%-24s ok\n", check.name.c_str());
+        } catch (const std::exception& error) {
+            std::printf("%-24s FAILED: %s\n", check.name.c_str(), error.what());
+            ++failures;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}